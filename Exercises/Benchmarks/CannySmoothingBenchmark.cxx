@@ -0,0 +1,237 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <itkImage.h>
+#include <itkImageFileReader.h>
+
+#include "itkRecursiveGaussianCannyEdgeDetectionImageFilter.h"
+
+// Discrete against recursive Gaussian smoothing in the Canny edge detector
+// of the exercises, over the variance.
+//
+// The image is a few discs and squares on a gradient with noise, or the
+// image given on the command line. For every variance the report gives the
+// best time of both smoothings over the repetitions, the edge pixels of
+// each, the pixels where the edge maps differ, and the fraction of the
+// edges of each map that lie within one pixel of an edge of the other: the
+// recursive filter approximates the Gaussian, so its edges may move by a
+// pixel where the discrete ones are. The last line gives the variance from
+// which the recursive smoothing is faster.
+
+const unsigned int Dimension = 2;
+typedef float                                   RealPixelType;
+typedef itk::Image< RealPixelType, Dimension >  RealImageType;
+typedef itk::RecursiveGaussianCannyEdgeDetectionImageFilter< RealImageType,
+                                                RealImageType >
+                                                CannyFilterType;
+typedef std::chrono::steady_clock               ClockType;
+
+RealImageType::Pointer makeImage( unsigned int width, unsigned int height )
+{
+  RealImageType::RegionType region;
+  region.SetSize( 0, width );
+  region.SetSize( 1, height );
+  RealImageType::Pointer image = RealImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  unsigned int seed = 12345;
+  RealPixelType * pixel = image->GetBufferPointer();
+  const double side = std::min( width, height ) / 8.0;
+  for( unsigned int y = 0; y < height; ++y )
+    {
+    for( unsigned int x = 0; x < width; ++x )
+      {
+      seed = seed * 1103515245u + 12345u;
+      double value = 100.0 * x / width + 40.0
+        + static_cast< double >( ( seed >> 16 ) % 17 ) - 8.0;
+      // A grid of alternating discs and squares
+      const double cellX = std::fmod( x, 3.0 * side ) - 1.5 * side;
+      const double cellY = std::fmod( y, 3.0 * side ) - 1.5 * side;
+      const bool disc = ( static_cast< unsigned int >( x / ( 3.0 * side ) ) +
+                          static_cast< unsigned int >( y / ( 3.0 * side ) ) ) % 2 == 0;
+      if( disc ? cellX * cellX + cellY * cellY < side * side
+               : std::fabs( cellX ) < side && std::fabs( cellY ) < side )
+        {
+        value += 80.0;
+        }
+      *pixel++ = static_cast< RealPixelType >( value );
+      }
+    }
+  return image;
+}
+
+// Best time over the repetitions, and the edge map of the last run
+double runCanny( const RealImageType * image, double variance, bool recursive,
+                 unsigned int repetitions, std::vector< unsigned char > & edges )
+{
+  CannyFilterType::Pointer canny = CannyFilterType::New();
+  canny->SetVariance( variance );
+  canny->SetLowerThreshold( 1 );
+  canny->SetUpperThreshold( 8 );
+  canny->SetUseRecursiveGaussian( recursive );
+  canny->SetInput( image );
+
+  double best = 0.0;
+  for( unsigned int r = 0; r < repetitions; ++r )
+    {
+    canny->Modified();
+    const ClockType::time_point start = ClockType::now();
+    canny->Update();
+    const std::chrono::duration< double > elapsed = ClockType::now() - start;
+    best = r == 0 ? elapsed.count() : std::min( best, elapsed.count() );
+    }
+
+  const RealPixelType * pixel = canny->GetOutput()->GetBufferPointer();
+  edges.resize( image->GetBufferedRegion().GetNumberOfPixels() );
+  for( size_t i = 0; i < edges.size(); ++i )
+    {
+    edges[i] = pixel[i] != 0;
+    }
+  return best;
+}
+
+// Edges of a lying within one pixel of an edge of b
+size_t edgesNear( const std::vector< unsigned char > & a,
+                  const std::vector< unsigned char > & b,
+                  unsigned int width, unsigned int height )
+{
+  size_t count = 0;
+  for( unsigned int y = 0; y < height; ++y )
+    {
+    for( unsigned int x = 0; x < width; ++x )
+      {
+      if( !a[y * width + x] )
+        {
+        continue;
+        }
+      bool near = false;
+      for( unsigned int ny = y > 0 ? y - 1 : 0;
+           !near && ny <= std::min( y + 1, height - 1 ); ++ny )
+        {
+        for( unsigned int nx = x > 0 ? x - 1 : 0;
+             !near && nx <= std::min( x + 1, width - 1 ); ++nx )
+          {
+          near = b[ny * width + nx] != 0;
+          }
+        }
+      count += near;
+      }
+    }
+  return count;
+}
+
+int main( int argc, char ** argv )
+{
+  const unsigned int repetitions = argc > 1 ? std::max( 1, std::atoi( argv[1] ) ) : 5;
+  unsigned int width = 640;
+  unsigned int height = 480;
+
+  RealImageType::Pointer image;
+  if( argc > 2 )
+    {
+    typedef itk::ImageFileReader< RealImageType > ReaderType;
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName( argv[2] );
+    try
+      {
+      reader->Update();
+      }
+    catch( itk::ExceptionObject & excp )
+      {
+      std::cerr << excp << std::endl;
+      return EXIT_FAILURE;
+      }
+    image = reader->GetOutput();
+    width = image->GetBufferedRegion().GetSize( 0 );
+    height = image->GetBufferedRegion().GetSize( 1 );
+    }
+  else
+    {
+    image = makeImage( width, height );
+    }
+
+  std::cout << width << "x" << height << ( argc > 2 ? " (image)" : " (synthetic)" )
+            << ", best of " << repetitions << " runs" << std::endl;
+  std::cout << "variance  discrete ms  recursive ms  edges d/r  differ"
+            << "  d near r  r near d" << std::endl;
+
+  const double variances[] = { 0.5, 1, 2, 4, 6, 9, 16, 25, 36, 64, 100 };
+  const size_t numberOfVariances = sizeof( variances ) / sizeof( variances[0] );
+  double crossover = -1.0;
+  std::vector< unsigned char > discreteEdges;
+  std::vector< unsigned char > recursiveEdges;
+  for( size_t v = 0; v < numberOfVariances; ++v )
+    {
+    const double variance = variances[v];
+    const double discreteSeconds =
+      runCanny( image, variance, false, repetitions, discreteEdges );
+    const double recursiveSeconds =
+      runCanny( image, variance, true, repetitions, recursiveEdges );
+
+    size_t discreteCount = 0;
+    size_t recursiveCount = 0;
+    size_t differ = 0;
+    for( size_t i = 0; i < discreteEdges.size(); ++i )
+      {
+      discreteCount += discreteEdges[i];
+      recursiveCount += recursiveEdges[i];
+      differ += discreteEdges[i] != recursiveEdges[i];
+      }
+    const size_t discreteNear =
+      edgesNear( discreteEdges, recursiveEdges, width, height );
+    const size_t recursiveNear =
+      edgesNear( recursiveEdges, discreteEdges, width, height );
+
+    if( crossover < 0.0 && recursiveSeconds < discreteSeconds )
+      {
+      crossover = variance;
+      }
+
+    std::cout << std::fixed << std::setprecision( 1 )
+              << std::setw( 8 ) << variance
+              << std::setprecision( 2 )
+              << std::setw( 13 ) << 1000.0 * discreteSeconds
+              << std::setw( 14 ) << 1000.0 * recursiveSeconds
+              << std::setw( 6 ) << discreteCount << "/" << recursiveCount
+              << std::setw( 8 ) << differ
+              << std::setprecision( 1 )
+              << std::setw( 9 ) << ( discreteCount ? 100.0 * discreteNear / discreteCount : 100.0 ) << "%"
+              << std::setw( 9 ) << ( recursiveCount ? 100.0 * recursiveNear / recursiveCount : 100.0 ) << "%"
+              << std::endl;
+    }
+
+  if( crossover < 0.0 )
+    {
+    std::cout << "the discrete smoothing is faster at every variance" << std::endl;
+    }
+  else
+    {
+    std::cout << "the recursive smoothing is faster from variance "
+              << crossover << " on" << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
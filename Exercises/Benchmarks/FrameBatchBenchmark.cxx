@@ -0,0 +1,167 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include <itkImage.h>
+#include <itkOpenCVImageBridge.h>
+
+#include "FrameBatch.h"
+#include "ThreadBudget.h"
+
+// Conversion of a chunk of frames between OpenCV and ITK, frame by frame
+// with itk::OpenCVImageBridge against bridge::FrameBatch.
+//
+// The chunk is a group of pictures of BGR frames, as captured. The frame
+// by frame conversion bridges every frame into a new ITK image and copies
+// the images into a new volume, then bridges them back into new Mats. The
+// batch converts the chunk into a volume allocated once for all the chunks,
+// grafts it into a VideoStream, and copies it back into reused Mats. Both
+// give the same pixels; the report gives the time per chunk of each.
+
+typedef unsigned char                           PixelType;
+typedef bridge::FrameBatch< PixelType >         BatchType;
+typedef BatchType::FrameType                    FrameType;
+typedef BatchType::VolumeType                   VolumeType;
+typedef BatchType::VideoStreamType              VideoStreamType;
+typedef itk::OpenCVImageBridge                  BridgeType;
+typedef std::chrono::steady_clock               ClockType;
+
+double secondsSince( ClockType::time_point start )
+{
+  const std::chrono::duration< double > elapsed = ClockType::now() - start;
+  return elapsed.count();
+}
+
+int main( int argc, char ** argv )
+{
+  const size_t numberOfFrames = argc > 1 ? std::atoi( argv[1] ) : 250;
+  const int width = argc > 2 ? std::atoi( argv[2] ) : 1280;
+  const int height = argc > 3 ? std::atoi( argv[3] ) : 720;
+  const unsigned int numberOfChunks = argc > 4 ? std::atoi( argv[4] ) : 4;
+
+  bridge::ThreadBudget budget;
+  budget.Apply();
+
+  std::vector< cv::Mat > captured( numberOfFrames );
+  cv::RNG rng( 12345 );
+  for( size_t i = 0; i < numberOfFrames; ++i )
+    {
+    captured[i].create( height, width, CV_8UC3 );
+    rng.fill( captured[i], cv::RNG::UNIFORM, 0, 256 );
+    }
+
+  // Frame by frame
+  double toVolumeSeconds = 0.0;
+  double toMatsSeconds = 0.0;
+  VolumeType::Pointer handVolume;
+  std::vector< cv::Mat > handMats;
+  for( unsigned int c = 0; c < numberOfChunks; ++c )
+    {
+    ClockType::time_point start = ClockType::now();
+    std::vector< FrameType::Pointer > frames( numberOfFrames );
+    for( size_t i = 0; i < numberOfFrames; ++i )
+      {
+      frames[i] = BridgeType::CVMatToITKImage< FrameType >( captured[i] );
+      }
+    VolumeType::RegionType region;
+    region.SetSize( 0, width );
+    region.SetSize( 1, height );
+    region.SetSize( 2, numberOfFrames );
+    handVolume = VolumeType::New();
+    handVolume->SetRegions( region );
+    handVolume->Allocate();
+    const size_t framePixels = static_cast< size_t >( width ) * height;
+    for( size_t i = 0; i < numberOfFrames; ++i )
+      {
+      std::memcpy( handVolume->GetBufferPointer() + i * framePixels,
+                   frames[i]->GetBufferPointer(), framePixels );
+      }
+    toVolumeSeconds += secondsSince( start );
+
+    start = ClockType::now();
+    handMats.clear();
+    for( size_t i = 0; i < numberOfFrames; ++i )
+      {
+      handMats.push_back( BridgeType::ITKImageToCVMat< FrameType >( frames[i], true ) );
+      }
+    toMatsSeconds += secondsSince( start );
+    }
+
+  // Batch
+  double batchToVolumeSeconds = 0.0;
+  double batchToMatsSeconds = 0.0;
+  BatchType batch;
+  VideoStreamType::Pointer stream = VideoStreamType::New();
+  std::vector< cv::Mat > batchMats;
+  try
+    {
+    for( unsigned int c = 0; c < numberOfChunks; ++c )
+      {
+      ClockType::time_point start = ClockType::now();
+      batch.Import( captured );
+      batch.GraftToVideoStream( stream );
+      batchToVolumeSeconds += secondsSince( start );
+
+      start = ClockType::now();
+      batch.Export( batchMats );
+      batchToMatsSeconds += secondsSince( start );
+      }
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Same pixels in the volumes, the Mats and the video stream
+  const size_t volumeBytes = numberOfFrames * width * height;
+  bool same = std::memcmp( handVolume->GetBufferPointer(),
+                           batch.GetVolume()->GetBufferPointer(), volumeBytes ) == 0;
+  std::vector< cv::Mat > streamMats;
+  BatchType::ExportVideoStream( stream, streamMats );
+  for( size_t i = 0; same && i < numberOfFrames; ++i )
+    {
+    same = cv::countNonZero( handMats[i] != batchMats[i] ) == 0 &&
+           cv::countNonZero( handMats[i] != streamMats[i] ) == 0;
+    }
+
+  budget.Report( std::cout );
+  std::cout << numberOfChunks << " chunks of " << numberOfFrames << " frames of "
+            << width << "x" << height << std::endl;
+  std::cout << std::fixed << std::setprecision( 2 )
+            << "Mats to volume: frame by frame "
+            << 1000.0 * toVolumeSeconds / numberOfChunks << " ms, batch "
+            << 1000.0 * batchToVolumeSeconds / numberOfChunks << " ms per chunk"
+            << std::endl;
+  std::cout << "volume to Mats: frame by frame "
+            << 1000.0 * toMatsSeconds / numberOfChunks << " ms, batch "
+            << 1000.0 * batchToMatsSeconds / numberOfChunks << " ms per chunk"
+            << std::endl;
+  std::cout << "batch volume allocations: " << batch.GetNumberOfAllocations()
+            << std::endl;
+  std::cout << ( same ? "same pixels" : "the pixels differ" ) << std::endl;
+
+  return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
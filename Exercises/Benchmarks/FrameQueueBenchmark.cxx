@@ -0,0 +1,194 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "BoundedFrameQueue.h"
+#include "SpscFrameRing.h"
+
+// Hand-off latency between a capture thread and a processing thread, with
+// the lock-free SpscFrameRing and with the mutex/condition variable based
+// BoundedFrameQueue.
+//
+// The producer stamps each frame just before handing it over and the
+// consumer measures the delay when it gets it. With a pacing interval the
+// queue is almost always empty, so the figures are the cost of the hand-off
+// itself (the consumer waiting, being woken up, taking the frame). Without
+// pacing the run measures the throughput.
+
+typedef std::chrono::steady_clock ClockType;
+
+struct TimedFrame
+{
+  cv::Mat               Image;
+  ClockType::time_point Sent;
+};
+
+// The ring exchanges frames, the locked queue copies their headers
+bool pushFrame( bridge::SpscFrameRing< TimedFrame > & ring, TimedFrame & frame )
+{
+  return ring.Push( frame );
+}
+
+bool popFrame( bridge::SpscFrameRing< TimedFrame > & ring, TimedFrame & frame )
+{
+  return ring.Pop( frame );
+}
+
+bool pushFrame( bridge::BoundedFrameQueue< TimedFrame > & queue, TimedFrame & frame )
+{
+  return queue.Push( frame );
+}
+
+bool popFrame( bridge::BoundedFrameQueue< TimedFrame > & queue, TimedFrame & frame )
+{
+  return queue.Pop( frame );
+}
+
+struct Result
+{
+  std::vector< double > LatenciesInUs;
+  double                Seconds;
+};
+
+template< typename TQueue >
+Result run( TQueue & queue, unsigned int numberOfFrames,
+            std::chrono::microseconds interval, cv::Size frameSize )
+{
+  Result result;
+  result.LatenciesInUs.reserve( numberOfFrames );
+
+  ClockType::time_point start = ClockType::now();
+  std::thread producer( [&]()
+    {
+    TimedFrame frame;
+    for( unsigned int i = 0; i < numberOfFrames; ++i )
+      {
+      if( frame.Image.empty() )
+        {
+        frame.Image.create( frameSize, CV_8UC1 );
+        }
+      frame.Image.data[0] = static_cast< unsigned char >( i );
+
+      ClockType::time_point sent = ClockType::now();
+      frame.Sent = sent;
+      if( !pushFrame( queue, frame ) )
+        {
+        break;
+        }
+
+      // Busy wait: sleeping would add the scheduler latency to the pacing
+      while( ClockType::now() - sent < interval )
+        {
+        }
+      }
+    queue.Close();
+    } );
+
+  TimedFrame frame;
+  while( popFrame( queue, frame ) )
+    {
+    std::chrono::duration< double, std::micro > latency =
+      ClockType::now() - frame.Sent;
+    result.LatenciesInUs.push_back( latency.count() );
+    }
+  producer.join();
+
+  std::chrono::duration< double > seconds = ClockType::now() - start;
+  result.Seconds = seconds.count();
+  std::sort( result.LatenciesInUs.begin(), result.LatenciesInUs.end() );
+  return result;
+}
+
+double percentile( const std::vector< double > & sorted, double p )
+{
+  if( sorted.empty() )
+    {
+    return 0.0;
+    }
+  size_t index = static_cast< size_t >( p / 100.0 * ( sorted.size() - 1 ) + 0.5 );
+  return sorted[index];
+}
+
+void report( const std::string & name, const Result & result )
+{
+  const std::vector< double > & latencies = result.LatenciesInUs;
+  double mean = 0.0;
+  for( size_t i = 0; i < latencies.size(); ++i )
+    {
+    mean += latencies[i];
+    }
+  mean /= std::max< size_t >( latencies.size(), 1 );
+
+  std::cout << std::left << std::setw( 22 ) << name << std::right
+            << std::fixed << std::setprecision( 2 )
+            << std::setw( 10 ) << mean
+            << std::setw( 10 ) << percentile( latencies, 50 )
+            << std::setw( 10 ) << percentile( latencies, 99 )
+            << std::setw( 10 ) << percentile( latencies, 99.9 )
+            << std::setw( 12 ) << ( latencies.empty() ? 0.0 : latencies.back() )
+            << std::setw( 14 ) << std::setprecision( 0 )
+            << latencies.size() / result.Seconds << std::endl;
+}
+
+int main( int argc, char ** argv )
+{
+  const unsigned int numberOfFrames = argc > 1 ? std::atoi( argv[1] ) : 20000;
+  const std::chrono::microseconds interval( argc > 2 ? std::atoi( argv[2] ) : 50 );
+  const size_t capacity = argc > 3 ? std::atoi( argv[3] ) : 4;
+  const cv::Size frameSize( 640, 480 );
+
+  std::cout << numberOfFrames << " frames, one every " << interval.count()
+            << " us, queue capacity " << capacity << std::endl;
+  std::cout << std::left << std::setw( 22 ) << "queue" << std::right
+            << std::setw( 10 ) << "mean us"
+            << std::setw( 10 ) << "p50 us"
+            << std::setw( 10 ) << "p99 us"
+            << std::setw( 10 ) << "p99.9 us"
+            << std::setw( 12 ) << "max us"
+            << std::setw( 14 ) << "frames/s" << std::endl;
+
+  for( unsigned int pass = 0; pass < 2; ++pass )
+    {
+    // The first pass is paced and measures latency, the second one is not
+    // and measures throughput
+    const std::chrono::microseconds passInterval =
+      pass == 0 ? interval : std::chrono::microseconds( 0 );
+    const std::string suffix = pass == 0 ? "" : " (unpaced)";
+    {
+    bridge::SpscFrameRing< TimedFrame > ring( capacity );
+    report( "SpscFrameRing" + suffix,
+            run( ring, numberOfFrames, passInterval, frameSize ) );
+    }
+    {
+    bridge::BoundedFrameQueue< TimedFrame > queue( capacity );
+    report( "BoundedFrameQueue" + suffix,
+            run( queue, numberOfFrames, passInterval, frameSize ) );
+    }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,267 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <itkImage.h>
+#include <itkVideoStream.h>
+#include <itkCastImageFilter.h>
+#include <itkThresholdImageFilter.h>
+#include <itkImageFilterToVideoFilterWrapper.h>
+#include <itkFrameDifferenceVideoFilter.h>
+
+#include "itkFrameProviderVideoSource.h"
+#include "itkCastFrameDifferenceThresholdVideoFilter.h"
+
+// Time per frame of CastFrameDifferenceThresholdVideoFilter against the
+// Cast -> FrameDifference -> Threshold chain it replaces in
+// ITKVideoMultiFrameFiltersFused, at 1920x1080 (or the size on the command
+// line). Both are first checked to write the same frames on small frames,
+// for frame offsets of 1 and 2, in order and with seeks that make the
+// fused filter fill its history again.
+//
+// The float frames stand for the CurvatureFlow output: a noisy gradient
+// crossed by a bar, so that some squared differences fall below the
+// threshold and some do not.
+
+const unsigned int Dimension = 2;
+typedef unsigned char                         IOPixelType;
+typedef float                                 RealPixelType;
+typedef itk::Image< IOPixelType, Dimension >  IOFrameType;
+typedef itk::Image< RealPixelType, Dimension >
+                                              RealFrameType;
+typedef itk::VideoStream< IOFrameType >       IOVideoType;
+typedef itk::VideoStream< RealFrameType >     RealVideoType;
+typedef itk::FrameProviderVideoSource< RealVideoType >
+                                              SourceType;
+typedef itk::CastImageFilter< RealFrameType, IOFrameType >
+                                              CastImageFilterType;
+typedef itk::ImageFilterToVideoFilterWrapper< CastImageFilterType >
+                                              CastVideoFilterType;
+typedef itk::FrameDifferenceVideoFilter< IOVideoType, IOVideoType >
+                                              FrameDifferenceFilterType;
+typedef itk::ThresholdImageFilter< IOFrameType >
+                                              ThresholdImageFilterType;
+typedef itk::ImageFilterToVideoFilterWrapper< ThresholdImageFilterType >
+                                              ThresholdVideoFilterType;
+typedef itk::CastFrameDifferenceThresholdVideoFilter< RealVideoType, IOVideoType >
+                                              FusedFilterType;
+typedef std::chrono::steady_clock             ClockType;
+
+const IOPixelType Threshold = 128;
+
+// Every pixel only depends on its position and frame number, so a frame
+// read again is the same frame
+void fillFrame( RealPixelType * pixel, unsigned int width, unsigned int height,
+                itk::SizeValueType frame )
+{
+  const unsigned int bar = static_cast< unsigned int >( ( frame * 7 ) % width );
+  for( unsigned int y = 0; y < height; ++y )
+    {
+    for( unsigned int x = 0; x < width; ++x )
+      {
+      unsigned int hash = ( x * 73856093u ) ^ ( y * 19349663u )
+        ^ ( static_cast< unsigned int >( frame ) * 83492791u );
+      hash = hash * 1103515245u + 12345u;
+      RealPixelType value = 100.0f * y / height + 60.0f
+        + static_cast< RealPixelType >( ( hash >> 16 ) % 3200 ) / 100.0f - 16.0f;
+      if( x >= bar && x < bar + width / 16 )
+        {
+        value = 240.0f;
+        }
+      *pixel++ = value;
+      }
+    }
+}
+
+// The frame source and the output of either pipeline, one frame at a time
+class DifferenceRun
+{
+public:
+  DifferenceRun( unsigned int width, unsigned int height,
+                 itk::SizeValueType numberOfFrames, itk::SizeValueType frameOffset,
+                 bool fused ) :
+    m_Width( width ), m_Height( height )
+  {
+    RealFrameType::RegionType region;
+    region.SetSize( 0, width );
+    region.SetSize( 1, height );
+
+    m_Source = SourceType::New();
+    m_Source->SetFrameRegion( region );
+    m_Source->SetNumberOfFrames( numberOfFrames );
+    m_Source->SetFrameProvider( [this]( itk::SizeValueType frameNumber,
+                                        RealFrameType * frame )
+      {
+      fillFrame( frame->GetBufferPointer(), m_Width, m_Height, frameNumber );
+      return true;
+      } );
+
+    if( fused )
+      {
+      m_Fused = FusedFilterType::New();
+      m_Fused->SetFrameOffset( frameOffset );
+      m_Fused->ThresholdBelow( Threshold );
+      m_Fused->SetInput( m_Source->GetOutput() );
+      m_Output = m_Fused->GetOutput();
+      }
+    else
+      {
+      m_Caster = CastImageFilterType::New();
+      m_Thresh = ThresholdImageFilterType::New();
+      m_Thresh->ThresholdBelow( Threshold );
+      m_Thresh->SetOutsideValue( 0 );
+
+      m_CastVideo = CastVideoFilterType::New();
+      m_FrameDifference = FrameDifferenceFilterType::New();
+      m_ThreshVideo = ThresholdVideoFilterType::New();
+      m_CastVideo->SetImageFilter( m_Caster );
+      m_FrameDifference->SetFrameOffset( frameOffset );
+      m_ThreshVideo->SetImageFilter( m_Thresh );
+
+      m_CastVideo->SetInput( m_Source->GetOutput() );
+      m_FrameDifference->SetInput( m_CastVideo->GetOutput() );
+      m_ThreshVideo->SetInput( m_FrameDifference->GetOutput() );
+      m_Output = m_ThreshVideo->GetOutput();
+      }
+  }
+
+  // The first frame with an output: the chain and the fused filter start
+  // FrameOffset frames after the input
+  itk::SizeValueType GetFirstFrame()
+  {
+    m_Output->UpdateOutputInformation();
+    return m_Output->GetLargestPossibleTemporalRegion().GetFrameStart();
+  }
+
+  const IOFrameType * Process( itk::SizeValueType frameNumber )
+  {
+    itk::TemporalRegion requestedRegion;
+    requestedRegion.SetFrameStart( frameNumber );
+    requestedRegion.SetFrameDuration( 1 );
+    m_Output->SetRequestedTemporalRegion( requestedRegion );
+    m_Output->PropagateRequestedRegion();
+    m_Output->UpdateOutputData();
+    return m_Output->GetFrame( frameNumber );
+  }
+
+private:
+  unsigned int                        m_Width;
+  unsigned int                        m_Height;
+  SourceType::Pointer                 m_Source;
+  CastImageFilterType::Pointer        m_Caster;
+  ThresholdImageFilterType::Pointer   m_Thresh;
+  CastVideoFilterType::Pointer        m_CastVideo;
+  FrameDifferenceFilterType::Pointer  m_FrameDifference;
+  ThresholdVideoFilterType::Pointer   m_ThreshVideo;
+  FusedFilterType::Pointer            m_Fused;
+  IOVideoType *                       m_Output;
+};
+
+// Compares the frames of the chain and of the fused filter, in the order
+// given
+bool sameFrames( itk::SizeValueType frameOffset,
+                 const itk::SizeValueType * frames, unsigned int numberOfFrames )
+{
+  const unsigned int width = 64;
+  const unsigned int height = 48;
+  const itk::SizeValueType inputFrames = 40;
+  DifferenceRun chain( width, height, inputFrames, frameOffset, false );
+  DifferenceRun fused( width, height, inputFrames, frameOffset, true );
+
+  if( chain.GetFirstFrame() != fused.GetFirstFrame() )
+    {
+    std::cerr << "Frame offset " << frameOffset << ": the chain starts at frame "
+              << chain.GetFirstFrame() << ", the fused filter at frame "
+              << fused.GetFirstFrame() << std::endl;
+    return false;
+    }
+
+  for( unsigned int i = 0; i < numberOfFrames; ++i )
+    {
+    const IOFrameType * expected = chain.Process( frames[i] );
+    const IOFrameType * actual = fused.Process( frames[i] );
+    if( std::memcmp( expected->GetBufferPointer(), actual->GetBufferPointer(),
+                     width * height ) != 0 )
+      {
+      std::cerr << "Frame offset " << frameOffset << ", frame " << frames[i]
+                << ": the fused filter differs from the chain" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+int main( int argc, char ** argv )
+{
+  const unsigned int width = argc > 1 ? std::atoi( argv[1] ) : 1920;
+  const unsigned int height = argc > 2 ? std::atoi( argv[2] ) : 1080;
+  const unsigned int numberOfFrames = argc > 3 ? std::atoi( argv[3] ) : 60;
+
+  try
+    {
+    // In order, then seeking backwards and forwards
+    const itk::SizeValueType frameOffsets[] = { 1, 2 };
+    for( unsigned int o = 0; o < 2; ++o )
+      {
+      const itk::SizeValueType offset = frameOffsets[o];
+      itk::SizeValueType inOrder[30];
+      for( unsigned int i = 0; i < 30; ++i )
+        {
+        inOrder[i] = offset + i;
+        }
+      const itk::SizeValueType seeks[] =
+        { offset + 10, offset + 11, offset + 3, offset + 4, offset + 5,
+          offset + 30, offset, offset + 1, 39 };
+      if( !sameFrames( offset, inOrder, 30 ) ||
+          !sameFrames( offset, seeks, sizeof( seeks ) / sizeof( seeks[0] ) ) )
+        {
+        return EXIT_FAILURE;
+        }
+      }
+
+    std::cout << width << "x" << height << ", " << numberOfFrames << " frames"
+              << std::endl;
+    std::cout << "pipeline\tms/frame" << std::endl;
+    const char * names[] = { "chain", "fused" };
+    for( unsigned int p = 0; p < 2; ++p )
+      {
+      DifferenceRun run( width, height, numberOfFrames, 1, p == 1 );
+      itk::SizeValueType f = run.GetFirstFrame();
+      // The first frame reads the frames before it
+      run.Process( f++ );
+      const ClockType::time_point start = ClockType::now();
+      for( ; f < numberOfFrames; ++f )
+        {
+        run.Process( f );
+        }
+      const std::chrono::duration< double > elapsed = ClockType::now() - start;
+      std::cout << names[p] << "\t\t"
+                << 1000.0 * elapsed.count() / ( numberOfFrames - 2 ) << std::endl;
+      }
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
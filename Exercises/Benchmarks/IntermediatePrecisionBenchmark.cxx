@@ -0,0 +1,248 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <itkImage.h>
+#include <itkImageFileReader.h>
+
+#include "itkReducedPrecisionCurvatureFlowImageFilter.h"
+#include "itkIntermediateCastImageFilter.h"
+
+// Accuracy of the Q8.8 fixed point intermediate frames against float, on
+// the CurvatureFlow -> cast -> frame difference -> threshold chain of the
+// ITKVideoPipeline exercises.
+//
+// The frames are a disc moving over a noisy gradient, or shifted copies of
+// the image given on the command line. For each frame the report compares
+// the real values of the intermediate image, the 8-bit cast frames and the
+// thresholded differences of consecutive frames, and gives the time per
+// frame of both chains and the bytes of an intermediate frame.
+
+const unsigned int Dimension = 2;
+typedef unsigned char                           PixelType;
+typedef itk::Image< PixelType, Dimension >      ImageType;
+typedef itk::Image< float, Dimension >          FloatImageType;
+typedef itk::Image< unsigned short, Dimension > FixedImageType;
+typedef std::chrono::steady_clock               ClockType;
+
+// CurvatureFlow and cast, with the intermediate pixel type as a parameter
+template< typename TRealImage >
+class SmoothingChain
+{
+public:
+  typedef itk::ReducedPrecisionCurvatureFlowImageFilter< ImageType, TRealImage >
+                                                             FilterType;
+  typedef itk::IntermediateCastImageFilter< TRealImage, ImageType >
+                                                             CastFilterType;
+  typedef itk::IntermediatePixelTraits< typename TRealImage::PixelType >
+                                                             TraitsType;
+
+  SmoothingChain() : m_Seconds( 0.0 )
+  {
+    m_Filter = FilterType::New();
+    m_Caster = CastFilterType::New();
+    m_Filter->SetTimeStep( 0.5 );
+    m_Filter->SetNumberOfIterations( 20 );
+    m_Caster->SetInput( m_Filter->GetOutput() );
+  }
+
+  // Smooth a frame, return the cast 8-bit frame
+  ImageType::Pointer Process( const ImageType * frame )
+  {
+    ClockType::time_point start = ClockType::now();
+    m_Filter->SetInput( frame );
+    m_Caster->Update();
+    std::chrono::duration< double > elapsed = ClockType::now() - start;
+    m_Seconds += elapsed.count();
+
+    ImageType::Pointer result = m_Caster->GetOutput();
+    result->DisconnectPipeline();
+    return result;
+  }
+
+  // Real value of a pixel of the last intermediate frame
+  double GetRealValue( size_t offset ) const
+  {
+    return TraitsType::ToReal( m_Filter->GetOutput()->GetBufferPointer()[offset] );
+  }
+
+  double GetSeconds() const
+  {
+    return m_Seconds;
+  }
+
+private:
+  typename FilterType::Pointer     m_Filter;
+  typename CastFilterType::Pointer m_Caster;
+  double                           m_Seconds;
+};
+
+// Squared difference thresholded below 128, as in the exercises
+PixelType differenceThreshold( PixelType previous, PixelType current )
+{
+  double difference = static_cast< double >( previous ) - current;
+  difference *= difference;
+  const PixelType value = static_cast< PixelType >( difference );
+  return value < 128 ? 0 : value;
+}
+
+ImageType::Pointer makeFrame( unsigned int width, unsigned int height,
+                              unsigned int frame, unsigned int numberOfFrames,
+                              const ImageType * source, unsigned int & seed )
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, width );
+  region.SetSize( 1, height );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  PixelType * pixel = image->GetBufferPointer();
+  const double cx = width * ( 0.25 + 0.5 * frame / numberOfFrames );
+  const double cy = height * 0.5;
+  const double radius = std::min( width, height ) * 0.25;
+  for( unsigned int y = 0; y < height; ++y )
+    {
+    for( unsigned int x = 0; x < width; ++x )
+      {
+      if( source )
+        {
+        // The source image panned one pixel per frame
+        *pixel++ = source->GetBufferPointer()[y * width + ( x + frame ) % width];
+        continue;
+        }
+      seed = seed * 1103515245u + 12345u;
+      int value = static_cast< int >( 100 * x / width ) + 40
+        + static_cast< int >( ( seed >> 16 ) % 17 ) - 8;
+      if( ( x - cx ) * ( x - cx ) + ( y - cy ) * ( y - cy ) < radius * radius )
+        {
+        value += 100;
+        }
+      *pixel++ = static_cast< PixelType >( value );
+      }
+    }
+  return image;
+}
+
+int main( int argc, char ** argv )
+{
+  const unsigned int numberOfFrames = argc > 1 ? std::atoi( argv[1] ) : 20;
+  unsigned int width = 320;
+  unsigned int height = 240;
+
+  ImageType::Pointer source;
+  if( argc > 2 )
+    {
+    typedef itk::ImageFileReader< ImageType > ReaderType;
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName( argv[2] );
+    try
+      {
+      reader->Update();
+      }
+    catch( itk::ExceptionObject & excp )
+      {
+      std::cerr << excp << std::endl;
+      return EXIT_FAILURE;
+      }
+    source = reader->GetOutput();
+    width = source->GetBufferedRegion().GetSize( 0 );
+    height = source->GetBufferedRegion().GetSize( 1 );
+    }
+
+  SmoothingChain< FloatImageType > floatChain;
+  SmoothingChain< FixedImageType > fixedChain;
+
+  const size_t numberOfPixels = static_cast< size_t >( width ) * height;
+  double maximumRealError = 0.0;
+  double sumSquaredRealError = 0.0;
+  size_t castDifferences = 0;
+  int maximumCastError = 0;
+  size_t thresholdDifferences = 0;
+  size_t thresholdPixels = 0;
+
+  ImageType::Pointer previousFloat;
+  ImageType::Pointer previousFixed;
+  unsigned int seed = 12345;
+  for( unsigned int f = 0; f < numberOfFrames; ++f )
+    {
+    ImageType::Pointer frame =
+      makeFrame( width, height, f, numberOfFrames, source, seed );
+    ImageType::Pointer floatFrame = floatChain.Process( frame );
+    ImageType::Pointer fixedFrame = fixedChain.Process( frame );
+
+    const PixelType * floatPixels = floatFrame->GetBufferPointer();
+    const PixelType * fixedPixels = fixedFrame->GetBufferPointer();
+    for( size_t i = 0; i < numberOfPixels; ++i )
+      {
+      const double realError =
+        std::fabs( floatChain.GetRealValue( i ) - fixedChain.GetRealValue( i ) );
+      maximumRealError = std::max( maximumRealError, realError );
+      sumSquaredRealError += realError * realError;
+
+      const int castError = std::abs( static_cast< int >( floatPixels[i] ) -
+                                      static_cast< int >( fixedPixels[i] ) );
+      if( castError != 0 )
+        {
+        ++castDifferences;
+        maximumCastError = std::max( maximumCastError, castError );
+        }
+
+      if( previousFloat )
+        {
+        const PixelType floatValue = differenceThreshold(
+          previousFloat->GetBufferPointer()[i], floatPixels[i] );
+        const PixelType fixedValue = differenceThreshold(
+          previousFixed->GetBufferPointer()[i], fixedPixels[i] );
+        thresholdPixels += floatValue != 0;
+        thresholdDifferences += floatValue != fixedValue;
+        }
+      }
+    previousFloat = floatFrame;
+    previousFixed = fixedFrame;
+    }
+
+  const double total = static_cast< double >( numberOfPixels ) * numberOfFrames;
+  std::cout << numberOfFrames << " frames of " << width << "x" << height
+            << ( source ? " (image)" : " (synthetic)" ) << std::endl;
+  std::cout << "intermediate frame: " << numberOfPixels * sizeof( float )
+            << " bytes as float, " << numberOfPixels * sizeof( unsigned short )
+            << " bytes as Q8.8" << std::endl;
+  std::cout << std::setprecision( 4 )
+            << "real value error: max " << maximumRealError
+            << ", rms " << std::sqrt( sumSquaredRealError / total )
+            << " (Q8.8 step " << 1.0 / 256 << ")" << std::endl;
+  std::cout << "8-bit cast frames: " << 100.0 * castDifferences / total
+            << " % of the pixels differ, by at most " << maximumCastError
+            << std::endl;
+  std::cout << "thresholded differences: " << thresholdDifferences
+            << " pixels differ, " << thresholdPixels
+            << " pixels above threshold with float" << std::endl;
+  std::cout << "time per frame: float "
+            << 1000.0 * floatChain.GetSeconds() / numberOfFrames << " ms, Q8.8 "
+            << 1000.0 * fixedChain.GetSeconds() / numberOfFrames << " ms"
+            << std::endl;
+
+  return EXIT_SUCCESS;
+}
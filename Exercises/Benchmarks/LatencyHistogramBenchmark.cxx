@@ -0,0 +1,95 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "FrameLatencyMetrics.h"
+
+// Cost of recording into a bridge::LatencyHistogram, which the video
+// executables do three times per frame: the clock reads and the relaxed
+// atomic additions, alone and with threads recording into the same
+// histogram at once.
+//
+// Usage: LatencyHistogramBenchmark [records_per_thread [max_threads]]
+
+typedef bridge::LatencyHistogram::ClockType ClockType;
+
+// Nanoseconds per record with numberOfThreads threads
+double measure( unsigned int numberOfThreads, unsigned int records,
+                bool readClock, bridge::LatencyHistogram & histogram )
+{
+  std::vector< std::thread > threads;
+  const ClockType::time_point start = ClockType::now();
+  for( unsigned int t = 0; t < numberOfThreads; ++t )
+    {
+    threads.push_back( std::thread( [&histogram, records, readClock, t]()
+      {
+      for( unsigned int i = 0; i < records; ++i )
+        {
+        if( readClock )
+          {
+          bridge::ScopedLatency latency( histogram );
+          }
+        else
+          {
+          // Spread over the buckets as frame latencies would be
+          histogram.RecordNanoseconds( ( i * 2654435761u + t ) % 50000000u );
+          }
+        }
+      } ) );
+    }
+  for( size_t t = 0; t < threads.size(); ++t )
+    {
+    threads[t].join();
+    }
+  const std::chrono::duration< double, std::nano > elapsed =
+    ClockType::now() - start;
+  return elapsed.count() / records;
+}
+
+int main( int argc, char ** argv )
+{
+  const unsigned int records = argc > 1 ? std::atoi( argv[1] ) : 10000000;
+  const unsigned int maxThreads = argc > 2 ? std::atoi( argv[2] ) :
+    std::max( 1u, std::thread::hardware_concurrency() );
+
+  std::cout << records << " records per thread" << std::endl;
+  std::cout << std::setw( 8 ) << "threads" << std::setw( 16 ) << "record (ns)"
+            << std::setw( 24 ) << "clock + record (ns)" << std::endl;
+  for( unsigned int threads = 1; threads <= maxThreads; threads *= 2 )
+    {
+    bridge::LatencyHistogram histogram;
+    const double record = measure( threads, records, false, histogram );
+    const double scoped = measure( threads, records, true, histogram );
+    if( histogram.GetSnapshot().GetCount() != 2ull * threads * records )
+      {
+      std::cerr << "Records were lost" << std::endl;
+      return EXIT_FAILURE;
+      }
+    std::cout << std::setw( 8 ) << threads << std::fixed << std::setprecision( 1 )
+              << std::setw( 16 ) << record << std::setw( 24 ) << scoped
+              << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <itkImage.h>
+#include <itkOpenCVImageBridge.h>
+
+#include "RegionBridge.h"
+
+// Conversion of regions of interest of a frame between OpenCV and ITK.
+//
+// The clone path does what itk::OpenCVImageBridge needs: clone the ROI
+// view into a dense Mat, bridge it into a new ITK image, bridge the image
+// back into a new Mat and copy it, in color, into the ROI of the output
+// frame. The region path reads the ROI rows straight into a reused aligned
+// ITK image and writes the image straight into the ROI of the output. Both
+// give the same frames; the report gives the time per ROI of each path and
+// the alignment of the ITK buffers.
+
+typedef unsigned char                           PixelType;
+typedef itk::Image< PixelType, 2 >              ImageType;
+typedef itk::OpenCVImageBridge                  BridgeType;
+typedef std::chrono::steady_clock               ClockType;
+
+double secondsSince( ClockType::time_point start )
+{
+  const std::chrono::duration< double > elapsed = ClockType::now() - start;
+  return elapsed.count();
+}
+
+int main( int argc, char ** argv )
+{
+  const int roiSide = argc > 1 ? std::atoi( argv[1] ) : 200;
+  const unsigned int numberOfRegions = argc > 2 ? std::atoi( argv[2] ) : 1000;
+  const int width = argc > 3 ? std::atoi( argv[3] ) : 1920;
+  const int height = argc > 4 ? std::atoi( argv[4] ) : 1080;
+
+  cv::Mat frame( height, width, CV_8UC3 );
+  cv::RNG rng( 12345 );
+  rng.fill( frame, cv::RNG::UNIFORM, 0, 256 );
+
+  // Odd positions, so that the ROI rows are never aligned in the frame
+  std::vector< cv::Rect > regions( numberOfRegions );
+  for( unsigned int r = 0; r < numberOfRegions; ++r )
+    {
+    regions[r] = cv::Rect( rng.uniform( 0, width - roiSide ) | 1,
+                           rng.uniform( 0, height - roiSide ),
+                           roiSide, roiSide );
+    }
+
+  cv::Mat cloneOutput = cv::Mat::zeros( height, width, CV_8UC3 );
+  cv::Mat regionOutput = cv::Mat::zeros( height, width, CV_8UC3 );
+  double cloneSeconds = 0.0;
+  double regionSeconds = 0.0;
+  size_t alignedBuffers = 0;
+  try
+    {
+    ClockType::time_point start = ClockType::now();
+    for( unsigned int r = 0; r < numberOfRegions; ++r )
+      {
+      cv::Mat dense = frame( regions[r] ).clone();
+      ImageType::Pointer image = BridgeType::CVMatToITKImage< ImageType >( dense );
+      cv::Mat gray = BridgeType::ITKImageToCVMat< ImageType >( image, true );
+      cv::Mat color;
+      cv::cvtColor( gray, color, CV_GRAY2BGR );
+      color.copyTo( cloneOutput( regions[r] ) );
+      }
+    cloneSeconds = secondsSince( start );
+
+    ImageType::Pointer image = ImageType::New();
+    start = ClockType::now();
+    for( unsigned int r = 0; r < numberOfRegions; ++r )
+      {
+      bridge::MatRegionToITKImage( frame, regions[r], image.GetPointer() );
+      bridge::ITKImageToMatRegion( image.GetPointer(), regionOutput, regions[r] );
+      alignedBuffers += reinterpret_cast< size_t >( image->GetBufferPointer() ) %
+                        bridge::BufferAlignment == 0;
+      }
+    regionSeconds = secondsSince( start );
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const bool same = cv::norm( cloneOutput, regionOutput, cv::NORM_INF ) == 0;
+  std::cout << numberOfRegions << " regions of " << roiSide << "x" << roiSide
+            << " in a " << width << "x" << height << " color frame" << std::endl;
+  std::cout << std::fixed << std::setprecision( 2 )
+            << "clone and bridge: " << 1e6 * cloneSeconds / numberOfRegions
+            << " us per region" << std::endl;
+  std::cout << "region bridge:    " << 1e6 * regionSeconds / numberOfRegions
+            << " us per region, " << alignedBuffers << " of "
+            << numberOfRegions << " ITK buffers " << bridge::BufferAlignment
+            << "-byte aligned" << std::endl;
+  std::cout << ( same ? "same frames" : "the frames differ" ) << std::endl;
+
+  return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,200 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <itkImage.h>
+#include <itkCastImageFilter.h>
+#include <itkCannyEdgeDetectionImageFilter.h>
+#include <itkRescaleIntensityImageFilter.h>
+#include <itkMultiThreader.h>
+
+#include "StaticFrameStages.h"
+
+// Per-frame cost of the cast -> Canny -> rescale chain built the usual way,
+// with SmartPointer-connected filters updated for every frame, and as a
+// StaticFramePipeline. On small frames the filters have little work to do,
+// so the difference is mostly the pipeline overhead: modified-time
+// propagation, region negotiation and output allocation checks for every
+// stage.
+//
+// Both chains run on the same frames first and their outputs are compared
+// pixel for pixel; the benchmark fails if they differ.
+
+typedef unsigned char                                  PixelType;
+typedef float                                          RealPixelType;
+typedef itk::Image< PixelType, 2 >                     ImageType;
+typedef itk::Image< RealPixelType, 2 >                 RealImageType;
+typedef itk::CastImageFilter< ImageType, RealImageType >
+                                                       CastFilterType;
+typedef itk::CannyEdgeDetectionImageFilter< RealImageType, RealImageType >
+                                                       CannyFilterType;
+typedef itk::RescaleIntensityImageFilter< RealImageType, ImageType >
+                                                       RescaleFilterType;
+typedef bridge::StaticCannyPipelineType                StaticPipelineType;
+typedef std::chrono::steady_clock                      ClockType;
+
+// The dynamic chain of CannyFrameProcessor
+class DynamicChain
+{
+public:
+  DynamicChain()
+  {
+    m_Caster = CastFilterType::New();
+    m_Canny = CannyFilterType::New();
+    m_Rescaler = RescaleFilterType::New();
+    m_Canny->SetInput( m_Caster->GetOutput() );
+    m_Rescaler->SetInput( m_Canny->GetOutput() );
+    m_Canny->SetVariance( 6 );
+    m_Canny->SetLowerThreshold( 1 );
+    m_Canny->SetUpperThreshold( 8 );
+  }
+
+  const ImageType * Process( const ImageType * frame )
+  {
+    m_Caster->SetInput( frame );
+    m_Rescaler->Update();
+    return m_Rescaler->GetOutput();
+  }
+
+private:
+  CastFilterType::Pointer    m_Caster;
+  CannyFilterType::Pointer   m_Canny;
+  RescaleFilterType::Pointer m_Rescaler;
+};
+
+void setUpStaticChain( StaticPipelineType & pipeline )
+{
+  CannyFilterType * canny = pipeline.GetStage< 1 >().GetFilter();
+  canny->SetVariance( 6 );
+  canny->SetLowerThreshold( 1 );
+  canny->SetUpperThreshold( 8 );
+}
+
+// A bright disc moving over a gradient, with a little noise
+std::vector< ImageType::Pointer > makeFrames( unsigned int width,
+  unsigned int height, unsigned int numberOfFrames )
+{
+  std::vector< ImageType::Pointer > frames;
+  unsigned int seed = 12345;
+  for( unsigned int f = 0; f < numberOfFrames; ++f )
+    {
+    ImageType::RegionType region;
+    region.SetSize( 0, width );
+    region.SetSize( 1, height );
+    ImageType::Pointer frame = ImageType::New();
+    frame->SetRegions( region );
+    frame->Allocate();
+
+    const double cx = width * ( 0.25 + 0.5 * f / numberOfFrames );
+    const double cy = height * 0.5;
+    const double radius = std::min( width, height ) * 0.25;
+    PixelType * pixel = frame->GetBufferPointer();
+    for( unsigned int y = 0; y < height; ++y )
+      {
+      for( unsigned int x = 0; x < width; ++x )
+        {
+        seed = seed * 1103515245u + 12345u;
+        int value = static_cast< int >( 100 * x / width ) + 40
+          + static_cast< int >( ( seed >> 16 ) % 9 ) - 4;
+        if( ( x - cx ) * ( x - cx ) + ( y - cy ) * ( y - cy ) < radius * radius )
+          {
+          value += 100;
+          }
+        *pixel++ = static_cast< PixelType >( value );
+        }
+      }
+    frames.push_back( frame );
+    }
+  return frames;
+}
+
+template< typename TChain >
+double timePerFrameInUs( TChain & chain,
+  const std::vector< ImageType::Pointer > & frames, unsigned int numberOfFrames )
+{
+  ClockType::time_point start = ClockType::now();
+  for( unsigned int i = 0; i < numberOfFrames; ++i )
+    {
+    chain.Process( frames[i % frames.size()] );
+    }
+  std::chrono::duration< double, std::micro > elapsed = ClockType::now() - start;
+  return elapsed.count() / numberOfFrames;
+}
+
+int main( int argc, char ** argv )
+{
+  const unsigned int numberOfFrames = argc > 1 ? std::atoi( argv[1] ) : 500;
+  if( argc > 2 )
+    {
+    itk::MultiThreader::SetGlobalDefaultNumberOfThreads( std::atoi( argv[2] ) );
+    }
+  const unsigned int sizes[][2] = { { 32, 24 }, { 64, 48 }, { 160, 120 }, { 320, 240 } };
+
+  std::cout << numberOfFrames << " frames per size, "
+            << itk::MultiThreader::GetGlobalDefaultNumberOfThreads()
+            << " ITK threads" << std::endl;
+  std::cout << std::setw( 10 ) << "size"
+            << std::setw( 14 ) << "dynamic us"
+            << std::setw( 14 ) << "static us"
+            << std::setw( 14 ) << "saved us"
+            << std::setw( 10 ) << "saved %" << std::endl;
+
+  bool identical = true;
+  for( size_t s = 0; s < sizeof( sizes ) / sizeof( sizes[0] ); ++s )
+    {
+    const unsigned int width = sizes[s][0];
+    const unsigned int height = sizes[s][1];
+    std::vector< ImageType::Pointer > frames = makeFrames( width, height, 16 );
+
+    DynamicChain dynamicChain;
+    StaticPipelineType staticChain;
+    setUpStaticChain( staticChain );
+
+    // Both chains must give the same edges
+    for( size_t i = 0; i < frames.size(); ++i )
+      {
+      const ImageType * expected = dynamicChain.Process( frames[i] );
+      const ImageType * result = staticChain.Process( frames[i] );
+      if( std::memcmp( expected->GetBufferPointer(), result->GetBufferPointer(),
+                       width * height * sizeof( PixelType ) ) != 0 )
+        {
+        std::cerr << "Output mismatch at " << width << "x" << height
+                  << ", frame " << i << std::endl;
+        identical = false;
+        }
+      }
+
+    const double dynamicUs = timePerFrameInUs( dynamicChain, frames, numberOfFrames );
+    const double staticUs = timePerFrameInUs( staticChain, frames, numberOfFrames );
+    std::cout << std::setw( 6 ) << width << "x" << std::left << std::setw( 3 )
+              << height << std::right << std::fixed << std::setprecision( 1 )
+              << std::setw( 14 ) << dynamicUs
+              << std::setw( 14 ) << staticUs
+              << std::setw( 14 ) << dynamicUs - staticUs
+              << std::setw( 10 ) << 100.0 * ( dynamicUs - staticUs ) / dynamicUs
+              << std::endl;
+    }
+
+  return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,247 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <itkImage.h>
+#include <itkVideoStream.h>
+
+#include "itkFrameProviderVideoSource.h"
+#include "itkTemporalMedianVideoFilter.h"
+
+// Time per frame of TemporalMedianVideoFilter against a median that sorts
+// the window of every pixel, at 1920x1080 (or the size on the command line)
+// for windows of 15, 30 and 60 frames. The filter output is first checked
+// against the sorted median on small frames.
+//
+// The frames are a noisy static background crossed by a bright bar, so the
+// median of every pixel mostly stays put and sometimes jumps.
+
+const unsigned int Dimension = 2;
+typedef unsigned char                         PixelType;
+typedef itk::Image< PixelType, Dimension >    FrameType;
+typedef itk::VideoStream< FrameType >         VideoType;
+typedef itk::FrameProviderVideoSource< VideoType >
+                                              SourceType;
+typedef itk::TemporalMedianVideoFilter< VideoType, VideoType >
+                                              MedianFilterType;
+typedef std::chrono::steady_clock             ClockType;
+
+void fillFrame( PixelType * pixel, unsigned int width, unsigned int height,
+                itk::SizeValueType frame, unsigned int & seed )
+{
+  const unsigned int bar = static_cast< unsigned int >( ( frame * 7 ) % width );
+  for( unsigned int y = 0; y < height; ++y )
+    {
+    for( unsigned int x = 0; x < width; ++x )
+      {
+      seed = seed * 1103515245u + 12345u;
+      int value = static_cast< int >( 100 * y / height ) + 60
+        + static_cast< int >( ( seed >> 16 ) % 21 ) - 10;
+      if( x >= bar && x < bar + width / 16 )
+        {
+        value = 240;
+        }
+      *pixel++ = static_cast< PixelType >( value );
+      }
+    }
+}
+
+// The median of the window of every pixel, by partial sorting
+class SortedMedian
+{
+public:
+  SortedMedian( size_t numberOfPixels, unsigned int windowLength ) :
+    m_NumberOfPixels( numberOfPixels ), m_WindowLength( windowLength ),
+    m_NumberOfFrames( 0 ), m_Window( numberOfPixels * windowLength )
+  {}
+
+  void Process( const PixelType * frame, PixelType * median )
+  {
+    const size_t slot = m_NumberOfFrames % m_WindowLength;
+    std::memcpy( &m_Window[slot * m_NumberOfPixels], frame, m_NumberOfPixels );
+    ++m_NumberOfFrames;
+    const unsigned int count =
+      static_cast< unsigned int >( std::min< size_t >( m_NumberOfFrames, m_WindowLength ) );
+
+    std::vector< PixelType > values( count );
+    for( size_t i = 0; i < m_NumberOfPixels; ++i )
+      {
+      for( unsigned int f = 0; f < count; ++f )
+        {
+        values[f] = m_Window[f * m_NumberOfPixels + i];
+        }
+      std::nth_element( values.begin(), values.begin() + ( count - 1 ) / 2,
+                        values.end() );
+      median[i] = values[( count - 1 ) / 2];
+      }
+  }
+
+private:
+  size_t                   m_NumberOfPixels;
+  unsigned int             m_WindowLength;
+  size_t                   m_NumberOfFrames;
+  std::vector< PixelType > m_Window;
+};
+
+// Pulls the frames of a TemporalMedianVideoFilter one at a time
+class MedianRun
+{
+public:
+  MedianRun( unsigned int width, unsigned int height,
+             itk::SizeValueType numberOfFrames, unsigned int windowLength ) :
+    m_Seed( 12345 ), m_Width( width ), m_Height( height )
+  {
+    FrameType::RegionType region;
+    region.SetSize( 0, width );
+    region.SetSize( 1, height );
+
+    m_Source = SourceType::New();
+    m_Source->SetFrameRegion( region );
+    m_Source->SetNumberOfFrames( numberOfFrames );
+    m_Source->SetFrameProvider( [this]( itk::SizeValueType frameNumber,
+                                        FrameType * frame )
+      {
+      fillFrame( frame->GetBufferPointer(), m_Width, m_Height, frameNumber,
+                 m_Seed );
+      return true;
+      } );
+
+    m_Filter = MedianFilterType::New();
+    m_Filter->SetWindowLength( windowLength );
+    m_Filter->SetInput( m_Source->GetOutput() );
+  }
+
+  const FrameType * Process( itk::SizeValueType frameNumber )
+  {
+    itk::TemporalRegion requestedRegion;
+    requestedRegion.SetFrameStart( frameNumber );
+    requestedRegion.SetFrameDuration( 1 );
+    VideoType * output = m_Filter->GetOutput();
+    output->SetRequestedTemporalRegion( requestedRegion );
+    output->PropagateRequestedRegion();
+    output->UpdateOutputData();
+    return output->GetFrame( frameNumber );
+  }
+
+  // The input frame of the last call
+  const FrameType * GetInputFrame( itk::SizeValueType frameNumber ) const
+  {
+    return m_Source->GetOutput()->GetFrame( frameNumber );
+  }
+
+private:
+  unsigned int               m_Seed;
+  unsigned int               m_Width;
+  unsigned int               m_Height;
+  SourceType::Pointer        m_Source;
+  MedianFilterType::Pointer  m_Filter;
+};
+
+int main( int argc, char ** argv )
+{
+  const unsigned int width = argc > 1 ? std::atoi( argv[1] ) : 1920;
+  const unsigned int height = argc > 2 ? std::atoi( argv[2] ) : 1080;
+  const unsigned int numberOfFrames = argc > 3 ? std::atoi( argv[3] ) : 120;
+  const unsigned int sortedFrames = 3;
+  const unsigned int windowLengths[] = { 15, 30, 60 };
+
+  try
+    {
+    // Check against the sorted median on small frames
+    for( unsigned int w = 0; w < 3; ++w )
+      {
+      const unsigned int checkWidth = 64;
+      const unsigned int checkHeight = 48;
+      const unsigned int checkFrames = 3 * windowLengths[w];
+      MedianRun run( checkWidth, checkHeight, checkFrames, windowLengths[w] );
+      SortedMedian sorted( checkWidth * checkHeight, windowLengths[w] );
+      std::vector< PixelType > expected( checkWidth * checkHeight );
+      for( unsigned int f = 0; f < checkFrames; ++f )
+        {
+        const FrameType * median = run.Process( f );
+        sorted.Process( run.GetInputFrame( f )->GetBufferPointer(), &expected[0] );
+        if( std::memcmp( median->GetBufferPointer(), &expected[0],
+                         expected.size() ) != 0 )
+          {
+          std::cerr << "Window " << windowLengths[w] << ", frame " << f
+                    << ": the median differs from the sorted median" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+
+    const size_t numberOfPixels = static_cast< size_t >( width ) * height;
+    std::cout << width << "x" << height << ", " << numberOfFrames << " frames"
+              << ", histograms "
+              << numberOfPixels * sizeof( MedianFilterType::PixelHistogram ) / ( 1 << 20 )
+              << " MB" << std::endl;
+    std::cout << "window\thistogram ms/frame\tsorted ms/frame" << std::endl;
+    for( unsigned int w = 0; w < 3; ++w )
+      {
+      MedianRun run( width, height, numberOfFrames, windowLengths[w] );
+      // The first frames of the window are not representative
+      itk::SizeValueType f = 0;
+      for( ; f < windowLengths[w]; ++f )
+        {
+        run.Process( f );
+        }
+      ClockType::time_point start = ClockType::now();
+      for( ; f < numberOfFrames; ++f )
+        {
+        run.Process( f );
+        }
+      std::chrono::duration< double > histogramTime = ClockType::now() - start;
+      const double histogramFrames =
+        static_cast< double >( numberOfFrames ) - windowLengths[w];
+
+      // The sorted median at full window, on a few frames
+      SortedMedian sorted( numberOfPixels, windowLengths[w] );
+      std::vector< PixelType > frame( numberOfPixels );
+      std::vector< PixelType > median( numberOfPixels );
+      unsigned int seed = 12345;
+      for( unsigned int s = 0; s + 1 < windowLengths[w]; ++s )
+        {
+        fillFrame( &frame[0], width, height, s, seed );
+        sorted.Process( &frame[0], &median[0] );
+        }
+      start = ClockType::now();
+      for( unsigned int s = 0; s < sortedFrames; ++s )
+        {
+        fillFrame( &frame[0], width, height, windowLengths[w] + s, seed );
+        sorted.Process( &frame[0], &median[0] );
+        }
+      std::chrono::duration< double > sortedTime = ClockType::now() - start;
+
+      std::cout << windowLengths[w] << "\t"
+                << 1000.0 * histogramTime.count() / histogramFrames << "\t\t\t"
+                << 1000.0 * sortedTime.count() / sortedFrames << std::endl;
+      }
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
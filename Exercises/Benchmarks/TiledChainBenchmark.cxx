@@ -0,0 +1,185 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <itkImage.h>
+#include <itkMeanImageFilter.h>
+
+#include "itkReducedPrecisionCurvatureFlowImageFilter.h"
+#include "itkIntermediateCastImageFilter.h"
+#include "TiledExecution.h"
+
+// Whole image against cache-sized tiles (see TiledExecution.h) on the
+// filter chains of the exercises, run on a synthetic image:
+//   mean                       (BasicImageFilteringITKAnswer1)
+//   CurvatureFlow -> cast      (the ITKVideoPipeline exercises, 20 fixed
+//                               iterations so the filter runs on tiles)
+// The cast -> Canny -> rescale chain of BasicImageFilteringITKAnswer2 is
+// not tiled: Canny and the rescale are global (see TiledExecution.h). For
+// each chain the report gives the time of both runs and the bytes computed
+// per stage. The benchmark fails if the tiles change a single pixel.
+//
+// Usage: TiledChainBenchmark [width height [cache_bytes]]
+// The default is a 4K image and the L2 cache size.
+
+const unsigned int Dimension = 2;
+typedef unsigned char                      PixelType;
+typedef itk::Image< PixelType, Dimension > ImageType;
+typedef itk::Image< float, Dimension >     FloatImageType;
+typedef std::chrono::steady_clock          ClockType;
+typedef bridge::TiledExecution< ImageType > TiledExecutionType;
+
+ImageType::Pointer makeImage( unsigned int width, unsigned int height )
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, width );
+  region.SetSize( 1, height );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  // Discs on a noisy gradient
+  unsigned int seed = 12345;
+  PixelType * pixel = image->GetBufferPointer();
+  for( unsigned int y = 0; y < height; ++y )
+    {
+    for( unsigned int x = 0; x < width; ++x )
+      {
+      seed = seed * 1103515245u + 12345u;
+      int value = static_cast< int >( 100 * x / width ) + 40
+        + static_cast< int >( ( seed >> 16 ) % 17 ) - 8;
+      const int cx = static_cast< int >( x % 256 ) - 128;
+      const int cy = static_cast< int >( y % 256 ) - 128;
+      if( cx * cx + cy * cy < 80 * 80 )
+        {
+        value += 100;
+        }
+      *pixel++ = static_cast< PixelType >( value );
+      }
+    }
+  return image;
+}
+
+bool sameImage( const ImageType * a, const ImageType * b )
+{
+  if( a->GetBufferedRegion() != b->GetBufferedRegion() )
+    {
+    return false;
+    }
+  const size_t numberOfPixels = a->GetBufferedRegion().GetNumberOfPixels();
+  return std::equal( a->GetBufferPointer(), a->GetBufferPointer() + numberOfPixels,
+                     b->GetBufferPointer() );
+}
+
+// Run the chain ending with last whole, then in tiles, and report. Returns
+// false if the tiled output differs from the whole one.
+template< typename TLastFilter >
+bool compare( const std::string & name, TLastFilter * last,
+              TiledExecutionType & tiled )
+{
+  ClockType::time_point start = ClockType::now();
+  last->Modified();
+  last->Update();
+  std::chrono::duration< double > wholeTime = ClockType::now() - start;
+  ImageType::Pointer whole = last->GetOutput();
+  whole->DisconnectPipeline();
+
+  tiled.SetInput( last->GetOutput() );
+  start = ClockType::now();
+  last->Modified();
+  tiled.Update();
+  std::chrono::duration< double > tiledTime = ClockType::now() - start;
+
+  std::cout << name << ": whole " << std::fixed << std::setprecision( 1 )
+            << 1000.0 * wholeTime.count() << " ms, tiled "
+            << 1000.0 * tiledTime.count() << " ms" << std::endl;
+  tiled.Report( std::cout );
+  std::cout << std::endl;
+
+  if( !sameImage( whole, tiled.GetOutput() ) )
+    {
+    std::cerr << name << ": the tiled output differs from the whole one"
+              << std::endl;
+    return false;
+    }
+  return true;
+}
+
+int main( int argc, char ** argv )
+{
+  const unsigned int width = argc > 2 ? std::atoi( argv[1] ) : 3840;
+  const unsigned int height = argc > 2 ? std::atoi( argv[2] ) : 2160;
+  const itk::SizeValueType cacheBytes = argc > 3 ?
+    std::strtoull( argv[3], 0, 10 ) : TiledExecutionType::L2CacheBytes();
+
+  ImageType::Pointer image = makeImage( width, height );
+  std::cout << width << "x" << height << " image, cache budget "
+            << cacheBytes / 1024 << " KiB" << std::endl << std::endl;
+
+  bool identical = true;
+  try
+    {
+    // mean
+      {
+      typedef itk::MeanImageFilter< ImageType, ImageType > MeanFilterType;
+      MeanFilterType::Pointer mean = MeanFilterType::New();
+      ImageType::SizeType radius;
+      radius.Fill( 2 );
+      mean->SetRadius( radius );
+      mean->SetInput( image );
+
+      TiledExecutionType tiled;
+      tiled.SetCacheBytes( cacheBytes );
+      tiled.AddStage( "mean (8-bit)", mean.GetPointer() );
+      identical &= compare( "mean", mean.GetPointer(), tiled );
+      }
+
+    // CurvatureFlow -> cast
+      {
+      typedef itk::ReducedPrecisionCurvatureFlowImageFilter< ImageType,
+                                                     FloatImageType >
+                                                                FlowFilterType;
+      typedef itk::IntermediateCastImageFilter< FloatImageType, ImageType >
+                                                                CastFilterType;
+      FlowFilterType::Pointer flow = FlowFilterType::New();
+      CastFilterType::Pointer cast = CastFilterType::New();
+      flow->SetInput( image );
+      flow->SetTimeStep( 0.5 );
+      flow->SetNumberOfIterations( 20 );
+      cast->SetInput( flow->GetOutput() );
+
+      TiledExecutionType tiled;
+      tiled.SetCacheBytes( cacheBytes );
+      tiled.AddStage( "curvature flow (float)", flow.GetPointer() );
+      tiled.AddStage( "cast (8-bit)", cast.GetPointer() );
+      identical &= compare( "curvature flow -> cast", cast.GetPointer(), tiled );
+      }
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,121 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __BoundedFrameQueue_h
+#define __BoundedFrameQueue_h
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace bridge
+{
+
+/** \class BoundedFrameQueue
+ * \brief Blocking queue holding at most a fixed number of frames.
+ *
+ * Push() blocks while the queue is full and Pop() blocks while it is
+ * empty, so a producer can never run more than Capacity frames ahead of
+ * its consumer. Close() wakes everybody up: pushes are then discarded and
+ * Pop() returns false once the remaining frames have been drained.
+ */
+template< typename TFrame >
+class BoundedFrameQueue
+{
+public:
+  typedef TFrame FrameType;
+
+  explicit BoundedFrameQueue( size_t capacity ) :
+    m_Capacity( capacity > 0 ? capacity : 1 ),
+    m_Closed( false )
+  {
+  }
+
+  /** Append a frame, waiting for room. Returns false if the queue was
+   * closed before the frame could be added. */
+  bool Push( const FrameType & frame )
+  {
+    std::unique_lock< std::mutex > lock( m_Mutex );
+    m_NotFull.wait( lock,
+      [this] { return m_Closed || m_Frames.size() < m_Capacity; } );
+    if( m_Closed )
+      {
+      return false;
+      }
+    m_Frames.push_back( frame );
+    lock.unlock();
+    m_NotEmpty.notify_one();
+    return true;
+  }
+
+  /** Remove the oldest frame, waiting for one to arrive. Returns false when
+   * the queue is closed and empty. */
+  bool Pop( FrameType & frame )
+  {
+    std::unique_lock< std::mutex > lock( m_Mutex );
+    m_NotEmpty.wait( lock, [this] { return m_Closed || !m_Frames.empty(); } );
+    if( m_Frames.empty() )
+      {
+      return false;
+      }
+    frame = m_Frames.front();
+    m_Frames.pop_front();
+    lock.unlock();
+    m_NotFull.notify_one();
+    return true;
+  }
+
+  /** Stop accepting frames and release all waiting threads */
+  void Close()
+  {
+    {
+    std::lock_guard< std::mutex > lock( m_Mutex );
+    m_Closed = true;
+    }
+    m_NotEmpty.notify_all();
+    m_NotFull.notify_all();
+  }
+
+  /** Drop the remaining frames and accept new ones again */
+  void Reopen()
+  {
+    std::lock_guard< std::mutex > lock( m_Mutex );
+    m_Frames.clear();
+    m_Closed = false;
+  }
+
+  size_t GetCapacity() const
+  {
+    return m_Capacity;
+  }
+
+private:
+  BoundedFrameQueue( const BoundedFrameQueue & ); //purposely not implemented
+  void operator=( const BoundedFrameQueue & );    //purposely not implemented
+
+  const size_t              m_Capacity;
+  bool                      m_Closed;
+  std::deque< FrameType >   m_Frames;
+  std::mutex                m_Mutex;
+  std::condition_variable   m_NotEmpty;
+  std::condition_variable   m_NotFull;
+};
+
+} // end namespace bridge
+
+#endif
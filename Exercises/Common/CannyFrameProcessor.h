@@ -0,0 +1,143 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __CannyFrameProcessor_h
+#define __CannyFrameProcessor_h
+
+#include <opencv2/core/core.hpp>
+
+#include <itkImage.h>
+#include <itkCastImageFilter.h>
+#include <itkRescaleIntensityImageFilter.h>
+
+#include "itkRecursiveGaussianCannyEdgeDetectionImageFilter.h"
+#include "CannySmoothing.h"
+#include "PooledFrameImport.h"
+
+namespace bridge
+{
+
+/** \class CannyFrameProcessor
+ * \brief The bridged cast -> Canny -> rescale edge detector of the video
+ * exercise, set up once and reused for every frame.
+ *
+ * processFrame() in BasicVideoFilteringITKOpenCVBridgeAnswer.cxx builds a
+ * new pipeline and new images for every frame. Here the filters persist,
+ * so ITK reuses their output buffers from one frame to the next, and the
+ * input frame is converted straight into a buffer taken from a
+ * FrameBufferPool. The result is the same 8-bit edge image.
+ * BRIDGE_CANNY_SMOOTHING=recursive selects the recursive Gaussian smoothing
+ * (see CannySmoothing.h).
+ */
+class CannyFrameProcessor
+{
+public:
+  typedef unsigned char                            InputPixelType;
+  typedef float                                    RealPixelType;
+  typedef unsigned char                            OutputPixelType;
+  typedef GrayFrameType                            InputImageType;
+  typedef itk::Image< RealPixelType,   2 >         RealImageType;
+  typedef itk::Image< OutputPixelType, 2 >         OutputImageType;
+  typedef itk::CastImageFilter< InputImageType, RealImageType >
+                                                   CastFilterType;
+  typedef itk::RecursiveGaussianCannyEdgeDetectionImageFilter< RealImageType,
+                                                   RealImageType >
+                                                   FilterType;
+  typedef itk::RescaleIntensityImageFilter< RealImageType, OutputImageType >
+                                                   RescaleFilterType;
+  typedef GrayFramePoolType                        PoolType;
+
+  CannyFrameProcessor()
+  {
+    m_Caster = CastFilterType::New();
+    m_Canny = FilterType::New();
+    m_Rescaler = RescaleFilterType::New();
+    m_FramePool = PoolType::New();
+
+    m_Canny->SetInput( m_Caster->GetOutput() );
+    m_Rescaler->SetInput( m_Canny->GetOutput() );
+
+    this->SetVariance( 6 );
+    this->SetLowerThreshold( 1 );
+    this->SetUpperThreshold( 8 );
+    this->SetUseRecursiveGaussian( UseRecursiveCannySmoothing() );
+  }
+
+  void SetVariance( double variance )
+  {
+    m_Canny->SetVariance( variance );
+  }
+
+  void SetLowerThreshold( double threshold )
+  {
+    m_Canny->SetLowerThreshold( threshold );
+  }
+
+  void SetUpperThreshold( double threshold )
+  {
+    m_Canny->SetUpperThreshold( threshold );
+  }
+
+  /** Smooth with the recursive Gaussian filter, whose cost does not
+   * depend on the variance */
+  void SetUseRecursiveGaussian( bool useRecursiveGaussian )
+  {
+    m_Canny->SetUseRecursiveGaussian( useRecursiveGaussian );
+  }
+
+  /** Pool providing the ITK input frames */
+  PoolType * GetFramePool()
+  {
+    return m_FramePool;
+  }
+
+  /** Process a frame. The output Mat is reused when it already has the
+   * right size and type. */
+  void Process( const cv::Mat & inputImage, cv::Mat & outputImage )
+  {
+    InputImageType::Pointer itkFrame =
+      ImportGrayFrame( inputImage, m_FramePool );
+
+    m_Caster->SetInput( itkFrame );
+    m_Rescaler->Update();
+
+    // Drop the reference held by the caster so the frame returns to the pool
+    m_Caster->SetInput( NULL );
+
+    const OutputImageType * result = m_Rescaler->GetOutput();
+    cv::Mat resultView( inputImage.rows, inputImage.cols, CV_8UC1,
+      const_cast< OutputPixelType * >( result->GetBufferPointer() ) );
+    resultView.copyTo( outputImage );
+  }
+
+  cv::Mat Process( const cv::Mat & inputImage )
+  {
+    cv::Mat outputImage;
+    this->Process( inputImage, outputImage );
+    return outputImage;
+  }
+
+private:
+  CastFilterType::Pointer    m_Caster;
+  FilterType::Pointer        m_Canny;
+  RescaleFilterType::Pointer m_Rescaler;
+  PoolType::Pointer          m_FramePool;
+};
+
+} // end namespace bridge
+
+#endif
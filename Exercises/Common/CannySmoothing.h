@@ -0,0 +1,40 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __CannySmoothing_h
+#define __CannySmoothing_h
+
+#include <cstdlib>
+#include <cstring>
+
+namespace bridge
+{
+
+/** Whether the Canny edge detectors of the exercises smooth with the
+ * recursive Gaussian filter instead of the discrete one (see
+ * itkRecursiveGaussianCannyEdgeDetectionImageFilter.h). It is selected with
+ * BRIDGE_CANNY_SMOOTHING=recursive, so the command lines of the exercises
+ * do not change; the default is the discrete smoothing. */
+inline bool UseRecursiveCannySmoothing()
+{
+  const char * smoothing = std::getenv( "BRIDGE_CANNY_SMOOTHING" );
+  return smoothing && std::strcmp( smoothing, "recursive" ) == 0;
+}
+
+} // end namespace bridge
+
+#endif
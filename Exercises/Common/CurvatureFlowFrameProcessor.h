@@ -0,0 +1,109 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __CurvatureFlowFrameProcessor_h
+#define __CurvatureFlowFrameProcessor_h
+
+#include <opencv2/core/core.hpp>
+
+#include <itkImage.h>
+#include <itkCurvatureFlowImageFilter.h>
+
+#include "PooledFrameImport.h"
+
+namespace bridge
+{
+
+/** \class CurvatureFlowFrameProcessor
+ * \brief The CurvatureFlow smoothing of the bridge exercise 1, applied to
+ * video frames.
+ *
+ * Same settings as BasicFilteringITKOpenCVBridgeAnswer.cxx (time step 0.5,
+ * 20 iterations). The filter persists from one frame to the next and the
+ * input frames come from a FrameBufferPool. The float result is converted
+ * to 8 bits with cv::Mat::convertTo(), as the exercise does for display.
+ */
+class CurvatureFlowFrameProcessor
+{
+public:
+  typedef unsigned char                            InputPixelType;
+  typedef float                                    RealPixelType;
+  typedef GrayFrameType                            InputImageType;
+  typedef itk::Image< RealPixelType, 2 >           RealImageType;
+  typedef itk::CurvatureFlowImageFilter< InputImageType, RealImageType >
+                                                   FilterType;
+  typedef GrayFramePoolType                        PoolType;
+
+  CurvatureFlowFrameProcessor()
+  {
+    m_Filter = FilterType::New();
+    m_FramePool = PoolType::New();
+
+    m_Filter->SetTimeStep( 0.5 );
+    m_Filter->SetNumberOfIterations( 20 );
+  }
+
+  void SetTimeStep( double timeStep )
+  {
+    m_Filter->SetTimeStep( timeStep );
+  }
+
+  void SetNumberOfIterations( unsigned int numberOfIterations )
+  {
+    m_Filter->SetNumberOfIterations( numberOfIterations );
+  }
+
+  /** Pool providing the ITK input frames */
+  PoolType * GetFramePool()
+  {
+    return m_FramePool;
+  }
+
+  /** Process a frame. The output Mat is reused when it already has the
+   * right size and type. */
+  void Process( const cv::Mat & inputImage, cv::Mat & outputImage )
+  {
+    InputImageType::Pointer itkFrame =
+      ImportGrayFrame( inputImage, m_FramePool );
+
+    m_Filter->SetInput( itkFrame );
+    m_Filter->Update();
+
+    // Drop the reference held by the filter so the frame returns to the pool
+    m_Filter->SetInput( NULL );
+
+    const RealImageType * result = m_Filter->GetOutput();
+    cv::Mat resultView( inputImage.rows, inputImage.cols, CV_32FC1,
+      const_cast< RealPixelType * >( result->GetBufferPointer() ) );
+    resultView.convertTo( outputImage, CV_8U );
+  }
+
+  cv::Mat Process( const cv::Mat & inputImage )
+  {
+    cv::Mat outputImage;
+    this->Process( inputImage, outputImage );
+    return outputImage;
+  }
+
+private:
+  FilterType::Pointer m_Filter;
+  PoolType::Pointer   m_FramePool;
+};
+
+} // end namespace bridge
+
+#endif
@@ -0,0 +1,156 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __CurvatureFlowSettings_h
+#define __CurvatureFlowSettings_h
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include <itkCommand.h>
+#include <itkIntTypes.h>
+
+namespace bridge
+{
+
+/** \class CurvatureFlowSettings
+ * \brief Iteration control of the CurvatureFlow filters of the exercises.
+ *
+ * The exercises run 20 iterations. With ConvergentCurvatureFlowImageFilter
+ * the iterations can stop early once an update changes the image by less
+ * than a tolerance. Both are read from the environment, so the command
+ * lines of the exercises do not change:
+ *
+ *   BRIDGE_CURVATURE_ITERATIONS   maximum number of iterations
+ *   BRIDGE_CURVATURE_TOLERANCE    RMS change, in gray levels, below which
+ *                                 the iterations stop (default 0: never)
+ */
+struct CurvatureFlowSettings
+{
+  unsigned int MaximumIterations;
+  double       RMSTolerance;
+
+  static CurvatureFlowSettings FromEnvironment( unsigned int defaultIterations )
+  {
+    CurvatureFlowSettings settings;
+    settings.MaximumIterations = defaultIterations;
+    settings.RMSTolerance = 0.0;
+
+    const char * iterations = std::getenv( "BRIDGE_CURVATURE_ITERATIONS" );
+    if( iterations && *iterations )
+      {
+      settings.MaximumIterations =
+        static_cast< unsigned int >( std::strtoul( iterations, 0, 10 ) );
+      }
+    const char * tolerance = std::getenv( "BRIDGE_CURVATURE_TOLERANCE" );
+    if( tolerance && *tolerance )
+      {
+      settings.RMSTolerance = std::strtod( tolerance, 0 );
+      }
+    return settings;
+  }
+
+  template< typename TFilter >
+  void ApplyTo( TFilter * filter ) const
+  {
+    filter->SetNumberOfIterations( MaximumIterations );
+    filter->SetMaximumRMSError( RMSTolerance );
+  }
+};
+
+/** \class IterationReport
+ * \brief Record the iterations a convergent CurvatureFlow filter runs for
+ * every image or frame it filters, and print their distribution.
+ */
+template< typename TFilter >
+class IterationReport
+{
+public:
+  explicit IterationReport( TFilter * filter ) :
+    m_Filter( filter )
+  {
+    m_Command = CommandType::New();
+    m_Command->SetCallbackFunction( this, &IterationReport::Record );
+    m_ObserverTag = filter->AddObserver( itk::EndEvent(), m_Command );
+  }
+
+  ~IterationReport()
+  {
+    m_Filter->RemoveObserver( m_ObserverTag );
+  }
+
+  const std::vector< itk::SizeValueType > & GetIterations() const
+  {
+    return m_Iterations;
+  }
+
+  void Report( std::ostream & os ) const
+  {
+    if( m_Iterations.empty() )
+      {
+      return;
+      }
+    if( m_Iterations.size() == 1 )
+      {
+      os << "CurvatureFlow: " << m_Iterations[0] << " iterations, last RMS change "
+         << m_Filter->GetRMSChange() << std::endl;
+      return;
+      }
+
+    std::map< itk::SizeValueType, itk::SizeValueType > histogram;
+    double total = 0.0;
+    for( size_t i = 0; i < m_Iterations.size(); ++i )
+      {
+      ++histogram[m_Iterations[i]];
+      total += m_Iterations[i];
+      }
+    os << "CurvatureFlow: " << m_Iterations.size() << " frames, "
+       << *std::min_element( m_Iterations.begin(), m_Iterations.end() ) << " to "
+       << *std::max_element( m_Iterations.begin(), m_Iterations.end() )
+       << " iterations, " << total / m_Iterations.size() << " on average"
+       << std::endl;
+    for( std::map< itk::SizeValueType, itk::SizeValueType >::const_iterator
+         it = histogram.begin(); it != histogram.end(); ++it )
+      {
+      os << "  " << it->first << " iterations: " << it->second << " frames"
+         << std::endl;
+      }
+  }
+
+private:
+  IterationReport( const IterationReport & ); //purposely not implemented
+  void operator=( const IterationReport & );  //purposely not implemented
+
+  typedef itk::SimpleMemberCommand< IterationReport > CommandType;
+
+  void Record()
+  {
+    m_Iterations.push_back( m_Filter->GetElapsedIterations() );
+  }
+
+  TFilter *                           m_Filter;
+  typename CommandType::Pointer       m_Command;
+  unsigned long                       m_ObserverTag;
+  std::vector< itk::SizeValueType >   m_Iterations;
+};
+
+} // end namespace bridge
+
+#endif
@@ -0,0 +1,310 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __FrameBatch_h
+#define __FrameBatch_h
+
+#include <functional>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <itkImage.h>
+#include <itkVideoStream.h>
+
+namespace bridge
+{
+
+/** \class FrameLoopBody
+ * \brief cv::ParallelLoopBody calling a function for every frame index of
+ * its range, so that the loops over the frames of a batch run on the
+ * OpenCV thread pool (sized by ThreadBudget::Apply()).
+ */
+class FrameLoopBody : public cv::ParallelLoopBody
+{
+public:
+  explicit FrameLoopBody( const std::function< void ( int ) > & function ) :
+    m_Function( function )
+  {
+  }
+
+  virtual void operator()( const cv::Range & range ) const
+  {
+    for( int i = range.start; i < range.end; ++i )
+      {
+      m_Function( i );
+      }
+  }
+
+private:
+  std::function< void ( int ) > m_Function;
+};
+
+/** Run function( i ) for i in [0, numberOfFrames) in parallel */
+inline void ParallelForFrames( size_t numberOfFrames,
+                               const std::function< void ( int ) > & function )
+{
+  cv::parallel_for_( cv::Range( 0, static_cast< int >( numberOfFrames ) ),
+                     FrameLoopBody( function ) );
+}
+
+/** Convert a BGR, BGRA or gray cv::Mat into the gray view of a frame,
+ * with the same color conversion as itk::OpenCVImageBridge. The view keeps
+ * its buffer: OpenCV writes straight into it when the depths match. */
+inline void ConvertToGrayView( const cv::Mat & inputImage, cv::Mat & view )
+{
+  cv::Mat gray = inputImage;
+  if( inputImage.channels() > 1 )
+    {
+    const int code = inputImage.channels() == 4 ? CV_BGRA2GRAY : CV_BGR2GRAY;
+    if( inputImage.depth() == view.depth() )
+      {
+      cv::cvtColor( inputImage, view, code );
+      return;
+      }
+    cv::cvtColor( inputImage, gray, code );
+    }
+  if( gray.type() == view.type() )
+    {
+    gray.copyTo( view );
+    }
+  else
+    {
+    gray.convertTo( view, view.type() );
+    }
+}
+
+/** \class FrameBatch
+ * \brief A burst of gray frames stored in a single 3D itk::Image (x, y, t),
+ * converted from and to cv::Mat sequences and itk::VideoStream in one go.
+ *
+ * itk::OpenCVImageBridge converts one frame at a time, into a new image. A
+ * batch allocates one volume for all its frames, and only again when the
+ * frame size or the number of frames changes, so that successive chunks of
+ * the same video reuse it. The frames are copied in parallel. The volume
+ * can go to spatio-temporal ITK filters as it is; GraftToVideoStream()
+ * makes the frames of a VideoStream views of its slices, without a copy.
+ *
+ * Color Mats are converted to gray and other depths converted to TPixel.
+ * Frames of different sizes throw an itk::ExceptionObject.
+ */
+template< typename TPixel >
+class FrameBatch
+{
+public:
+  typedef TPixel                                   PixelType;
+  typedef itk::Image< PixelType, 3 >               VolumeType;
+  typedef itk::Image< PixelType, 2 >               FrameType;
+  typedef itk::VideoStream< FrameType >            VideoStreamType;
+
+  FrameBatch() :
+    m_NumberOfAllocations( 0 )
+  {
+    m_Volume = VolumeType::New();
+  }
+
+  /** Convert a sequence of Mats into the volume */
+  void Import( const std::vector< cv::Mat > & frames )
+  {
+    if( frames.empty() )
+      {
+      itkGenericExceptionMacro( << "No frames to import" );
+      }
+    const cv::Size frameSize = frames[0].size();
+    for( size_t i = 1; i < frames.size(); ++i )
+      {
+      if( frames[i].size() != frameSize )
+        {
+        itkGenericExceptionMacro( << "Frame " << i << " is "
+          << frames[i].cols << "x" << frames[i].rows << ", not "
+          << frameSize.width << "x" << frameSize.height );
+        }
+      }
+    this->Allocate( frameSize, frames.size() );
+
+    ParallelForFrames( frames.size(), [this, &frames]( int i )
+      {
+      cv::Mat view = this->GetFrameView( i );
+      ConvertToGrayView( frames[i], view );
+      } );
+    m_Volume->Modified();
+  }
+
+  /** Copy the frames of the volume into a sequence of Mats. Mats of the
+   * right size and type are reused. */
+  void Export( std::vector< cv::Mat > & frames ) const
+  {
+    const size_t numberOfFrames = this->GetNumberOfFrames();
+    frames.resize( numberOfFrames );
+    for( size_t i = 0; i < numberOfFrames; ++i )
+      {
+      frames[i].create( this->GetFrameSize(), cv::DataType< PixelType >::type );
+      }
+    ParallelForFrames( numberOfFrames, [this, &frames]( int i )
+      {
+      this->GetFrameView( i ).copyTo( frames[i] );
+      } );
+  }
+
+  /** Copy the buffered frames of a VideoStream into the volume */
+  void ImportVideoStream( const VideoStreamType * stream )
+  {
+    const itk::TemporalRegion buffered = stream->GetBufferedTemporalRegion();
+    const itk::SizeValueType start = buffered.GetFrameStart();
+    const size_t numberOfFrames = buffered.GetFrameDuration();
+    if( numberOfFrames == 0 )
+      {
+      itkGenericExceptionMacro( << "The video stream has no buffered frames" );
+      }
+    const typename FrameType::SizeType size =
+      stream->GetFrame( start )->GetBufferedRegion().GetSize();
+    for( size_t i = 1; i < numberOfFrames; ++i )
+      {
+      if( stream->GetFrame( start + i )->GetBufferedRegion().GetSize() != size )
+        {
+        itkGenericExceptionMacro( << "Frame " << start + i
+                                  << " does not have the size of the first frame" );
+        }
+      }
+    this->Allocate( cv::Size( static_cast< int >( size[0] ),
+                              static_cast< int >( size[1] ) ), numberOfFrames );
+
+    ParallelForFrames( numberOfFrames, [this, stream, start]( int i )
+      {
+      cv::Mat view = this->GetFrameView( i );
+      FrameView( stream->GetFrame( start + i ) ).copyTo( view );
+      } );
+    m_Volume->Modified();
+  }
+
+  /** Set up a VideoStream whose frames startFrame... are views of the
+   * slices of the volume. The batch must outlive the use of the frames,
+   * and the stream must not be the output of a filter. */
+  void GraftToVideoStream( VideoStreamType * stream,
+                           itk::SizeValueType startFrame = 0 ) const
+  {
+    const size_t numberOfFrames = this->GetNumberOfFrames();
+    itk::TemporalRegion temporalRegion;
+    temporalRegion.SetFrameStart( startFrame );
+    temporalRegion.SetFrameDuration( numberOfFrames );
+    stream->SetLargestPossibleTemporalRegion( temporalRegion );
+    stream->SetRequestedTemporalRegion( temporalRegion );
+    stream->SetBufferedTemporalRegion( temporalRegion );
+    stream->SetMinimumBufferSize( numberOfFrames );
+    stream->InitializeEmptyFrames();
+
+    typename FrameType::RegionType frameRegion;
+    frameRegion.SetSize( 0, m_Volume->GetBufferedRegion().GetSize( 0 ) );
+    frameRegion.SetSize( 1, m_Volume->GetBufferedRegion().GetSize( 1 ) );
+    stream->SetAllLargestPossibleSpatialRegions( frameRegion );
+    stream->SetAllRequestedSpatialRegions( frameRegion );
+    stream->SetAllBufferedSpatialRegions( frameRegion );
+
+    const size_t framePixels = frameRegion.GetNumberOfPixels();
+    PixelType * pixels = const_cast< PixelType * >( m_Volume->GetBufferPointer() );
+    for( size_t i = 0; i < numberOfFrames; ++i )
+      {
+      FrameType * frame = stream->GetFrame( startFrame + i );
+      frame->GetPixelContainer()->SetImportPointer( pixels + i * framePixels,
+                                                    framePixels, false );
+      frame->Modified();
+      }
+    stream->Modified();
+  }
+
+  /** OpenCV header on frame i of the volume, sharing its pixels */
+  cv::Mat GetFrameView( size_t i ) const
+  {
+    const cv::Size frameSize = this->GetFrameSize();
+    PixelType * pixels = const_cast< PixelType * >( m_Volume->GetBufferPointer() );
+    return cv::Mat( frameSize, cv::DataType< PixelType >::type,
+                    pixels + i * frameSize.area() );
+  }
+
+  VolumeType * GetVolume()
+  {
+    return m_Volume;
+  }
+
+  size_t GetNumberOfFrames() const
+  {
+    return m_Volume->GetBufferedRegion().GetSize( 2 );
+  }
+
+  cv::Size GetFrameSize() const
+  {
+    return cv::Size(
+      static_cast< int >( m_Volume->GetBufferedRegion().GetSize( 0 ) ),
+      static_cast< int >( m_Volume->GetBufferedRegion().GetSize( 1 ) ) );
+  }
+
+  /** Times the volume was (re)allocated */
+  size_t GetNumberOfAllocations() const
+  {
+    return m_NumberOfAllocations;
+  }
+
+  /** OpenCV header on the buffer of a 2D frame */
+  static cv::Mat FrameView( const FrameType * frame )
+  {
+    const typename FrameType::SizeType size = frame->GetBufferedRegion().GetSize();
+    return cv::Mat( static_cast< int >( size[1] ), static_cast< int >( size[0] ),
+                    cv::DataType< PixelType >::type,
+                    const_cast< PixelType * >( frame->GetBufferPointer() ) );
+  }
+
+  /** Copy the buffered frames of a VideoStream into a sequence of Mats */
+  static void ExportVideoStream( const VideoStreamType * stream,
+                                 std::vector< cv::Mat > & frames )
+  {
+    const itk::TemporalRegion buffered = stream->GetBufferedTemporalRegion();
+    const itk::SizeValueType start = buffered.GetFrameStart();
+    frames.resize( buffered.GetFrameDuration() );
+    ParallelForFrames( frames.size(), [stream, start, &frames]( int i )
+      {
+      FrameView( stream->GetFrame( start + i ) ).copyTo( frames[i] );
+      } );
+  }
+
+private:
+  FrameBatch( const FrameBatch & ); //purposely not implemented
+  void operator=( const FrameBatch & ); //purposely not implemented
+
+  /** Allocate the volume unless it already has this geometry */
+  void Allocate( const cv::Size & frameSize, size_t numberOfFrames )
+  {
+    typename VolumeType::RegionType region;
+    region.SetSize( 0, frameSize.width );
+    region.SetSize( 1, frameSize.height );
+    region.SetSize( 2, numberOfFrames );
+    if( m_NumberOfAllocations > 0 && region == m_Volume->GetBufferedRegion() )
+      {
+      return;
+      }
+    m_Volume->SetRegions( region );
+    m_Volume->Allocate();
+    ++m_NumberOfAllocations;
+  }
+
+  typename VolumeType::Pointer m_Volume;
+  size_t                       m_NumberOfAllocations;
+};
+
+} // end namespace bridge
+
+#endif
@@ -0,0 +1,514 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __FrameLatencyMetrics_h
+#define __FrameLatencyMetrics_h
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <stdint.h>
+
+namespace bridge
+{
+
+/** \class LatencyHistogram
+ * \brief Latency histogram updated without locks from any thread.
+ *
+ * The bucket bounds grow by a factor of sqrt(2) from 100 us to 13 s, so a
+ * quantile interpolated in its bucket is within about 20 % of the exact
+ * value. Record() costs two relaxed atomic additions; the histogram can
+ * stay on in production. GetSnapshot() copies the counters, and the
+ * difference of two snapshots is the histogram of the frames in between.
+ */
+class LatencyHistogram
+{
+public:
+  typedef std::chrono::steady_clock ClockType;
+
+  /** Number of finite bucket bounds; one more bucket holds the rest */
+  static const size_t NumberOfBounds = 35;
+
+  /** Upper bound of bucket i in nanoseconds */
+  static uint64_t GetBoundNanoseconds( size_t i )
+  {
+    static const struct Bounds
+      {
+      uint64_t Values[NumberOfBounds];
+      Bounds()
+        {
+        for( size_t k = 0; k < NumberOfBounds; ++k )
+          {
+          Values[k] = ( k % 2 ? 141421 : 100000 ) * ( uint64_t( 1 ) << ( k / 2 ) );
+          }
+        }
+      } bounds;
+    return bounds.Values[i];
+  }
+
+  struct Snapshot
+  {
+    uint64_t Counts[NumberOfBounds + 1];
+    uint64_t SumNanoseconds;
+
+    Snapshot() : SumNanoseconds( 0 )
+    {
+      std::fill( Counts, Counts + NumberOfBounds + 1, uint64_t( 0 ) );
+    }
+
+    uint64_t GetCount() const
+    {
+      uint64_t count = 0;
+      for( size_t i = 0; i <= NumberOfBounds; ++i )
+        {
+        count += Counts[i];
+        }
+      return count;
+    }
+
+    /** Quantile q in seconds, interpolated linearly in its bucket as
+     * Prometheus' histogram_quantile() does. 0 without samples. */
+    double GetQuantile( double q ) const
+    {
+      const uint64_t count = this->GetCount();
+      if( count == 0 )
+        {
+        return 0.0;
+        }
+      const double rank = q * count;
+      double below = 0.0;
+      for( size_t i = 0; i <= NumberOfBounds; ++i )
+        {
+        if( below + Counts[i] >= rank && Counts[i] > 0 )
+          {
+          if( i == NumberOfBounds )
+            {
+            // Beyond the last bound: report the bound
+            return 1e-9 * GetBoundNanoseconds( NumberOfBounds - 1 );
+            }
+          const double lower = i > 0 ? 1e-9 * GetBoundNanoseconds( i - 1 ) : 0.0;
+          const double upper = 1e-9 * GetBoundNanoseconds( i );
+          return lower + ( upper - lower ) * ( rank - below ) / Counts[i];
+          }
+        below += Counts[i];
+        }
+      return 0.0;
+    }
+
+    Snapshot operator-( const Snapshot & earlier ) const
+    {
+      Snapshot difference;
+      for( size_t i = 0; i <= NumberOfBounds; ++i )
+        {
+        difference.Counts[i] = Counts[i] - earlier.Counts[i];
+        }
+      difference.SumNanoseconds = SumNanoseconds - earlier.SumNanoseconds;
+      return difference;
+    }
+  };
+
+  LatencyHistogram()
+  {
+    for( size_t i = 0; i <= NumberOfBounds; ++i )
+      {
+      m_Counts[i].store( 0, std::memory_order_relaxed );
+      }
+    m_SumNanoseconds.store( 0, std::memory_order_relaxed );
+  }
+
+  void Record( ClockType::duration latency )
+  {
+    const int64_t nanoseconds =
+      std::chrono::duration_cast< std::chrono::nanoseconds >( latency ).count();
+    this->RecordNanoseconds( nanoseconds > 0 ? static_cast< uint64_t >( nanoseconds ) : 0 );
+  }
+
+  void RecordNanoseconds( uint64_t nanoseconds )
+  {
+    size_t i = 0;
+    while( i < NumberOfBounds && nanoseconds > GetBoundNanoseconds( i ) )
+      {
+      ++i;
+      }
+    m_Counts[i].fetch_add( 1, std::memory_order_relaxed );
+    m_SumNanoseconds.fetch_add( nanoseconds, std::memory_order_relaxed );
+  }
+
+  /** Latency since start */
+  void RecordSince( ClockType::time_point start )
+  {
+    this->Record( ClockType::now() - start );
+  }
+
+  Snapshot GetSnapshot() const
+  {
+    Snapshot snapshot;
+    for( size_t i = 0; i <= NumberOfBounds; ++i )
+      {
+      snapshot.Counts[i] = m_Counts[i].load( std::memory_order_relaxed );
+      }
+    snapshot.SumNanoseconds = m_SumNanoseconds.load( std::memory_order_relaxed );
+    return snapshot;
+  }
+
+private:
+  LatencyHistogram( const LatencyHistogram & ); //purposely not implemented
+  void operator=( const LatencyHistogram & );   //purposely not implemented
+
+  std::atomic< uint64_t > m_Counts[NumberOfBounds + 1];
+  std::atomic< uint64_t > m_SumNanoseconds;
+};
+
+/** \class FrameLatencyMetrics
+ * \brief Latency histograms of the capture, processing and output of the
+ * frames of a video executable, exported while it runs.
+ *
+ * The stages record their latencies into Capture, Process and Output from
+ * any thread. Start() runs a thread that exports them:
+ *
+ *   BRIDGE_METRICS_FILE      file rewritten in the Prometheus text format
+ *                            (e.g. for the node_exporter textfile collector)
+ *   BRIDGE_METRICS_INTERVAL  seconds between two writes (default: 10)
+ *   BRIDGE_METRICS_WINDOW    seconds of the rolling quantiles (default: 60)
+ *
+ * SIGUSR1 prints the rolling p50, p95 and p99 of every stage and the
+ * dropped frames on the standard error; the standard output may carry
+ * frames. The file holds the cumulative histograms, from which Prometheus
+ * computes its own quantiles, and the rolling quantiles as gauges. It is
+ * written to a temporary file first and renamed, so a reader never sees
+ * half of it.
+ */
+class FrameLatencyMetrics
+{
+public:
+  typedef LatencyHistogram::ClockType   ClockType;
+  typedef LatencyHistogram::Snapshot    SnapshotType;
+  typedef std::function< uint64_t () >  CounterFunctionType;
+
+  enum Stage { Capture = 0, Process, Output, NumberOfStages };
+
+  /** job labels the metrics, e.g. the name of the executable */
+  explicit FrameLatencyMetrics( const std::string & job ) :
+    m_Job( job ),
+    m_Interval( ReadSeconds( "BRIDGE_METRICS_INTERVAL", 10.0 ) ),
+    m_Window( ReadSeconds( "BRIDGE_METRICS_WINDOW", 60.0 ) ),
+    m_Stop( false )
+  {
+    const char * file = std::getenv( "BRIDGE_METRICS_FILE" );
+    if( file )
+      {
+      m_FileName = file;
+      }
+    const size_t slash = m_Job.find_last_of( "/\\" );
+    if( slash != std::string::npos )
+      {
+      m_Job = m_Job.substr( slash + 1 );
+      }
+  }
+
+  ~FrameLatencyMetrics()
+  {
+    this->Stop();
+  }
+
+  LatencyHistogram & GetHistogram( Stage stage )
+  {
+    return m_Histograms[stage];
+  }
+
+  static const char * GetStageName( Stage stage )
+  {
+    static const char * names[NumberOfStages] = { "capture", "process", "output" };
+    return names[stage];
+  }
+
+  /** Frames lost by the capture, read when exporting */
+  void SetDroppedFramesFunction( const CounterFunctionType & dropped )
+  {
+    m_DroppedFrames = dropped;
+  }
+
+  /** Install the SIGUSR1 handler and start exporting */
+  void Start()
+  {
+#if defined( SIGUSR1 )
+    std::signal( SIGUSR1, &FrameLatencyMetrics::RequestDump );
+#endif
+    m_Windows.clear();
+    m_Windows.push_back( this->TakeSnapshots() );
+    m_Thread = std::thread( [this]() { this->Run(); } );
+  }
+
+  /** Stop exporting. The file is written a last time. */
+  void Stop()
+  {
+    if( !m_Thread.joinable() )
+      {
+      return;
+      }
+      {
+      std::lock_guard< std::mutex > lock( m_Mutex );
+      m_Stop = true;
+      }
+    m_Wake.notify_all();
+    m_Thread.join();
+    this->WriteFile();
+  }
+
+  /** Rolling quantiles of every stage. Called by the exporting thread, or
+   * after Stop(). */
+  void Report( std::ostream & os ) const
+  {
+    const Snapshots current = this->TakeSnapshots();
+    const Snapshots & oldest = m_Windows.empty() ? current : m_Windows.front();
+    os << m_Job << " frame latency over the last " << std::fixed
+       << std::setprecision( 1 ) << this->GetWindowSeconds( current )
+       << " s (ms):" << std::endl;
+    for( int s = 0; s < NumberOfStages; ++s )
+      {
+      const SnapshotType window = current.Stages[s] - oldest.Stages[s];
+      os << "  " << std::left << std::setw( 8 ) << GetStageName( Stage( s ) )
+         << std::right << std::fixed << std::setprecision( 2 )
+         << " p50 " << std::setw( 8 ) << 1e3 * window.GetQuantile( 0.5 )
+         << " p95 " << std::setw( 8 ) << 1e3 * window.GetQuantile( 0.95 )
+         << " p99 " << std::setw( 8 ) << 1e3 * window.GetQuantile( 0.99 )
+         << "  frames " << window.GetCount() << std::endl;
+      }
+    os << "  dropped frames " << current.DroppedFrames - oldest.DroppedFrames
+       << " (" << current.DroppedFrames << " in total)" << std::endl;
+  }
+
+  /** All the metrics in the Prometheus text exposition format. Called by
+   * the exporting thread, or after Stop(). */
+  void WriteExposition( std::ostream & os ) const
+  {
+    const Snapshots current = this->TakeSnapshots();
+    const Snapshots & oldest = m_Windows.empty() ? current : m_Windows.front();
+    const std::string job = "job=\"" + m_Job + "\"";
+
+    os << "# HELP bridge_frame_latency_seconds Latency of the frames per stage.\n"
+       << "# TYPE bridge_frame_latency_seconds histogram\n";
+    for( int s = 0; s < NumberOfStages; ++s )
+      {
+      const SnapshotType & snapshot = current.Stages[s];
+      const std::string labels = job + ",stage=\"" + GetStageName( Stage( s ) ) + "\"";
+      uint64_t cumulative = 0;
+      for( size_t i = 0; i <= LatencyHistogram::NumberOfBounds; ++i )
+        {
+        cumulative += snapshot.Counts[i];
+        os << "bridge_frame_latency_seconds_bucket{" << labels << ",le=\"";
+        if( i < LatencyHistogram::NumberOfBounds )
+          {
+          os << 1e-9 * LatencyHistogram::GetBoundNanoseconds( i );
+          }
+        else
+          {
+          os << "+Inf";
+          }
+        os << "\"} " << cumulative << "\n";
+        }
+      os << "bridge_frame_latency_seconds_sum{" << labels << "} "
+         << 1e-9 * snapshot.SumNanoseconds << "\n"
+         << "bridge_frame_latency_seconds_count{" << labels << "} "
+         << cumulative << "\n";
+      }
+
+    os << "# HELP bridge_frame_latency_window_seconds Latency quantiles of the"
+       << " frames of the last " << m_Window << " s per stage.\n"
+       << "# TYPE bridge_frame_latency_window_seconds gauge\n";
+    static const char * quantiles[] = { "0.5", "0.95", "0.99" };
+    for( int s = 0; s < NumberOfStages; ++s )
+      {
+      const SnapshotType window = current.Stages[s] - oldest.Stages[s];
+      for( int q = 0; q < 3; ++q )
+        {
+        os << "bridge_frame_latency_window_seconds{" << job << ",stage=\""
+           << GetStageName( Stage( s ) ) << "\",quantile=\"" << quantiles[q] << "\"} "
+           << window.GetQuantile( std::atof( quantiles[q] ) ) << "\n";
+        }
+      }
+
+    os << "# HELP bridge_frames_dropped_total Frames lost by the capture.\n"
+       << "# TYPE bridge_frames_dropped_total counter\n"
+       << "bridge_frames_dropped_total{" << job << "} "
+       << current.DroppedFrames << "\n";
+  }
+
+private:
+  FrameLatencyMetrics( const FrameLatencyMetrics & ); //purposely not implemented
+  void operator=( const FrameLatencyMetrics & );      //purposely not implemented
+
+  struct Snapshots
+  {
+    SnapshotType          Stages[NumberOfStages];
+    uint64_t              DroppedFrames;
+    ClockType::time_point Time;
+  };
+
+  static double ReadSeconds( const char * name, double defaultValue )
+  {
+    const char * value = std::getenv( name );
+    const double seconds = value ? std::atof( value ) : 0.0;
+    return seconds > 0.0 ? seconds : defaultValue;
+  }
+
+  // Only sets a flag: the exporting thread does the printing
+  static volatile std::sig_atomic_t & DumpRequested()
+  {
+    static volatile std::sig_atomic_t requested = 0;
+    return requested;
+  }
+
+  static void RequestDump( int )
+  {
+    DumpRequested() = 1;
+  }
+
+  Snapshots TakeSnapshots() const
+  {
+    Snapshots snapshots;
+    for( int s = 0; s < NumberOfStages; ++s )
+      {
+      snapshots.Stages[s] = m_Histograms[s].GetSnapshot();
+      }
+    snapshots.DroppedFrames = m_DroppedFrames ? m_DroppedFrames() : 0;
+    snapshots.Time = ClockType::now();
+    return snapshots;
+  }
+
+  double GetWindowSeconds( const Snapshots & current ) const
+  {
+    if( m_Windows.empty() )
+      {
+      return 0.0;
+      }
+    return std::chrono::duration< double >(
+      current.Time - m_Windows.front().Time ).count();
+  }
+
+  void WriteFile() const
+  {
+    if( m_FileName.empty() )
+      {
+      return;
+      }
+    const std::string temporary = m_FileName + ".tmp";
+      {
+      std::ofstream file( temporary.c_str() );
+      this->WriteExposition( file );
+      if( !file )
+        {
+        std::cerr << "Unable to write the metrics to: " << temporary << std::endl;
+        return;
+        }
+      }
+    if( std::rename( temporary.c_str(), m_FileName.c_str() ) != 0 )
+      {
+      std::cerr << "Unable to write the metrics to: " << m_FileName << std::endl;
+      }
+  }
+
+  // The window is a queue of snapshots, one per interval: the rolling
+  // histogram is the latest snapshot minus the oldest one.
+  void Run()
+  {
+    const std::chrono::milliseconds poll( 100 );
+    const ClockType::duration interval =
+      std::chrono::duration_cast< ClockType::duration >(
+        std::chrono::duration< double >( m_Interval ) );
+    ClockType::time_point next = ClockType::now() + interval;
+    std::unique_lock< std::mutex > lock( m_Mutex );
+    while( !m_Stop )
+      {
+      m_Wake.wait_for( lock, poll );
+      if( DumpRequested() )
+        {
+        DumpRequested() = 0;
+        this->Report( std::cerr );
+        }
+      if( ClockType::now() < next )
+        {
+        continue;
+        }
+      next += interval;
+      m_Windows.push_back( this->TakeSnapshots() );
+      while( m_Windows.size() > 2 &&
+             m_Windows.back().Time - m_Windows[1].Time >=
+               std::chrono::duration< double >( m_Window ) )
+        {
+        m_Windows.pop_front();
+        }
+      this->WriteFile();
+      }
+  }
+
+  LatencyHistogram        m_Histograms[NumberOfStages];
+  CounterFunctionType     m_DroppedFrames;
+  std::string             m_Job;
+  std::string             m_FileName;
+  double                  m_Interval;
+  double                  m_Window;
+
+  std::deque< Snapshots > m_Windows;
+  std::thread             m_Thread;
+  std::mutex              m_Mutex;
+  std::condition_variable m_Wake;
+  bool                    m_Stop;
+};
+
+/** \class ScopedLatency
+ * \brief Record the time from construction to destruction in a histogram.
+ */
+class ScopedLatency
+{
+public:
+  explicit ScopedLatency( LatencyHistogram & histogram ) :
+    m_Histogram( histogram ),
+    m_Start( LatencyHistogram::ClockType::now() )
+  {
+  }
+
+  ~ScopedLatency()
+  {
+    m_Histogram.RecordSince( m_Start );
+  }
+
+private:
+  ScopedLatency( const ScopedLatency & ); //purposely not implemented
+  void operator=( const ScopedLatency & ); //purposely not implemented
+
+  LatencyHistogram &                    m_Histogram;
+  LatencyHistogram::ClockType::time_point m_Start;
+};
+
+} // end namespace bridge
+
+#endif
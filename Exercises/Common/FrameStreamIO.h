@@ -0,0 +1,375 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __FrameStreamIO_h
+#define __FrameStreamIO_h
+
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "SpscFrameRing.h"
+#include "VideoCaptureSeek.h"
+#include "Y4MFrameStream.h"
+
+namespace bridge
+{
+
+/** Whether a file name denotes a y4m stream: "-" (a pipe) or a .y4m file */
+inline bool IsY4MStreamName( const std::string & name )
+{
+  const std::string extension = ".y4m";
+  return name == "-" ||
+    ( name.size() > extension.size() &&
+      name.compare( name.size() - extension.size(), extension.size(),
+                    extension ) == 0 );
+}
+
+/** \class FrameSource
+ * \brief Gray frames read either from a y4m stream or through
+ * cv::VideoCapture.
+ */
+struct FrameSource
+{
+  std::function< bool ( cv::Mat & ) > Read;
+  double                              FramesPerSecond;
+  cv::Size                            FrameSize;
+};
+
+/** \class FrameClip
+ * \brief The frames of a source to process: NumberOfFrames frames (0 for
+ * all of them) from StartFrame on.
+ *
+ * FromEnvironment() reads them from BRIDGE_START_FRAME and
+ * BRIDGE_NUMBER_OF_FRAMES, so that the streaming exercises can process a
+ * clip from the middle of a video without decoding what comes before it
+ * (see VideoSeekIndex.h).
+ */
+struct FrameClip
+{
+  size_t StartFrame;
+  size_t NumberOfFrames;
+
+  FrameClip() : StartFrame( 0 ), NumberOfFrames( 0 ) {}
+
+  static FrameClip FromEnvironment()
+  {
+    FrameClip clip;
+    const char * start = std::getenv( "BRIDGE_START_FRAME" );
+    if( start && *start )
+      {
+      clip.StartFrame = static_cast< size_t >( std::strtoul( start, 0, 10 ) );
+      }
+    const char * count = std::getenv( "BRIDGE_NUMBER_OF_FRAMES" );
+    if( count && *count )
+      {
+      clip.NumberOfFrames = static_cast< size_t >( std::strtoul( count, 0, 10 ) );
+      }
+    return clip;
+  }
+};
+
+/** \class FrameSink
+ * \brief Gray frames written either to a y4m stream or through
+ * cv::VideoWriter.
+ */
+struct FrameSink
+{
+  std::function< bool ( const cv::Mat & ) > Write;
+  std::function< void () >                  Close;
+};
+
+/** Build the seek index of a y4m file or of a video decoded by OpenCV, with
+ * a key frame about every keyFrameInterval frames for the latter */
+inline bool BuildVideoSeekIndex( const std::string & name, VideoSeekIndex & index,
+                                 size_t keyFrameInterval = 250 )
+{
+  if( IsY4MStreamName( name ) )
+    {
+    return name != "-" && index.BuildFromY4M( name );
+    }
+  return BuildVideoCaptureSeekIndex( name, index, keyFrameInterval );
+}
+
+/** Limit a source to the NumberOfFrames frames of a clip */
+inline void LimitFrameSource( FrameSource & source, size_t numberOfFrames )
+{
+  if( numberOfFrames == 0 )
+    {
+    return;
+    }
+  std::shared_ptr< size_t > remaining( new size_t( numberOfFrames ) );
+  std::function< bool ( cv::Mat & ) > read = source.Read;
+  source.Read = [read, remaining]( cv::Mat & frame )
+    {
+    if( *remaining == 0 || !read( frame ) )
+      {
+      return false;
+      }
+    --*remaining;
+    return true;
+    };
+}
+
+/** Open a source of gray frames. y4m streams, including the standard input
+ * "-", provide their Y plane directly; other videos are decoded by OpenCV
+ * and converted.
+ *
+ * The source starts at clip.StartFrame. Files are positioned with their
+ * seek index when one was built for them; without one, y4m files are
+ * positioned from a scan of their frame lines and other videos are decoded
+ * from their start. The standard input skips the frames before the clip. */
+inline bool OpenFrameSource( const std::string & name, FrameSource & source,
+                             const FrameClip & clip = FrameClip() )
+{
+  VideoSeekIndex index;
+  const bool indexed = clip.StartFrame > 0 && name != "-" && index.Load( name );
+
+  if( IsY4MStreamName( name ) )
+    {
+    std::shared_ptr< Y4MFrameReader > reader( new Y4MFrameReader );
+    reader->SetGrayOutput( true );
+    if( !reader->Open( name ) )
+      {
+      return false;
+      }
+    source.FramesPerSecond = reader->GetFramesPerSecond();
+    source.FrameSize = reader->GetFrameSize();
+    source.Read = [reader]( cv::Mat & frame ) { return reader->Read( frame ); };
+    if( clip.StartFrame > 0 &&
+        !reader->SeekToFrame( clip.StartFrame, indexed ? &index : 0 ) )
+      {
+      if( name != "-" )
+        {
+        return false;
+        }
+      cv::Mat skipped;
+      for( size_t f = 0; f < clip.StartFrame; ++f )
+        {
+        if( !reader->Read( skipped ) )
+          {
+          return false;
+          }
+        }
+      }
+    LimitFrameSource( source, clip.NumberOfFrames );
+    return true;
+    }
+
+  std::shared_ptr< cv::VideoCapture > capture( new cv::VideoCapture( name ) );
+  if( !capture->isOpened() )
+    {
+    return false;
+    }
+  if( clip.StartFrame > 0 &&
+      !SeekVideoCapture( *capture, name, indexed ? &index : 0, clip.StartFrame ) )
+    {
+    return false;
+    }
+  source.FramesPerSecond = capture->get( CV_CAP_PROP_FPS );
+  source.FrameSize = cv::Size(
+    static_cast< int >( capture->get( CV_CAP_PROP_FRAME_WIDTH ) ),
+    static_cast< int >( capture->get( CV_CAP_PROP_FRAME_HEIGHT ) ) );
+  std::shared_ptr< cv::Mat > color( new cv::Mat );
+  source.Read = [capture, color]( cv::Mat & frame )
+    {
+    if( !capture->read( *color ) )
+      {
+      return false;
+      }
+    cv::cvtColor( *color, frame, CV_BGR2GRAY );
+    return true;
+    };
+  LimitFrameSource( source, clip.NumberOfFrames );
+  return true;
+}
+
+/** Open a sink for gray frames. y4m streams, including the standard output
+ * "-", store them losslessly; other files are encoded by OpenCV. */
+inline bool OpenFrameSink( const std::string & name, double framesPerSecond,
+                           cv::Size frameSize, FrameSink & sink )
+{
+  if( IsY4MStreamName( name ) )
+    {
+    std::shared_ptr< Y4MFrameWriter > writer( new Y4MFrameWriter );
+    if( !writer->Open( name, framesPerSecond, frameSize, false ) )
+      {
+      return false;
+      }
+    sink.Write = [writer]( const cv::Mat & frame ) { return writer->Write( frame ); };
+    sink.Close = [writer]() { writer->Close(); };
+    return true;
+    }
+
+  int fourcc = CV_FOURCC('D','I','V','X');
+  std::shared_ptr< cv::VideoWriter > writer(
+    new cv::VideoWriter( name, fourcc, framesPerSecond, frameSize, false ) );
+  if( !writer->isOpened() )
+    {
+    return false;
+    }
+  sink.Write = [writer]( const cv::Mat & frame )
+    {
+    *writer << frame;
+    return true;
+    };
+  sink.Close = [writer]() { writer->release(); };
+  return true;
+}
+
+/** \class ThreadedFrameCapture
+ * \brief Read the frames of a source on their own thread.
+ *
+ * The capture thread hands the frames to the processing loop through a
+ * SpscFrameRing, so reading the next frame overlaps with processing the
+ * current one without any lock on the way. The buffers go back and forth
+ * through the ring and are reused: a popped frame is only valid until the
+ * next call to Pop().
+ *
+ * A live source cannot wait for the processing loop. With
+ * SetDropWhenFull(), set before Start(), the frames read while the ring is
+ * full are dropped and counted instead of holding up the capture.
+ *
+ * An exception thrown by the read function, e.g. on a truncated y4m frame,
+ * ends the capture and is rethrown by Pop() once the frames read before it
+ * were popped.
+ */
+class ThreadedFrameCapture
+{
+public:
+  typedef std::function< bool ( cv::Mat & ) > ReadFunctionType;
+  typedef std::function< void () >            StartFunctionType;
+
+  explicit ThreadedFrameCapture( size_t capacity ) :
+    m_Ring( capacity ),
+    m_DropWhenFull( false ),
+    m_DroppedFrames( 0 )
+  {
+  }
+
+  void SetDropWhenFull( bool drop )
+  {
+    m_DropWhenFull = drop;
+  }
+
+  /** Frames dropped so far; may be called from any thread */
+  uint64_t GetNumberOfDroppedFrames() const
+  {
+    return m_DroppedFrames.load( std::memory_order_relaxed );
+  }
+
+  ~ThreadedFrameCapture()
+  {
+    this->Stop();
+  }
+
+  /** Start the capture thread. start, if given, runs first on that thread. */
+  void Start( const ReadFunctionType & read,
+              const StartFunctionType & start = StartFunctionType() )
+  {
+    m_Thread = std::thread( [this, read, start]()
+      {
+      if( start )
+        {
+        start();
+        }
+      cv::Mat frame;
+      try
+        {
+        while( read( frame ) )
+          {
+          if( !m_DropWhenFull )
+            {
+            if( !m_Ring.Push( frame ) )
+              {
+              break;
+              }
+            }
+          else if( m_Ring.IsClosed() )
+            {
+            break;
+            }
+          else if( !m_Ring.Offer( frame ) )
+            {
+            m_DroppedFrames.fetch_add( 1, std::memory_order_relaxed );
+            }
+          }
+        }
+      catch( ... )
+        {
+        m_Error = std::current_exception();
+        }
+      m_Ring.Close();
+      } );
+  }
+
+  /** Wait for the next frame. Returns false at the end of the source and
+   * rethrows the exception that ended the capture, if any. */
+  bool Pop( cv::Mat & frame )
+  {
+    if( m_Ring.Pop( frame ) )
+      {
+      return true;
+      }
+    if( m_Error )
+      {
+      std::rethrow_exception( m_Error );
+      }
+    return false;
+  }
+
+  /** Get the next frame if one is ready */
+  bool TryPop( cv::Mat & frame )
+  {
+    return m_Ring.TryPop( frame );
+  }
+
+  /** Stop capturing, e.g. when the consumer gives up early */
+  void Stop()
+  {
+    m_Ring.Close();
+    if( m_Thread.joinable() )
+      {
+      m_Thread.join();
+      }
+  }
+
+private:
+  ThreadedFrameCapture( const ThreadedFrameCapture & ); //purposely not implemented
+  void operator=( const ThreadedFrameCapture & );       //purposely not implemented
+
+  SpscFrameRing< cv::Mat > m_Ring;
+  std::thread              m_Thread;
+  bool                     m_DropWhenFull;
+  std::atomic< uint64_t >  m_DroppedFrames;
+  std::exception_ptr       m_Error;
+};
+
+} // end namespace bridge
+
+#endif
@@ -0,0 +1,199 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __JobSocket_h
+#define __JobSocket_h
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace bridge
+{
+
+/** \class JobConnection
+ * \brief One end of a local stream socket exchanging text lines, as used
+ * by the BridgeJobServer and BridgeJobClient tools.
+ *
+ * Every request and every reply is a single line terminated by '\n'. The
+ * connection owns its descriptor and closes it when destroyed.
+ */
+class JobConnection
+{
+public:
+  explicit JobConnection( int descriptor = -1 ) :
+    m_Descriptor( descriptor ),
+    m_Begin( 0 ),
+    m_End( 0 )
+  {
+  }
+
+  ~JobConnection()
+  {
+    this->Close();
+  }
+
+  bool IsOpen() const
+  {
+    return m_Descriptor >= 0;
+  }
+
+  void Close()
+  {
+    if( m_Descriptor >= 0 )
+      {
+      ::close( m_Descriptor );
+      m_Descriptor = -1;
+      }
+  }
+
+  /** Read the next line, without its terminator. Returns false at the end
+   * of the stream or on error. */
+  bool ReadLine( std::string & line )
+  {
+    line.clear();
+    for(;;)
+      {
+      while( m_Begin < m_End )
+        {
+        const char c = m_Buffer[m_Begin++];
+        if( c == '\n' )
+          {
+          if( !line.empty() && line[line.size() - 1] == '\r' )
+            {
+            line.erase( line.size() - 1 );
+            }
+          return true;
+          }
+        line += c;
+        }
+      ssize_t count;
+      do
+        {
+        count = ::read( m_Descriptor, m_Buffer, sizeof( m_Buffer ) );
+        }
+      while( count < 0 && errno == EINTR );
+      if( count <= 0 )
+        {
+        return false;
+        }
+      m_Begin = 0;
+      m_End = static_cast< size_t >( count );
+      }
+  }
+
+  /** Write a line, adding its terminator */
+  bool WriteLine( const std::string & line )
+  {
+    const std::string data = line + '\n';
+    size_t written = 0;
+    while( written < data.size() )
+      {
+      const ssize_t count = ::send( m_Descriptor, data.data() + written,
+                                    data.size() - written, MSG_NOSIGNAL );
+      if( count < 0 && errno == EINTR )
+        {
+        continue;
+        }
+      if( count <= 0 )
+        {
+        return false;
+        }
+      written += static_cast< size_t >( count );
+      }
+    return true;
+  }
+
+private:
+  JobConnection( const JobConnection & );
+  void operator=( const JobConnection & );
+
+  int    m_Descriptor;
+  char   m_Buffer[4096];
+  size_t m_Begin;
+  size_t m_End;
+};
+
+/** Fill the address of the socket at path. Returns false if the path is
+ * too long for a Unix socket address. */
+inline bool MakeJobSocketAddress( const std::string & path, sockaddr_un & address )
+{
+  std::memset( &address, 0, sizeof( address ) );
+  address.sun_family = AF_UNIX;
+  if( path.empty() || path.size() >= sizeof( address.sun_path ) )
+    {
+    return false;
+    }
+  std::memcpy( address.sun_path, path.c_str(), path.size() );
+  return true;
+}
+
+/** Listen on a Unix socket at path, replacing a stale socket file left by
+ * a previous server. Returns the descriptor, or -1 on error. */
+inline int ListenOnJobSocket( const std::string & path, int backlog = 64 )
+{
+  sockaddr_un address;
+  if( !MakeJobSocketAddress( path, address ) )
+    {
+    return -1;
+    }
+  const int descriptor = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+  if( descriptor < 0 )
+    {
+    return -1;
+    }
+  ::unlink( path.c_str() );
+  if( ::bind( descriptor, reinterpret_cast< sockaddr * >( &address ),
+              sizeof( address ) ) != 0 ||
+      ::listen( descriptor, backlog ) != 0 )
+    {
+    ::close( descriptor );
+    return -1;
+    }
+  return descriptor;
+}
+
+/** Connect to the Unix socket at path. Returns the descriptor, or -1 on
+ * error. */
+inline int ConnectToJobSocket( const std::string & path )
+{
+  sockaddr_un address;
+  if( !MakeJobSocketAddress( path, address ) )
+    {
+    return -1;
+    }
+  const int descriptor = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+  if( descriptor < 0 )
+    {
+    return -1;
+    }
+  if( ::connect( descriptor, reinterpret_cast< sockaddr * >( &address ),
+                 sizeof( address ) ) != 0 )
+    {
+    ::close( descriptor );
+    return -1;
+    }
+  return descriptor;
+}
+
+} // end namespace bridge
+
+#endif
@@ -0,0 +1,304 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __MemoryAccountant_h
+#define __MemoryAccountant_h
+
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <itkCommand.h>
+#include <itkIntTypes.h>
+#include <itkObject.h>
+#include <itkTemporalRegion.h>
+
+#if !defined( _WIN32 )
+#include <sys/resource.h>
+#endif
+
+namespace bridge
+{
+
+/** \class MemoryAccountant
+ * \brief Bytes held by every stage of a pipeline, current and peak, with
+ * the peak resident set size of the process.
+ *
+ * A stage is a name and a function returning the bytes the stage holds:
+ * the buffer of a filter output (ImageBytes), the frames buffered by a
+ * VideoStream (VideoStreamBytes) or anything the executable computes itself.
+ * All the stages are sampled whenever a watched filter ends an update, and
+ * when Sample() is called. Record() sets the value of a stage directly, for
+ * buffers that only exist inside a function.
+ *
+ * This is the one high-water mechanism of the exercises: the image and
+ * bridge executables use it directly, and itk::VideoPipelineMemoryBudget
+ * samples the frames buffered by its streams through it. Executables that
+ * report other things as well only account when BRIDGE_MEMORY_REPORT is
+ * set to a non-zero value (IsRequested()). Memory a filter allocates
+ * internally and releases before its update ends, like the intermediate
+ * images of Canny, is not seen by the stage sampling but shows in the
+ * peak RSS.
+ */
+class MemoryAccountant
+{
+public:
+  typedef itk::SizeValueType                  SizeValueType;
+  typedef std::function< SizeValueType () >   ByteCounterType;
+
+  MemoryAccountant() :
+    m_CurrentBytes( 0 ),
+    m_PeakBytes( 0 )
+  {
+    m_SampleCommand = SampleCommandType::New();
+    m_SampleCommand->SetCallbackFunction( this, &MemoryAccountant::Sample );
+  }
+
+  ~MemoryAccountant()
+  {
+    for( size_t i = 0; i < m_Observed.size(); ++i )
+      {
+      m_Observed[i].first->RemoveObserver( m_Observed[i].second );
+      }
+  }
+
+  /** True when BRIDGE_MEMORY_REPORT asks for the accounting */
+  static bool IsRequested()
+  {
+    const char * value = std::getenv( "BRIDGE_MEMORY_REPORT" );
+    return value != 0 && *value != '\0' && std::string( value ) != "0";
+  }
+
+  /** Add a stage. If trigger is given, every stage is sampled when it ends
+   * an update. */
+  void AddStage( const std::string & name, const ByteCounterType & counter,
+                 itk::Object * trigger = 0 )
+  {
+    std::lock_guard< std::mutex > lock( m_Mutex );
+    this->FindStage( name ).Counter = counter;
+    if( trigger )
+      {
+      m_Observed.push_back( std::make_pair( trigger,
+        trigger->AddObserver( itk::EndEvent(), m_SampleCommand ) ) );
+      }
+  }
+
+  /** Set the bytes currently held by a stage, adding it if needed */
+  void Record( const std::string & name, SizeValueType bytes )
+  {
+    std::lock_guard< std::mutex > lock( m_Mutex );
+    Stage & stage = this->FindStage( name );
+    m_CurrentBytes = m_CurrentBytes - stage.Current + bytes;
+    stage.Current = bytes;
+    this->UpdatePeaks( stage );
+  }
+
+  /** Query every stage that has a byte counter */
+  void Sample()
+  {
+    std::lock_guard< std::mutex > lock( m_Mutex );
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+      {
+      Stage & stage = m_Stages[i];
+      if( stage.Counter )
+        {
+        const SizeValueType bytes = stage.Counter();
+        m_CurrentBytes = m_CurrentBytes - stage.Current + bytes;
+        stage.Current = bytes;
+        }
+      }
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+      {
+      this->UpdatePeaks( m_Stages[i] );
+      }
+  }
+
+  /** Current and peak bytes of a stage, 0 for an unknown stage */
+  SizeValueType GetStageCurrentBytes( const std::string & name ) const
+  {
+    std::lock_guard< std::mutex > lock( m_Mutex );
+    const Stage * stage = this->FindExistingStage( name );
+    return stage ? stage->Current : 0;
+  }
+
+  SizeValueType GetStagePeakBytes( const std::string & name ) const
+  {
+    std::lock_guard< std::mutex > lock( m_Mutex );
+    const Stage * stage = this->FindExistingStage( name );
+    return stage ? stage->Peak : 0;
+  }
+
+  /** Largest sum over the stages seen by a single sample or record */
+  SizeValueType GetPeakBytes() const
+  {
+    std::lock_guard< std::mutex > lock( m_Mutex );
+    return m_PeakBytes;
+  }
+
+  /** Peak resident set size of the process in bytes, 0 if unknown */
+  static SizeValueType GetPeakResidentSetSize()
+  {
+#if !defined( _WIN32 )
+    struct rusage usage;
+    if( getrusage( RUSAGE_SELF, &usage ) == 0 )
+      {
+#if defined( __APPLE__ )
+      return static_cast< SizeValueType >( usage.ru_maxrss );
+#else
+      return static_cast< SizeValueType >( usage.ru_maxrss ) * 1024;
+#endif
+      }
+#endif
+    return 0;
+  }
+
+  /** One line per stage with its current and peak bytes */
+  void Report( std::ostream & os ) const
+  {
+    std::lock_guard< std::mutex > lock( m_Mutex );
+    os << std::left << std::setw( 32 ) << "stage" << std::right
+       << std::setw( 14 ) << "current KiB"
+       << std::setw( 14 ) << "peak KiB" << std::endl;
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+      {
+      os << std::left << std::setw( 32 ) << m_Stages[i].Name << std::right
+         << std::setw( 14 ) << m_Stages[i].Current / 1024
+         << std::setw( 14 ) << m_Stages[i].Peak / 1024 << std::endl;
+      }
+    os << std::left << std::setw( 32 ) << "all stages" << std::right
+       << std::setw( 14 ) << m_CurrentBytes / 1024
+       << std::setw( 14 ) << m_PeakBytes / 1024 << std::endl;
+
+    const SizeValueType rss = GetPeakResidentSetSize();
+    os << "process peak RSS: ";
+    if( rss > 0 )
+      {
+      os << rss / 1024 << " KiB" << std::endl;
+      }
+    else
+      {
+      os << "unavailable" << std::endl;
+      }
+  }
+
+  /** Bytes of the pixel buffer of an image */
+  template< typename TImage >
+  static ByteCounterType ImageBytes( const TImage * image )
+  {
+    return [image]() -> SizeValueType
+      {
+      if( !image->GetPixelContainer() )
+        {
+        return 0;
+        }
+      return static_cast< SizeValueType >( image->GetPixelContainer()->Capacity() )
+        * sizeof( typename TImage::PixelContainer::Element );
+      };
+  }
+
+  /** Bytes of the frames in the buffered temporal region of a VideoStream */
+  template< typename TVideoStream >
+  static ByteCounterType VideoStreamBytes( TVideoStream * stream )
+  {
+    return [stream]() -> SizeValueType
+      {
+      const itk::TemporalRegion buffered = stream->GetBufferedTemporalRegion();
+      SizeValueType bytes = 0;
+      for( SizeValueType i = 0; i < buffered.GetFrameDuration(); ++i )
+        {
+        const typename TVideoStream::FrameType * frame =
+          stream->GetFrame( buffered.GetFrameStart() + i );
+        if( frame )
+          {
+          bytes += ImageBytes( frame )();
+          }
+        }
+      return bytes;
+      };
+  }
+
+private:
+  MemoryAccountant( const MemoryAccountant & ); //purposely not implemented
+  void operator=( const MemoryAccountant & );   //purposely not implemented
+
+  struct Stage
+    {
+    std::string     Name;
+    ByteCounterType Counter;
+    SizeValueType   Current;
+    SizeValueType   Peak;
+    };
+
+  typedef itk::SimpleMemberCommand< MemoryAccountant > SampleCommandType;
+
+  const Stage * FindExistingStage( const std::string & name ) const
+  {
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+      {
+      if( m_Stages[i].Name == name )
+        {
+        return &m_Stages[i];
+        }
+      }
+    return 0;
+  }
+
+  Stage & FindStage( const std::string & name )
+  {
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+      {
+      if( m_Stages[i].Name == name )
+        {
+        return m_Stages[i];
+        }
+      }
+    Stage stage;
+    stage.Name = name;
+    stage.Current = 0;
+    stage.Peak = 0;
+    m_Stages.push_back( stage );
+    return m_Stages.back();
+  }
+
+  void UpdatePeaks( Stage & stage )
+  {
+    if( stage.Current > stage.Peak )
+      {
+      stage.Peak = stage.Current;
+      }
+    if( m_CurrentBytes > m_PeakBytes )
+      {
+      m_PeakBytes = m_CurrentBytes;
+      }
+  }
+
+  mutable std::mutex                                             m_Mutex;
+  std::vector< Stage >                                           m_Stages;
+  std::vector< std::pair< itk::Object::Pointer, unsigned long > > m_Observed;
+  SampleCommandType::Pointer                                     m_SampleCommand;
+  SizeValueType                                                  m_CurrentBytes;
+  SizeValueType                                                  m_PeakBytes;
+};
+
+} // end namespace bridge
+
+#endif
@@ -0,0 +1,91 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __PooledFrameImport_h
+#define __PooledFrameImport_h
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <itkImage.h>
+
+#include "itkFrameBufferPool.h"
+
+namespace bridge
+{
+
+typedef itk::Image< unsigned char, 2 >       GrayFrameType;
+typedef itk::FrameBufferPool< GrayFrameType > GrayFramePoolType;
+
+/** Convert a BGR, BGRA or gray cv::Mat into a gray ITK frame taken from the
+ * pool. OpenCV writes the gray levels straight into the ITK buffer, with
+ * the same color conversion as itk::OpenCVImageBridge. Pixels of another
+ * depth than 8 bits are saturated to unsigned char. */
+inline GrayFrameType::Pointer
+ImportGrayFrame( const cv::Mat & inputImage, GrayFramePoolType * pool )
+{
+  GrayFrameType::RegionType region;
+  region.SetSize( 0, inputImage.cols );
+  region.SetSize( 1, inputImage.rows );
+  pool->SetFrameRegion( region );
+
+  GrayFrameType::Pointer itkFrame = pool->Acquire();
+
+  // OpenCV reallocates a destination of another type instead of writing
+  // into it, so every path below must produce CV_8UC1
+  cv::Mat itkView( inputImage.rows, inputImage.cols, CV_8UC1,
+                   itkFrame->GetBufferPointer() );
+  cv::Mat gray = inputImage;
+  if( inputImage.channels() == 3 || inputImage.channels() == 4 )
+    {
+    const int code = inputImage.channels() == 4 ? CV_BGRA2GRAY : CV_BGR2GRAY;
+    if( inputImage.depth() == CV_8U )
+      {
+      cv::cvtColor( inputImage, itkView, code );
+      }
+    else
+      {
+      cv::cvtColor( inputImage, gray, code );
+      }
+    }
+  else if( inputImage.channels() != 1 )
+    {
+    itkGenericExceptionMacro( << "Unsupported number of channels: "
+                              << inputImage.channels() );
+    }
+  if( gray.channels() == 1 )
+    {
+    if( gray.depth() == CV_8U )
+      {
+      gray.copyTo( itkView );
+      }
+    else
+      {
+      gray.convertTo( itkView, CV_8U );
+      }
+    }
+  if( itkView.data != itkFrame->GetBufferPointer() )
+    {
+    itkGenericExceptionMacro( << "The frame was not converted in place" );
+    }
+  itkFrame->Modified();
+
+  return itkFrame;
+}
+
+} // end namespace bridge
+
+#endif
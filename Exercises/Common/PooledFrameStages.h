@@ -0,0 +1,118 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __PooledFrameStages_h
+#define __PooledFrameStages_h
+
+#include <deque>
+
+#include <itkImageRegionIterator.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkNumericTraits.h>
+
+#include "itkFrameBufferPool.h"
+
+namespace bridge
+{
+
+/** Run an image filter on a single frame, writing into a frame taken from
+ * the pool so that the result can move downstream while the filter works
+ * on the next frame. The filter lets go of its input and of the grafted
+ * buffer before returning, so both can go back to their pools. */
+template< typename TFilter, typename TPool >
+typename TFilter::OutputImageType::Pointer
+RunPooledFilter( TFilter * filter, const typename TFilter::InputImageType * input,
+                 TPool * pool )
+{
+  typename TFilter::OutputImageType::Pointer output = pool->Acquire();
+  filter->SetInput( input );
+  filter->GraftOutput( output );
+  filter->Update();
+  output->Graft( filter->GetOutput() );
+  filter->SetInput( NULL );
+  filter->GetOutput()->ReleaseData();
+  return output;
+}
+
+/** \class FrameDifferenceStage
+ * \brief Per-frame stage computing the difference of a frame with the
+ * frame FrameOffset frames earlier.
+ *
+ * The arithmetic is the one of itk::FrameDifferenceVideoFilter: the
+ * squared difference of the two frames, cast to the pixel type. The
+ * differences are written into frames taken from the pool. The first
+ * FrameOffset frames only fill the history and produce no output, so the
+ * outputs are numbered from FrameOffset as for the video filter.
+ */
+template< typename TFrame >
+class FrameDifferenceStage
+{
+public:
+  typedef TFrame                             FrameType;
+  typedef typename FrameType::Pointer        FramePointer;
+  typedef typename FrameType::PixelType      PixelType;
+  typedef itk::FrameBufferPool< FrameType >  PoolType;
+
+  FrameDifferenceStage( itk::SizeValueType frameOffset, PoolType * pool ) :
+    m_FrameOffset( frameOffset ),
+    m_Pool( pool )
+  {
+  }
+
+  /** Replace frame by its difference with the frame FrameOffset frames
+   * earlier. Returns false, and drops the frame downstream, while the
+   * history fills. */
+  bool Process( FramePointer & frame )
+  {
+    m_History.push_back( frame );
+    if( m_History.size() <= m_FrameOffset )
+      {
+      return false;
+      }
+    FramePointer previous = m_History.front();
+    m_History.pop_front();
+
+    FramePointer difference = m_Pool->Acquire();
+    difference->CopyInformation( frame );
+
+    typedef typename itk::NumericTraits< PixelType >::RealType DifferenceRealType;
+    typedef itk::ImageRegionConstIterator< FrameType >         ConstIterType;
+    typedef itk::ImageRegionIterator< FrameType >              IterType;
+    ConstIterType previousIt( previous, previous->GetBufferedRegion() );
+    ConstIterType currentIt( frame, frame->GetBufferedRegion() );
+    IterType outputIt( difference, difference->GetBufferedRegion() );
+    for( ; !outputIt.IsAtEnd(); ++previousIt, ++currentIt, ++outputIt )
+      {
+      DifferenceRealType value =
+        static_cast< DifferenceRealType >( previousIt.Get() ) -
+        static_cast< DifferenceRealType >( currentIt.Get() );
+      value *= value;
+      outputIt.Set( static_cast< PixelType >( value ) );
+      }
+    frame = difference;
+    return true;
+  }
+
+private:
+  itk::SizeValueType         m_FrameOffset;
+  PoolType *                 m_Pool;
+  std::deque< FramePointer > m_History;
+};
+
+} // end namespace bridge
+
+#endif
@@ -0,0 +1,197 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __RegionBridge_h
+#define __RegionBridge_h
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <itkImage.h>
+
+#include "itkAlignedImportImageContainer.h"
+#include "FrameBatch.h"
+
+namespace bridge
+{
+
+/** Byte boundary of the buffers allocated by the functions below: a cache
+ * line, and the width of the widest SIMD registers */
+const size_t BufferAlignment = 64;
+
+/** A Mat whose first row and row step are multiples of alignment bytes.
+ * It is the aligned window of a larger allocation, so its step is larger
+ * than cols * elemSize() unless the rows are already aligned. */
+inline cv::Mat CreateAlignedMat( const cv::Size & size, int type,
+                                 size_t alignment = BufferAlignment )
+{
+  const size_t elementSize = CV_ELEM_SIZE( type );
+  const size_t rowBytes = size.width * elementSize;
+  const size_t step = ( rowBytes + alignment - 1 ) / alignment * alignment;
+  // One more aligned block to shift the start on the boundary
+  cv::Mat storage( size.height + 1, static_cast< int >( step ), CV_8UC1 );
+  const size_t address = reinterpret_cast< size_t >( storage.data );
+  const size_t shift = ( alignment - address % alignment ) % alignment;
+  cv::Mat aligned( size.height, size.width, type, storage.data + shift, step );
+  // The header shares the reference count of the storage
+  aligned.refcount = storage.refcount;
+  aligned.addref();
+  aligned.datastart = storage.datastart;
+  aligned.dataend = storage.dataend;
+  aligned.datalimit = storage.datalimit;
+  return aligned;
+}
+
+/** Allocate an image whose buffer starts on an alignment byte boundary.
+ * The image keeps its buffer when it already has this region. */
+template< typename TImage >
+void AllocateAlignedImage( TImage * image, const typename TImage::RegionType & region,
+                           size_t alignment = BufferAlignment )
+{
+  typedef itk::AlignedImportImageContainer< itk::SizeValueType,
+                                            typename TImage::PixelType >
+                                              ContainerType;
+  ContainerType * current =
+    dynamic_cast< ContainerType * >( image->GetPixelContainer() );
+  typename ContainerType::Pointer container = current;
+  if( !container || container->GetAlignment() != alignment )
+    {
+    container = ContainerType::New();
+    container->SetAlignment( alignment );
+    }
+  image->SetRegions( region );
+  container->AllocateAligned( region.GetNumberOfPixels() );
+  image->SetPixelContainer( container );
+}
+
+/** OpenCV header on the buffer of a 2D image */
+template< typename TImage >
+cv::Mat ImageView( const TImage * image )
+{
+  const typename TImage::SizeType size = image->GetBufferedRegion().GetSize();
+  return cv::Mat( static_cast< int >( size[1] ), static_cast< int >( size[0] ),
+                  cv::DataType< typename TImage::PixelType >::type,
+                  const_cast< typename TImage::PixelType * >(
+                    image->GetBufferPointer() ) );
+}
+
+/** Convert the roi of a Mat into a gray 2D ITK image, reading only the
+ * rows of the roi through cv::Mat::step: ROI views and padded Mats need no
+ * clone. Color conversion, as in itk::OpenCVImageBridge, and depth
+ * conversion are done in the same pass. The image origin is the position of
+ * the roi in the Mat, so that the results map back onto the frame. The
+ * buffer of the image is aligned, and reused when image is given with the
+ * size of the roi. */
+template< typename TImage >
+typename TImage::Pointer
+MatRegionToITKImage( const cv::Mat & mat, const cv::Rect & roi,
+                     TImage * image = NULL )
+{
+  const cv::Rect clipped = roi & cv::Rect( 0, 0, mat.cols, mat.rows );
+  if( clipped.area() == 0 )
+    {
+    itkGenericExceptionMacro( << "The region is outside of the "
+                              << mat.cols << "x" << mat.rows << " image" );
+    }
+
+  typename TImage::Pointer output = image;
+  if( !output )
+    {
+    output = TImage::New();
+    }
+  typename TImage::RegionType region;
+  region.SetSize( 0, clipped.width );
+  region.SetSize( 1, clipped.height );
+  if( output->GetBufferedRegion() != region || !output->GetBufferPointer() )
+    {
+    AllocateAlignedImage( output.GetPointer(), region );
+    }
+
+  typename TImage::PointType origin;
+  origin[0] = clipped.x;
+  origin[1] = clipped.y;
+  output->SetOrigin( origin );
+
+  // mat( clipped ) is a header, the pixels are read once, row by row
+  cv::Mat view = ImageView( output.GetPointer() );
+  ConvertToGrayView( mat( clipped ), view );
+  output->Modified();
+  return output;
+}
+
+/** Convert the whole Mat, which may be a ROI view or padded */
+template< typename TImage >
+typename TImage::Pointer
+MatRegionToITKImage( const cv::Mat & mat, TImage * image = NULL )
+{
+  return MatRegionToITKImage< TImage >( mat,
+    cv::Rect( 0, 0, mat.cols, mat.rows ), image );
+}
+
+/** Write a 2D ITK image into the roi of a Mat, e.g. to paste the result of
+ * a cropped analysis back into the frame, without a full frame copy. Only
+ * the rows of the roi are written, through cv::Mat::step. A gray image
+ * goes into every channel of a color Mat, and is converted to its depth.
+ * The roi must have the size of the image. */
+template< typename TImage >
+void ITKImageToMatRegion( const TImage * image, cv::Mat & mat,
+                          const cv::Rect & roi )
+{
+  const cv::Mat source = ImageView( image );
+  if( roi.size() != source.size() ||
+      ( roi & cv::Rect( 0, 0, mat.cols, mat.rows ) ) != roi )
+    {
+    itkGenericExceptionMacro( << "The " << source.cols << "x" << source.rows
+                              << " image does not fit the region of the Mat" );
+    }
+
+  cv::Mat target = mat( roi );
+  if( mat.channels() > 1 )
+    {
+    const int code = mat.channels() == 4 ? CV_GRAY2BGRA : CV_GRAY2BGR;
+    if( source.depth() == mat.depth() )
+      {
+      cv::cvtColor( source, target, code );
+      return;
+      }
+    cv::Mat converted;
+    source.convertTo( converted, mat.depth() );
+    cv::cvtColor( converted, target, code );
+    }
+  else if( source.depth() == mat.depth() )
+    {
+    source.copyTo( target );
+    }
+  else
+    {
+    source.convertTo( target, mat.depth() );
+    }
+}
+
+/** Convert a 2D ITK image into a new gray Mat with aligned rows */
+template< typename TImage >
+cv::Mat ITKImageToAlignedMat( const TImage * image )
+{
+  const cv::Mat source = ImageView( image );
+  cv::Mat output = CreateAlignedMat( source.size(), source.type() );
+  source.copyTo( output );
+  return output;
+}
+
+} // end namespace bridge
+
+#endif
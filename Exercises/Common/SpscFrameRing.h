@@ -0,0 +1,248 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __SpscFrameRing_h
+#define __SpscFrameRing_h
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bridge
+{
+
+/** \class SpscFrameRing
+ * \brief Lock-free ring buffer handing frames from one producer thread to
+ * one consumer thread.
+ *
+ * The slots are allocated once. Frames are exchanged with the slots by
+ * swapping, never copied: TryPush() leaves the caller with the frame the
+ * consumer handed back through that slot earlier, and TryPop() leaves the
+ * slot with the frame the consumer is done with. With cv::Mat frames the
+ * producer thus decodes into recycled buffers, which means the consumer
+ * must not keep references to a frame once it has popped the next one.
+ *
+ * Only the head and tail counters are shared, each on its own cache line,
+ * and they are synchronized with acquire/release atomics. TryPush() and
+ * TryPop() never block. Push() and Pop() spin briefly, then sleep on a
+ * condition variable until they can proceed or the ring is closed; the
+ * mutex is only touched when one side actually sleeps. Exactly one thread
+ * may push and exactly one thread may pop.
+ */
+template< typename TFrame >
+class SpscFrameRing
+{
+public:
+  typedef TFrame FrameType;
+
+  explicit SpscFrameRing( size_t capacity ) :
+    m_Slots( std::max< size_t >( capacity, 1 ) ),
+    m_Head( 0 ),
+    m_Tail( 0 ),
+    m_Closed( false ),
+    m_ProducerWaiting( false ),
+    m_ConsumerWaiting( false )
+  {
+  }
+
+  /** Exchange frame with a free slot. Returns false if the ring is full. */
+  bool TryPush( FrameType & frame )
+  {
+    const size_t tail = m_Tail.load( std::memory_order_relaxed );
+    if( tail - m_Head.load( std::memory_order_acquire ) == m_Slots.size() )
+      {
+      return false;
+      }
+    std::swap( m_Slots[tail % m_Slots.size()], frame );
+    m_Tail.store( tail + 1, std::memory_order_release );
+    return true;
+  }
+
+  /** Exchange frame with the oldest frame. Returns false if the ring is
+   * empty. */
+  bool TryPop( FrameType & frame )
+  {
+    const size_t head = m_Head.load( std::memory_order_relaxed );
+    if( head == m_Tail.load( std::memory_order_acquire ) )
+      {
+      return false;
+      }
+    std::swap( m_Slots[head % m_Slots.size()], frame );
+    m_Head.store( head + 1, std::memory_order_release );
+    return true;
+  }
+
+  /** Push without waiting, for a producer that cannot be held up such as
+   * a live camera. Returns false if the ring is full; the caller keeps the
+   * frame. */
+  bool Offer( FrameType & frame )
+  {
+    if( !this->TryPush( frame ) )
+      {
+      return false;
+      }
+    this->WakeUp( m_ConsumerWaiting );
+    return true;
+  }
+
+  /** Wait for a free slot. Returns false if the ring was closed first. */
+  bool Push( FrameType & frame )
+  {
+    if( this->Spin( [&] { return this->TryPush( frame ); } ) )
+      {
+      this->WakeUp( m_ConsumerWaiting );
+      return true;
+      }
+    for(;;)
+      {
+      if( this->TryPush( frame ) )
+        {
+        this->WakeUp( m_ConsumerWaiting );
+        return true;
+        }
+      if( this->IsClosed() )
+        {
+        return false;
+        }
+      this->Park( m_ProducerWaiting, [this]
+        { return this->IsClosed() || !this->IsFull(); } );
+      }
+  }
+
+  /** Wait for a frame. Returns false once the ring is closed and empty. */
+  bool Pop( FrameType & frame )
+  {
+    if( this->Spin( [&] { return this->TryPop( frame ); } ) )
+      {
+      this->WakeUp( m_ProducerWaiting );
+      return true;
+      }
+    for(;;)
+      {
+      if( this->TryPop( frame ) )
+        {
+        this->WakeUp( m_ProducerWaiting );
+        return true;
+        }
+      if( this->IsClosed() )
+        {
+        // A frame pushed just before Close() must not be lost
+        return this->TryPop( frame );
+        }
+      this->Park( m_ConsumerWaiting, [this]
+        { return this->IsClosed() || !this->IsEmpty(); } );
+      }
+  }
+
+  /** No more frames will be pushed. Wakes up the waiting thread. */
+  void Close()
+  {
+    m_Closed.store( true, std::memory_order_seq_cst );
+    std::lock_guard< std::mutex > lock( m_ParkingMutex );
+    m_Parking.notify_all();
+  }
+
+  bool IsClosed() const
+  {
+    return m_Closed.load( std::memory_order_acquire );
+  }
+
+  size_t GetCapacity() const
+  {
+    return m_Slots.size();
+  }
+
+private:
+  SpscFrameRing( const SpscFrameRing & ); //purposely not implemented
+  void operator=( const SpscFrameRing & ); //purposely not implemented
+
+  bool IsEmpty() const
+  {
+    return m_Head.load( std::memory_order_acquire ) ==
+      m_Tail.load( std::memory_order_acquire );
+  }
+
+  bool IsFull() const
+  {
+    return m_Tail.load( std::memory_order_acquire ) -
+      m_Head.load( std::memory_order_acquire ) == m_Slots.size();
+  }
+
+  // Retry an operation for a short while: when the other thread is about to
+  // proceed this is much faster than going to sleep. Spinning is pointless
+  // on a single core, where it only delays the other thread.
+  template< typename TOperation >
+  static bool Spin( TOperation operation )
+  {
+    static const unsigned int spins =
+      std::thread::hardware_concurrency() > 1 ? 4000 : 0;
+    for( unsigned int i = 0; i < spins; ++i )
+      {
+      if( operation() )
+        {
+        return true;
+        }
+      }
+    return false;
+  }
+
+  // Sleep until ready() holds. The waiting flag tells the other thread that
+  // it has to wake us up. The fences order setting the flag before checking
+  // ready(), and the other thread's update before its flag check in
+  // WakeUp(), so a wake-up cannot be missed.
+  template< typename TPredicate >
+  void Park( std::atomic< bool > & waiting, TPredicate ready )
+  {
+    std::unique_lock< std::mutex > lock( m_ParkingMutex );
+    waiting.store( true, std::memory_order_seq_cst );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    m_Parking.wait( lock, ready );
+    waiting.store( false, std::memory_order_relaxed );
+  }
+
+  void WakeUp( std::atomic< bool > & waiting )
+  {
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    if( waiting.load( std::memory_order_seq_cst ) )
+      {
+      std::lock_guard< std::mutex > lock( m_ParkingMutex );
+      m_Parking.notify_all();
+      }
+  }
+
+  std::vector< FrameType > m_Slots;
+
+  // Written by the consumer only
+  alignas( 64 ) std::atomic< size_t > m_Head;
+  // Written by the producer only
+  alignas( 64 ) std::atomic< size_t > m_Tail;
+  alignas( 64 ) std::atomic< bool >   m_Closed;
+  std::atomic< bool >                 m_ProducerWaiting;
+  std::atomic< bool >                 m_ConsumerWaiting;
+
+  // Only used when a thread has to sleep
+  std::mutex                          m_ParkingMutex;
+  std::condition_variable             m_Parking;
+};
+
+} // end namespace bridge
+
+#endif
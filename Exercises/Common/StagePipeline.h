@@ -0,0 +1,219 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __StagePipeline_h
+#define __StagePipeline_h
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BoundedFrameQueue.h"
+
+namespace bridge
+{
+
+/** \class StagePipeline
+ * \brief Run a chain of per-frame stages, each on its own thread.
+ *
+ * The source produces tokens (usually a frame and its index) that travel
+ * through the stages in order. Consecutive stages are connected by a
+ * BoundedFrameQueue, so while stage i works on frame N, stage i-1 can
+ * already work on frame N+1 and no stage runs more than the queue capacity
+ * ahead of the next one. A stage returns false to drop a token, which lets
+ * temporal stages swallow the frames that only prime their history.
+ *
+ * Tokens leave the pipeline through Pop() in the order the source produced
+ * them. An exception thrown by the source or a stage stops the pipeline
+ * and is rethrown by Pop().
+ */
+template< typename TToken >
+class StagePipeline
+{
+public:
+  typedef TToken                                TokenType;
+  typedef std::function< bool ( TokenType & ) > SourceType;
+  typedef std::function< bool ( TokenType & ) > StageType;
+  typedef std::function< void ( size_t ) >      ThreadStartType;
+  typedef BoundedFrameQueue< TokenType >        QueueType;
+
+  explicit StagePipeline( size_t queueCapacity ) :
+    m_QueueCapacity( queueCapacity )
+  {
+  }
+
+  ~StagePipeline()
+  {
+    this->Stop();
+  }
+
+  /** The source fills in the next token and returns false at the end */
+  void SetSource( const SourceType & source )
+  {
+    m_Source = source;
+  }
+
+  /** Append a stage to the chain */
+  void AddStage( const StageType & stage )
+  {
+    m_Stages.push_back( stage );
+  }
+
+  /** Run on every thread of the pipeline before it starts working, with 0
+   * for the source and i + 1 for stage i, e.g. to pin it to a core */
+  void SetThreadStart( const ThreadStartType & start )
+  {
+    m_ThreadStart = start;
+  }
+
+  /** Number of threads started by Start() */
+  size_t GetNumberOfThreads() const
+  {
+    return m_Stages.size() + 1;
+  }
+
+  /** Launch one thread for the source and one for every stage */
+  void Start()
+  {
+    m_Queues.clear();
+    for( size_t i = 0; i <= m_Stages.size(); ++i )
+      {
+      m_Queues.push_back(
+        std::unique_ptr< QueueType >( new QueueType( m_QueueCapacity ) ) );
+      }
+
+    m_Threads.push_back( std::thread( &StagePipeline::RunSource, this ) );
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+      {
+      m_Threads.push_back( std::thread( &StagePipeline::RunStage, this, i ) );
+      }
+  }
+
+  /** Get the next token out of the last stage. Returns false at the end of
+   * the stream. */
+  bool Pop( TokenType & token )
+  {
+    if( m_Queues.back()->Pop( token ) )
+      {
+      return true;
+      }
+    this->Stop();
+    if( m_Error )
+      {
+      std::rethrow_exception( m_Error );
+      }
+    return false;
+  }
+
+  /** Close all the queues and wait for the threads */
+  void Stop()
+  {
+    for( size_t i = 0; i < m_Queues.size(); ++i )
+      {
+      m_Queues[i]->Close();
+      }
+    for( size_t i = 0; i < m_Threads.size(); ++i )
+      {
+      if( m_Threads[i].joinable() )
+        {
+        m_Threads[i].join();
+        }
+      }
+    m_Threads.clear();
+  }
+
+private:
+  StagePipeline( const StagePipeline & ); //purposely not implemented
+  void operator=( const StagePipeline & ); //purposely not implemented
+
+  void RunSource()
+  {
+    try
+      {
+      if( m_ThreadStart )
+        {
+        m_ThreadStart( 0 );
+        }
+      TokenType token;
+      while( m_Source( token ) && m_Queues.front()->Push( token ) )
+        {
+        token = TokenType();
+        }
+      m_Queues.front()->Close();
+      }
+    catch( ... )
+      {
+      this->Abort( std::current_exception() );
+      }
+  }
+
+  void RunStage( size_t stage )
+  {
+    try
+      {
+      if( m_ThreadStart )
+        {
+        m_ThreadStart( stage + 1 );
+        }
+      TokenType token;
+      while( m_Queues[stage]->Pop( token ) )
+        {
+        if( m_Stages[stage]( token ) && !m_Queues[stage + 1]->Push( token ) )
+          {
+          break;
+          }
+        token = TokenType();
+        }
+      m_Queues[stage + 1]->Close();
+      }
+    catch( ... )
+      {
+      this->Abort( std::current_exception() );
+      }
+  }
+
+  void Abort( std::exception_ptr error )
+  {
+    {
+    std::lock_guard< std::mutex > lock( m_ErrorMutex );
+    if( !m_Error )
+      {
+      m_Error = error;
+      }
+    }
+    for( size_t i = 0; i < m_Queues.size(); ++i )
+      {
+      m_Queues[i]->Close();
+      }
+  }
+
+  size_t                                     m_QueueCapacity;
+  SourceType                                 m_Source;
+  ThreadStartType                            m_ThreadStart;
+  std::vector< StageType >                   m_Stages;
+  std::vector< std::unique_ptr< QueueType > > m_Queues;
+  std::vector< std::thread >                 m_Threads;
+  std::mutex                                 m_ErrorMutex;
+  std::exception_ptr                         m_Error;
+};
+
+} // end namespace bridge
+
+#endif
@@ -0,0 +1,180 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __StaticFramePipeline_h
+#define __StaticFramePipeline_h
+
+#include <type_traits>
+
+namespace bridge
+{
+
+/** \class StaticFramePipeline
+ * \brief Chain of per-frame stages fixed at compile time.
+ *
+ * The stages are template parameters, so the chain is resolved by the
+ * compiler: Process() calls the stages one after the other, with no
+ * modified-time propagation, no region negotiation between the stages and
+ * no virtual dispatch. Each stage writes into an image owned by the
+ * pipeline, allocated for the first frame and reused as long as the frame
+ * size does not change.
+ *
+ * A stage is a class with InputImageType and OutputImageType typedefs and
+ * a method
+ *
+ *   void Process( const InputImageType * input, OutputImageType * output );
+ *
+ * which receives an output with the buffered region of the input already
+ * allocated. See StaticFrameStages.h for the stages of the exercises.
+ */
+template< typename... TStages >
+class StaticFramePipeline;
+
+namespace detail
+{
+
+// Allocate image with the geometry of reference, unless it already has it
+template< typename TImage, typename TReference >
+void AllocateLike( typename TImage::Pointer & image, const TReference * reference )
+{
+  if( image.IsNull() )
+    {
+    image = TImage::New();
+    }
+  if( image->GetBufferedRegion() != reference->GetBufferedRegion() ||
+      image->GetBufferPointer() == 0 )
+    {
+    image->CopyInformation( reference );
+    image->SetRegions( reference->GetBufferedRegion() );
+    image->Allocate();
+    }
+  else
+    {
+    image->SetSpacing( reference->GetSpacing() );
+    image->SetOrigin( reference->GetOrigin() );
+    image->SetDirection( reference->GetDirection() );
+    }
+}
+
+// Type of the Nth stage
+template< unsigned int N, typename TPipeline >
+struct StageAt;
+
+template< typename TStage, typename... TRest >
+struct StageAt< 0, StaticFramePipeline< TStage, TRest... > >
+{
+  typedef TStage Type;
+  static Type & Get( StaticFramePipeline< TStage, TRest... > & pipeline )
+  {
+    return pipeline.GetFirstStage();
+  }
+};
+
+template< unsigned int N, typename TStage, typename... TRest >
+struct StageAt< N, StaticFramePipeline< TStage, TRest... > >
+{
+  typedef StageAt< N - 1, StaticFramePipeline< TRest... > > NextType;
+  typedef typename NextType::Type                            Type;
+  static Type & Get( StaticFramePipeline< TStage, TRest... > & pipeline )
+  {
+    return NextType::Get( pipeline.GetRemainingStages() );
+  }
+};
+
+} // end namespace detail
+
+/** Last stage: writes into the output image of the pipeline */
+template< typename TStage >
+class StaticFramePipeline< TStage >
+{
+public:
+  typedef typename TStage::InputImageType  InputImageType;
+  typedef typename TStage::OutputImageType OutputImageType;
+
+  /** Run the chain on a frame. The output is overwritten by the next call. */
+  const OutputImageType * Process( const InputImageType * input )
+  {
+    detail::AllocateLike< OutputImageType >( m_Output, input );
+    m_Stage.Process( input, m_Output.GetPointer() );
+    return m_Output.GetPointer();
+  }
+
+  /** Access to the Nth stage, to set its parameters */
+  template< unsigned int N >
+  typename detail::StageAt< N, StaticFramePipeline >::Type & GetStage()
+  {
+    return detail::StageAt< N, StaticFramePipeline >::Get( *this );
+  }
+
+  TStage & GetFirstStage()
+  {
+    return m_Stage;
+  }
+
+private:
+  TStage                            m_Stage;
+  typename OutputImageType::Pointer m_Output;
+};
+
+/** First stage of a chain and the rest of the chain */
+template< typename TStage, typename TNextStage, typename... TRest >
+class StaticFramePipeline< TStage, TNextStage, TRest... >
+{
+public:
+  typedef StaticFramePipeline< TNextStage, TRest... >      RemainingStagesType;
+  typedef typename TStage::InputImageType                  InputImageType;
+  typedef typename TStage::OutputImageType                 IntermediateImageType;
+  typedef typename RemainingStagesType::OutputImageType    OutputImageType;
+
+  static_assert( std::is_same< IntermediateImageType,
+                   typename TNextStage::InputImageType >::value,
+                 "The output of a stage must be the input of the next one" );
+
+  /** Run the chain on a frame. The output is overwritten by the next call. */
+  const OutputImageType * Process( const InputImageType * input )
+  {
+    detail::AllocateLike< IntermediateImageType >( m_Intermediate, input );
+    m_Stage.Process( input, m_Intermediate.GetPointer() );
+    return m_RemainingStages.Process( m_Intermediate.GetPointer() );
+  }
+
+  /** Access to the Nth stage, to set its parameters */
+  template< unsigned int N >
+  typename detail::StageAt< N, StaticFramePipeline >::Type & GetStage()
+  {
+    return detail::StageAt< N, StaticFramePipeline >::Get( *this );
+  }
+
+  TStage & GetFirstStage()
+  {
+    return m_Stage;
+  }
+
+  RemainingStagesType & GetRemainingStages()
+  {
+    return m_RemainingStages;
+  }
+
+private:
+  TStage                                  m_Stage;
+  typename IntermediateImageType::Pointer m_Intermediate;
+  RemainingStagesType                     m_RemainingStages;
+};
+
+} // end namespace bridge
+
+#endif
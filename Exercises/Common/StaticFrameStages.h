@@ -0,0 +1,201 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __StaticFrameStages_h
+#define __StaticFrameStages_h
+
+#include <algorithm>
+
+#include <itkImage.h>
+#include <itkCannyEdgeDetectionImageFilter.h>
+#include <itkRescaleIntensityImageFilter.h>
+
+#include "StaticFramePipeline.h"
+
+namespace bridge
+{
+
+/** \class CastStage
+ * \brief Pixel type conversion, the StaticFramePipeline counterpart of
+ * itk::CastImageFilter. A plain loop over the buffer.
+ */
+template< typename TInputImage, typename TOutputImage >
+class CastStage
+{
+public:
+  typedef TInputImage                          InputImageType;
+  typedef TOutputImage                         OutputImageType;
+  typedef typename TInputImage::PixelType      InputPixelType;
+  typedef typename TOutputImage::PixelType     OutputPixelType;
+
+  void Process( const InputImageType * input, OutputImageType * output )
+  {
+    const InputPixelType * in = input->GetBufferPointer();
+    OutputPixelType * out = output->GetBufferPointer();
+    const itk::SizeValueType numberOfPixels =
+      input->GetBufferedRegion().GetNumberOfPixels();
+    for( itk::SizeValueType i = 0; i < numberOfPixels; ++i )
+      {
+      out[i] = static_cast< OutputPixelType >( in[i] );
+      }
+  }
+};
+
+/** \class ImageFilterStage
+ * \brief Runs an ITK filter as a stage.
+ *
+ * The filter is created once and its output grafted into the image of the
+ * pipeline, so the filter keeps reusing the same buffer. Only this filter
+ * goes through Update(): there is no upstream pipeline to walk. For filters
+ * without a cheaper equivalent, like Canny.
+ */
+template< typename TFilter >
+class ImageFilterStage
+{
+public:
+  typedef TFilter                              FilterType;
+  typedef typename TFilter::InputImageType     InputImageType;
+  typedef typename TFilter::OutputImageType    OutputImageType;
+
+  ImageFilterStage()
+  {
+    m_Filter = FilterType::New();
+  }
+
+  FilterType * GetFilter()
+  {
+    return m_Filter;
+  }
+
+  void Process( const InputImageType * input, OutputImageType * output )
+  {
+    m_Filter->SetInput( input );
+    // The input buffer was rewritten in place by the previous stage, which
+    // ITK cannot see
+    m_Filter->Modified();
+    m_Filter->Update();
+    output->Graft( m_Filter->GetOutput() );
+  }
+
+private:
+  typename FilterType::Pointer m_Filter;
+};
+
+/** \class RescaleStage
+ * \brief Linear intensity rescaling to the full range of the output pixel
+ * type, computed like itk::RescaleIntensityImageFilter and with its
+ * transform functor, so the output is the same.
+ */
+template< typename TInputImage, typename TOutputImage >
+class RescaleStage
+{
+public:
+  typedef TInputImage                          InputImageType;
+  typedef TOutputImage                         OutputImageType;
+  typedef typename TInputImage::PixelType      InputPixelType;
+  typedef typename TOutputImage::PixelType     OutputPixelType;
+  typedef typename itk::NumericTraits< InputPixelType >::RealType RealType;
+  typedef itk::Functor::IntensityLinearTransform< InputPixelType, OutputPixelType >
+                                               FunctorType;
+
+  RescaleStage() :
+    m_OutputMinimum( itk::NumericTraits< OutputPixelType >::NonpositiveMin() ),
+    m_OutputMaximum( itk::NumericTraits< OutputPixelType >::max() )
+  {
+  }
+
+  void SetOutputMinimum( OutputPixelType value )
+  {
+    m_OutputMinimum = value;
+  }
+
+  void SetOutputMaximum( OutputPixelType value )
+  {
+    m_OutputMaximum = value;
+  }
+
+  void Process( const InputImageType * input, OutputImageType * output )
+  {
+    const InputPixelType * in = input->GetBufferPointer();
+    OutputPixelType * out = output->GetBufferPointer();
+    const itk::SizeValueType numberOfPixels =
+      input->GetBufferedRegion().GetNumberOfPixels();
+    if( numberOfPixels == 0 )
+      {
+      return;
+      }
+
+    InputPixelType inputMinimum = in[0];
+    InputPixelType inputMaximum = in[0];
+    for( itk::SizeValueType i = 1; i < numberOfPixels; ++i )
+      {
+      inputMinimum = std::min( inputMinimum, in[i] );
+      inputMaximum = std::max( inputMaximum, in[i] );
+      }
+
+    // Same scale and shift as RescaleIntensityImageFilter
+    RealType scale;
+    if( inputMinimum != inputMaximum )
+      {
+      scale = ( static_cast< RealType >( m_OutputMaximum )
+                - static_cast< RealType >( m_OutputMinimum ) )
+              / ( static_cast< RealType >( inputMaximum )
+                  - static_cast< RealType >( inputMinimum ) );
+      }
+    else if( inputMaximum != itk::NumericTraits< InputPixelType >::Zero )
+      {
+      scale = ( static_cast< RealType >( m_OutputMaximum )
+                - static_cast< RealType >( m_OutputMinimum ) )
+              / static_cast< RealType >( inputMaximum );
+      }
+    else
+      {
+      scale = 0.0;
+      }
+    const RealType shift = static_cast< RealType >( m_OutputMinimum )
+      - static_cast< RealType >( inputMinimum ) * scale;
+
+    FunctorType transform;
+    transform.SetMinimum( m_OutputMinimum );
+    transform.SetMaximum( m_OutputMaximum );
+    transform.SetFactor( scale );
+    transform.SetOffset( shift );
+    for( itk::SizeValueType i = 0; i < numberOfPixels; ++i )
+      {
+      out[i] = transform( in[i] );
+      }
+  }
+
+private:
+  OutputPixelType m_OutputMinimum;
+  OutputPixelType m_OutputMaximum;
+};
+
+/** The cast -> Canny -> rescale chain of CannyFrameProcessor, fixed at
+ * compile time. GetStage< 1 >().GetFilter() gives the Canny filter. */
+typedef itk::Image< unsigned char, 2 > StaticCannyInputImageType;
+typedef itk::Image< float, 2 >         StaticCannyRealImageType;
+typedef StaticFramePipeline<
+  CastStage< StaticCannyInputImageType, StaticCannyRealImageType >,
+  ImageFilterStage< itk::CannyEdgeDetectionImageFilter<
+    StaticCannyRealImageType, StaticCannyRealImageType > >,
+  RescaleStage< StaticCannyRealImageType, StaticCannyInputImageType > >
+                                       StaticCannyPipelineType;
+
+} // end namespace bridge
+
+#endif
@@ -0,0 +1,334 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __ThreadBudget_h
+#define __ThreadBudget_h
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <opencv2/core/core.hpp>
+
+#if defined( __linux__ )
+#include <pthread.h>
+#include <sched.h>
+#endif
+#if !defined( _WIN32 )
+#include <sys/resource.h>
+#endif
+
+namespace bridge
+{
+
+/** \class ThreadBudget
+ * \brief Split one thread budget between the stages of an executable and
+ * the OpenCV and ITK thread pools they use.
+ *
+ * OpenCV and ITK both size their pools to all the cores. When several
+ * frames or streams are processed at once, each of them then starts as many
+ * threads as there are cores and the two libraries oversubscribe each
+ * other. The budget is read from the environment:
+ *
+ *   BRIDGE_THREADS          total number of threads (default: all cores)
+ *   BRIDGE_OPENCV_THREADS   OpenCV threads per stage (default: the stage share)
+ *   BRIDGE_ITK_THREADS      ITK threads per stage (default: the stage share)
+ *   BRIDGE_PIN_THREADS      1 to pin the threads of the executable to cores
+ *
+ * Distribute() divides the total between the stages that run at the same
+ * time: pool workers, pipeline stage threads, the capture thread. The
+ * remainder of the division is not lost: the first stages get one thread
+ * more, so 7 threads over 3 stages are shared 3, 2 and 2.
+ * GetITKThreads(stage) and GetOpenCVThreads(stage) give the share of a
+ * stage, and executables number their heaviest stages first;
+ * GetITKThreads() and GetOpenCVThreads() give the smallest share.
+ *
+ * Apply() sets the OpenCV pool, which the process has only one of, to the
+ * share of the first stage; executables using ITK also pass GetITKThreads()
+ * to itk::MultiThreader::SetGlobalDefaultNumberOfThreads(), and the share
+ * of a stage to the filters it runs. Pinning only applies to the threads
+ * the executable creates itself, the library pools are left to the
+ * scheduler.
+ */
+class ThreadBudget
+{
+public:
+  ThreadBudget() :
+    m_NumberOfStages( 1 ),
+    m_NextCore( 0 )
+  {
+    m_NumberOfCores = std::max( 1u, std::thread::hardware_concurrency() );
+    m_TotalThreads = ReadVariable( "BRIDGE_THREADS", m_NumberOfCores );
+    m_RequestedOpenCVThreads = ReadVariable( "BRIDGE_OPENCV_THREADS", 0 );
+    m_RequestedITKThreads = ReadVariable( "BRIDGE_ITK_THREADS", 0 );
+    m_PinThreads = ReadVariable( "BRIDGE_PIN_THREADS", 0 ) != 0;
+    this->Distribute( 1 );
+  }
+
+  unsigned int GetTotalThreads() const
+  {
+    return m_TotalThreads;
+  }
+
+  unsigned int GetOpenCVThreads() const
+  {
+    return m_OpenCVThreads;
+  }
+
+  unsigned int GetITKThreads() const
+  {
+    return m_ITKThreads;
+  }
+
+  /** Share of a stage, 0 for the first one, with the remainder of the
+   * division. An explicit BRIDGE_OPENCV_THREADS or BRIDGE_ITK_THREADS
+   * applies to every stage. */
+  unsigned int GetOpenCVThreads( unsigned int stage ) const
+  {
+    return m_RequestedOpenCVThreads ? m_RequestedOpenCVThreads : this->GetShare( stage );
+  }
+
+  unsigned int GetITKThreads( unsigned int stage ) const
+  {
+    return m_RequestedITKThreads ? m_RequestedITKThreads : this->GetShare( stage );
+  }
+
+  bool GetPinThreads() const
+  {
+    return m_PinThreads;
+  }
+
+  /** Share the budget between numberOfStages threads running at once */
+  void Distribute( unsigned int numberOfStages )
+  {
+    m_NumberOfStages = std::max( 1u, numberOfStages );
+    const unsigned int share = this->GetShare( m_NumberOfStages - 1 );
+    m_OpenCVThreads = m_RequestedOpenCVThreads ? m_RequestedOpenCVThreads : share;
+    m_ITKThreads = m_RequestedITKThreads ? m_RequestedITKThreads : share;
+  }
+
+  /** Size the OpenCV pool to the share of the first stage. A single thread
+   * disables it altogether. */
+  void Apply() const
+  {
+    const unsigned int threads = this->GetOpenCVThreads( 0 );
+    cv::setNumThreads( threads > 1 ? static_cast< int >( threads ) : 0 );
+  }
+
+  /** Pin the calling thread to the next core when pinning is enabled.
+   * Returns true if the thread was pinned. */
+  bool PinCurrentThread()
+  {
+    if( !m_PinThreads )
+      {
+      return false;
+      }
+    const unsigned int core = m_NextCore++ % m_NumberOfCores;
+#if defined( __linux__ )
+    cpu_set_t cores;
+    CPU_ZERO( &cores );
+    CPU_SET( core, &cores );
+    return pthread_setaffinity_np( pthread_self(), sizeof( cores ), &cores ) == 0;
+#else
+    (void)core;
+    return false;
+#endif
+  }
+
+  void Report( std::ostream & os ) const
+  {
+    os << "thread budget: " << m_TotalThreads << " of " << m_NumberOfCores
+       << " cores, " << m_NumberOfStages << " concurrent stages, "
+       << m_OpenCVThreads << " OpenCV and " << m_ITKThreads
+       << " ITK threads per stage";
+    const unsigned int remainder = this->GetRemainder();
+    if( remainder > 0 && !( m_RequestedOpenCVThreads && m_RequestedITKThreads ) )
+      {
+      os << ", one more for the first " << remainder;
+      }
+    os << ( m_PinThreads ? ", pinned" : "" ) << std::endl;
+  }
+
+private:
+  // Threads left over by the division between the stages
+  unsigned int GetRemainder() const
+  {
+    return m_TotalThreads > m_NumberOfStages ? m_TotalThreads % m_NumberOfStages : 0;
+  }
+
+  // Share of a stage when the budget is divided between the stages
+  unsigned int GetShare( unsigned int stage ) const
+  {
+    const unsigned int share = std::max( 1u, m_TotalThreads / m_NumberOfStages );
+    return stage < this->GetRemainder() ? share + 1 : share;
+  }
+
+  static unsigned int ReadVariable( const char * name, unsigned int defaultValue )
+  {
+    const char * value = std::getenv( name );
+    if( value == 0 || *value == '\0' )
+      {
+      return defaultValue;
+      }
+    return static_cast< unsigned int >( std::strtoul( value, 0, 10 ) );
+  }
+
+  unsigned int                m_NumberOfCores;
+  unsigned int                m_TotalThreads;
+  unsigned int                m_RequestedOpenCVThreads;
+  unsigned int                m_RequestedITKThreads;
+  unsigned int                m_NumberOfStages;
+  unsigned int                m_OpenCVThreads;
+  unsigned int                m_ITKThreads;
+  bool                        m_PinThreads;
+  std::atomic< unsigned int > m_NextCore;
+};
+
+/** \class ConcurrencyMeter
+ * \brief Measure how many threads the process actually keeps busy.
+ *
+ * A sampling thread compares the CPU time of the process with the wall
+ * time every SamplingInterval. The report gives the mean and the peak
+ * number of busy cores and, on Linux, the largest number of threads seen.
+ */
+class ConcurrencyMeter
+{
+public:
+  ConcurrencyMeter() :
+    m_Running( false ),
+    m_StartCpu( 0.0 ),
+    m_StopCpu( 0.0 ),
+    m_PeakConcurrency( 0.0 ),
+    m_PeakThreads( 0 )
+  {
+  }
+
+  ~ConcurrencyMeter()
+  {
+    this->Stop();
+  }
+
+  void Start()
+  {
+    m_StartWall = ClockType::now();
+    m_StartCpu = CpuSeconds();
+    m_Running = true;
+    m_Sampler = std::thread( &ConcurrencyMeter::Sample, this );
+  }
+
+  void Stop()
+  {
+    {
+    std::lock_guard< std::mutex > lock( m_Mutex );
+    if( !m_Running )
+      {
+      return;
+      }
+    m_Running = false;
+    }
+    m_Wake.notify_all();
+    m_Sampler.join();
+    m_StopWall = ClockType::now();
+    m_StopCpu = CpuSeconds();
+  }
+
+  void Report( std::ostream & os ) const
+  {
+    std::chrono::duration< double > wall = m_StopWall - m_StartWall;
+    const double mean = wall.count() > 0.0
+      ? ( m_StopCpu - m_StartCpu ) / wall.count() : 0.0;
+    os << "concurrency: " << mean << " busy cores on average, "
+       << m_PeakConcurrency << " at peak";
+    if( m_PeakThreads > 0 )
+      {
+      os << ", up to " << m_PeakThreads << " threads";
+      }
+    os << std::endl;
+  }
+
+private:
+  typedef std::chrono::steady_clock ClockType;
+
+  static double CpuSeconds()
+  {
+#if !defined( _WIN32 )
+    struct rusage usage;
+    if( getrusage( RUSAGE_SELF, &usage ) == 0 )
+      {
+      return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + 1e-6 * ( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec );
+      }
+#endif
+    return 0.0;
+  }
+
+  // Number of threads of the process, 0 when unknown
+  static unsigned int NumberOfThreads()
+  {
+    std::ifstream status( "/proc/self/status" );
+    std::string line;
+    while( std::getline( status, line ) )
+      {
+      if( line.compare( 0, 8, "Threads:" ) == 0 )
+        {
+        return static_cast< unsigned int >( std::atoi( line.c_str() + 8 ) );
+        }
+      }
+    return 0;
+  }
+
+  void Sample()
+  {
+    const std::chrono::milliseconds SamplingInterval( 100 );
+    ClockType::time_point wall = m_StartWall;
+    double cpu = m_StartCpu;
+    std::unique_lock< std::mutex > lock( m_Mutex );
+    while( !m_Wake.wait_for( lock, SamplingInterval, [this] { return !m_Running; } ) )
+      {
+      const ClockType::time_point now = ClockType::now();
+      const double nowCpu = CpuSeconds();
+      std::chrono::duration< double > elapsed = now - wall;
+      m_PeakConcurrency = std::max( m_PeakConcurrency,
+                                    ( nowCpu - cpu ) / elapsed.count() );
+      m_PeakThreads = std::max( m_PeakThreads, NumberOfThreads() );
+      wall = now;
+      cpu = nowCpu;
+      }
+  }
+
+  std::thread             m_Sampler;
+  std::mutex              m_Mutex;
+  std::condition_variable m_Wake;
+  bool                    m_Running;
+  ClockType::time_point   m_StartWall;
+  ClockType::time_point   m_StopWall;
+  double                  m_StartCpu;
+  double                  m_StopCpu;
+  double                  m_PeakConcurrency;
+  unsigned int            m_PeakThreads;
+};
+
+} // end namespace bridge
+
+#endif
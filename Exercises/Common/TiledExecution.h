@@ -0,0 +1,266 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __TiledExecution_h
+#define __TiledExecution_h
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <itkCommand.h>
+#include <itkImage.h>
+#include <itkStreamingImageFilter.h>
+
+namespace bridge
+{
+
+/** \class TiledExecution
+ * \brief Run a chain of image filters one cache-sized tile at a time.
+ *
+ * A filter chain normally runs every filter over the whole image before
+ * the next one starts, so on large images every intermediate image goes to
+ * memory and comes back. Here an itk::StreamingImageFilter at the end of
+ * the chain requests the output in horizontal tiles. Each tile goes through
+ * the whole chain before the next one. The neighborhood filters enlarge the
+ * regions they request by their radius, so each stage computes a tile plus
+ * the halo its successors need.
+ *
+ * The number of tiles is chosen so that one tile of every intermediate
+ * stage fits in the cache budget. The budget comes from BRIDGE_TILE_BYTES,
+ * in bytes, or the size of the L2 cache with BRIDGE_TILE_BYTES=auto.
+ * IsRequested() tells whether the variable is set.
+ *
+ * The stages registered with AddStage() are observed. Report() compares the
+ * bytes they computed in tiles, halos included, with one pass over the
+ * whole image, and estimates the memory traffic avoided.
+ *
+ * Tiling must not change the result, so the chain may only contain
+ * pointwise filters and neighborhood filters whose halo covers their whole
+ * support: casts, thresholds, mean and CurvatureFlow with a fixed number of
+ * iterations. Filters with a global computation go after GetOutput(), on
+ * the assembled image: the hysteresis of Canny follows edges across the
+ * image, and RescaleIntensity takes the minimum and maximum of the whole
+ * image. A CurvatureFlow stopping on a tolerance requests the whole input
+ * and would compute the whole image for every tile.
+ */
+template< typename TImage >
+class TiledExecution
+{
+public:
+  typedef TImage                                      ImageType;
+  typedef itk::StreamingImageFilter< ImageType, ImageType >
+                                                      StreamerType;
+  typedef itk::SizeValueType                          SizeValueType;
+
+  TiledExecution() :
+    m_CacheBytes( CacheBytesFromEnvironment() ),
+    m_NumberOfTiles( 1 )
+  {
+    m_Streamer = StreamerType::New();
+    m_Command = CommandType::New();
+    m_Command->SetCallbackFunction( this, &TiledExecution::Record );
+  }
+
+  ~TiledExecution()
+  {
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+      {
+      m_Stages[i].Filter->RemoveObserver( m_Stages[i].ObserverTag );
+      }
+  }
+
+  /** Whether BRIDGE_TILE_BYTES asks for tiled execution */
+  static bool IsRequested()
+  {
+    const char * value = std::getenv( "BRIDGE_TILE_BYTES" );
+    return value && *value && std::strcmp( value, "0" ) != 0;
+  }
+
+  /** Cache budget of BRIDGE_TILE_BYTES, the L2 cache size for "auto" */
+  static SizeValueType CacheBytesFromEnvironment()
+  {
+    const char * value = std::getenv( "BRIDGE_TILE_BYTES" );
+    if( value && *value && std::strcmp( value, "auto" ) != 0 )
+      {
+      return static_cast< SizeValueType >( std::strtoull( value, 0, 10 ) );
+      }
+    return L2CacheBytes();
+  }
+
+  static SizeValueType L2CacheBytes()
+  {
+#if defined( _SC_LEVEL2_CACHE_SIZE )
+    const long bytes = sysconf( _SC_LEVEL2_CACHE_SIZE );
+    if( bytes > 0 )
+      {
+      return static_cast< SizeValueType >( bytes );
+      }
+#endif
+    return 1024 * 1024;
+  }
+
+  void SetCacheBytes( SizeValueType bytes )
+  {
+    m_CacheBytes = bytes;
+  }
+
+  SizeValueType GetCacheBytes() const
+  {
+    return m_CacheBytes;
+  }
+
+  /** Observe a filter of the chain. Its output pixels count in the tile
+   * size and in the report. */
+  template< typename TFilter >
+  void AddStage( const std::string & name, TFilter * filter )
+  {
+    Stage stage;
+    stage.Name = name;
+    stage.Filter = filter;
+    stage.BytesPerPixel = sizeof( typename TFilter::OutputImageType::PixelType );
+    stage.ComputedPixels = 0;
+    stage.ImagePixels = 0;
+    stage.ObserverTag = filter->AddObserver( itk::EndEvent(), m_Command );
+    m_Stages.push_back( stage );
+  }
+
+  /** End of the chain */
+  void SetInput( const ImageType * image )
+  {
+    m_Streamer->SetInput( image );
+  }
+
+  /** The image assembled from the tiles */
+  ImageType * GetOutput()
+  {
+    return m_Streamer->GetOutput();
+  }
+
+  /** Choose the number of tiles and run the chain tile by tile */
+  void Update()
+  {
+    m_Streamer->UpdateOutputInformation();
+    const typename ImageType::RegionType largest =
+      m_Streamer->GetOutput()->GetLargestPossibleRegion();
+    SizeValueType bytesPerPixel = 0;
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+      {
+      bytesPerPixel += m_Stages[i].BytesPerPixel;
+      m_Stages[i].ComputedPixels = 0;
+      m_Stages[i].ImagePixels = largest.GetNumberOfPixels();
+      }
+    const SizeValueType chainBytes = largest.GetNumberOfPixels() * bytesPerPixel;
+    const SizeValueType rows = largest.GetSize( ImageType::ImageDimension - 1 );
+    m_NumberOfTiles = m_CacheBytes > 0 ?
+      ( chainBytes + m_CacheBytes - 1 ) / m_CacheBytes : 1;
+    m_NumberOfTiles = std::max< SizeValueType >( 1,
+      std::min( m_NumberOfTiles, rows ) );
+    m_Streamer->SetNumberOfStreamDivisions( m_NumberOfTiles );
+    m_Streamer->Update();
+  }
+
+  SizeValueType GetNumberOfTiles() const
+  {
+    return m_NumberOfTiles;
+  }
+
+  void Report( std::ostream & os ) const
+  {
+    os << "tiled execution: " << m_NumberOfTiles << " tiles for a cache budget of "
+       << m_CacheBytes / 1024 << " KiB" << std::endl;
+    SizeValueType avoidedBytes = 0;
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+      {
+      const Stage & stage = m_Stages[i];
+      const double imageBytes =
+        static_cast< double >( stage.ImagePixels ) * stage.BytesPerPixel;
+      const double computedBytes =
+        static_cast< double >( stage.ComputedPixels ) * stage.BytesPerPixel;
+      os << "  " << std::left << std::setw( 24 ) << stage.Name << std::right
+         << std::fixed << std::setprecision( 1 )
+         << std::setw( 9 ) << imageBytes / ( 1024 * 1024 ) << " MiB whole, "
+         << std::setw( 9 ) << computedBytes / ( 1024 * 1024 ) << " MiB in tiles";
+      if( stage.ImagePixels > 0 )
+        {
+        os << " (halo +" << 100.0 * ( computedBytes - imageBytes ) / imageBytes
+           << " %)";
+        }
+      os << std::endl;
+      // The intermediate images that do not fit in the cache are written
+      // to memory and read back by the next stage when computed whole. The
+      // last stage is copied into the output in both cases.
+      if( i + 1 < m_Stages.size() && imageBytes > m_CacheBytes )
+        {
+        avoidedBytes += 2 * stage.ImagePixels * stage.BytesPerPixel;
+        }
+      }
+    os << "  memory traffic avoided: about " << std::fixed << std::setprecision( 1 )
+       << avoidedBytes / ( 1024.0 * 1024.0 ) << " MiB" << std::endl;
+  }
+
+private:
+  TiledExecution( const TiledExecution & ); //purposely not implemented
+  void operator=( const TiledExecution & ); //purposely not implemented
+
+  typedef itk::MemberCommand< TiledExecution > CommandType;
+
+  struct Stage
+  {
+    std::string          Name;
+    itk::ProcessObject * Filter;
+    SizeValueType        BytesPerPixel;
+    SizeValueType        ComputedPixels;
+    SizeValueType        ImagePixels;
+    unsigned long        ObserverTag;
+  };
+
+  void Record( itk::Object * caller, const itk::EventObject & )
+  {
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+      {
+      if( m_Stages[i].Filter != caller )
+        {
+        continue;
+        }
+      const itk::ImageBase< ImageType::ImageDimension > * output =
+        dynamic_cast< const itk::ImageBase< ImageType::ImageDimension > * >(
+          m_Stages[i].Filter->GetOutput( 0 ) );
+      if( output )
+        {
+        m_Stages[i].ComputedPixels +=
+          output->GetBufferedRegion().GetNumberOfPixels();
+        }
+      }
+  }
+
+  typename StreamerType::Pointer m_Streamer;
+  typename CommandType::Pointer  m_Command;
+  std::vector< Stage >           m_Stages;
+  SizeValueType                  m_CacheBytes;
+  SizeValueType                  m_NumberOfTiles;
+};
+
+} // end namespace bridge
+
+#endif
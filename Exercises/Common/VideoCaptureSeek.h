@@ -0,0 +1,135 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __VideoCaptureSeek_h
+#define __VideoCaptureSeek_h
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include "VideoSeekIndex.h"
+
+namespace bridge
+{
+
+/** FNV-1a hash of the pixels of a frame, to recognize it after a seek */
+inline unsigned long long HashFrame( const cv::Mat & frame )
+{
+  unsigned long long hash = 14695981039346656037ULL;
+  const size_t rowSize = frame.cols * frame.elemSize();
+  for( int y = 0; y < frame.rows; ++y )
+    {
+    const unsigned char * pixel = frame.ptr< unsigned char >( y );
+    for( size_t i = 0; i < rowSize; ++i )
+      {
+      hash = ( hash ^ pixel[i] ) * 1099511628211ULL;
+      }
+    }
+  return hash;
+}
+
+/** Index a video decoded by cv::VideoCapture.
+ *
+ * The video is decoded once from start to end to hash every frame. Then,
+ * every keyFrameInterval frames, the capture is seeked to a candidate frame
+ * and the decoded frame is compared with the one found sequentially. The
+ * candidate becomes a key frame when they match; otherwise the next few
+ * frames are tried. OpenCV does not expose the key frames of the codec, so
+ * this finds the frames on which its seek is known to be exact. */
+inline bool BuildVideoCaptureSeekIndex( const std::string & video,
+                                        VideoSeekIndex & index,
+                                        size_t keyFrameInterval = 250 )
+{
+  if( !index.Initialize( video ) )
+    {
+    return false;
+    }
+  cv::VideoCapture capture( video );
+  if( !capture.isOpened() )
+    {
+    return false;
+    }
+
+  std::vector< unsigned long long > hashes;
+  cv::Mat frame;
+  while( capture.read( frame ) )
+    {
+    hashes.push_back( HashFrame( frame ) );
+    }
+  index.SetNumberOfFrames( hashes.size() );
+
+  const size_t attempts = 4;
+  for( size_t candidate = 0; candidate < hashes.size();
+       candidate += keyFrameInterval )
+    {
+    for( size_t f = candidate;
+         f < std::min( candidate + attempts, hashes.size() ); ++f )
+      {
+      if( capture.set( CV_CAP_PROP_POS_FRAMES, static_cast< double >( f ) ) &&
+          capture.read( frame ) && HashFrame( frame ) == hashes[f] )
+        {
+        index.AddKeyFrame( f );
+        break;
+        }
+      }
+    }
+  return true;
+}
+
+/** Position a capture of video so that the next frame read is frame.
+ *
+ * With an index the capture seeks to the last key frame before frame and
+ * grabs the frames in between. Without one, or before the first key frame,
+ * the video is opened again and decoded from its start: slow, but exact,
+ * unlike a plain CV_CAP_PROP_POS_FRAMES seek. */
+inline bool SeekVideoCapture( cv::VideoCapture & capture,
+                              const std::string & video,
+                              const VideoSeekIndex * index, size_t frame )
+{
+  size_t position = 0;
+  if( index && index->GetKeyFrame( frame, position ) && position > 0 )
+    {
+    if( !capture.set( CV_CAP_PROP_POS_FRAMES, static_cast< double >( position ) ) )
+      {
+      return false;
+      }
+    }
+  else
+    {
+    position = 0;
+    if( !capture.open( video ) )
+      {
+      return false;
+      }
+    }
+  for( ; position < frame; ++position )
+    {
+    if( !capture.grab() )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end namespace bridge
+
+#endif
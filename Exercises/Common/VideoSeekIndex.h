@@ -0,0 +1,351 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __VideoSeekIndex_h
+#define __VideoSeekIndex_h
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "Y4MHeader.h"
+
+namespace bridge
+{
+
+/** Seek in a file larger than 2 GB */
+inline int SeekLargeFile( std::FILE * file, unsigned long long offset, int whence )
+{
+#if defined( _WIN32 )
+  return _fseeki64( file, static_cast< __int64 >( offset ), whence );
+#else
+  return fseeko( file, static_cast< off_t >( offset ), whence );
+#endif
+}
+
+inline unsigned long long TellLargeFile( std::FILE * file )
+{
+#if defined( _WIN32 )
+  return static_cast< unsigned long long >( _ftelli64( file ) );
+#else
+  return static_cast< unsigned long long >( ftello( file ) );
+#endif
+}
+
+/** \class VideoSeekIndex
+ * \brief Sidecar index of a video file for exact random access.
+ *
+ * The index is built once per video (see the BuildVideoSeekIndex tool) and
+ * stored next to it as "<video>.seek". It records the number of frames and:
+ *
+ * - for y4m files, the byte offset of every frame, as a first offset and a
+ *   stride when all the frames have the same size, so that a reader reaches
+ *   any frame with a single seek even when frame headers have parameters;
+ * - for compressed videos, the key frames: the frames on which a seek of
+ *   cv::VideoCapture was checked to land exactly. A reader seeks to the
+ *   last key frame before the frame it wants and decodes forward from there.
+ *
+ * The size and modification time of the video are stored too, and Load()
+ * rejects an index that does not match the file any more.
+ */
+class VideoSeekIndex
+{
+public:
+  typedef unsigned long long OffsetType;
+
+  VideoSeekIndex()
+  {
+    this->Clear();
+  }
+
+  void Clear()
+  {
+    m_FileSize = 0;
+    m_FileTime = 0;
+    m_NumberOfFrames = 0;
+    m_FirstOffset = 0;
+    m_Stride = 0;
+    m_Offsets.clear();
+    m_AllKeyFrames = false;
+    m_KeyFrames.clear();
+  }
+
+  /** Name of the index file of a video */
+  static std::string GetIndexFileName( const std::string & video )
+  {
+    return video + ".seek";
+  }
+
+  /** Size and modification time of a file */
+  static bool GetFileIdentity( const std::string & name,
+                               OffsetType & size, long long & time )
+  {
+    struct stat status;
+    if( stat( name.c_str(), &status ) != 0 )
+      {
+      return false;
+      }
+    size = static_cast< OffsetType >( status.st_size );
+    time = static_cast< long long >( status.st_mtime );
+    return true;
+  }
+
+  /** Start an index of the given video */
+  bool Initialize( const std::string & video )
+  {
+    this->Clear();
+    return GetFileIdentity( video, m_FileSize, m_FileTime );
+  }
+
+  size_t GetNumberOfFrames() const
+  {
+    return m_NumberOfFrames;
+  }
+  void SetNumberOfFrames( size_t numberOfFrames )
+  {
+    m_NumberOfFrames = numberOfFrames;
+  }
+
+  /** Byte offsets, either for every frame or as a stride */
+  bool HasOffsets() const
+  {
+    return m_Stride > 0 || !m_Offsets.empty();
+  }
+  void SetOffsets( const std::vector< OffsetType > & offsets )
+  {
+    m_NumberOfFrames = offsets.size();
+    m_Stride = 0;
+    m_Offsets.clear();
+    bool uniform = offsets.size() > 1;
+    for( size_t i = 2; uniform && i < offsets.size(); ++i )
+      {
+      uniform = offsets[i] - offsets[i - 1] == offsets[1] - offsets[0];
+      }
+    if( uniform )
+      {
+      m_FirstOffset = offsets[0];
+      m_Stride = offsets[1] - offsets[0];
+      }
+    else
+      {
+      m_Offsets = offsets;
+      }
+  }
+  OffsetType GetOffset( size_t frame ) const
+  {
+    return m_Stride > 0 ? m_FirstOffset + frame * m_Stride : m_Offsets[frame];
+  }
+
+  /** Key frames, in increasing order */
+  void SetAllKeyFrames( bool all )
+  {
+    m_AllKeyFrames = all;
+  }
+  void AddKeyFrame( size_t frame )
+  {
+    m_KeyFrames.push_back( frame );
+  }
+  size_t GetNumberOfKeyFrames() const
+  {
+    return m_AllKeyFrames ? m_NumberOfFrames : m_KeyFrames.size();
+  }
+
+  /** The last key frame at or before frame. Returns false if there is none,
+   * in which case decoding has to start from the beginning of the file. */
+  bool GetKeyFrame( size_t frame, size_t & keyFrame ) const
+  {
+    if( m_AllKeyFrames )
+      {
+      keyFrame = frame;
+      return true;
+      }
+    std::vector< size_t >::const_iterator it =
+      std::upper_bound( m_KeyFrames.begin(), m_KeyFrames.end(), frame );
+    if( it == m_KeyFrames.begin() )
+      {
+      return false;
+      }
+    keyFrame = *( it - 1 );
+    return true;
+  }
+
+  /** Write the index next to the video */
+  bool Save( const std::string & video ) const
+  {
+    std::ofstream file( GetIndexFileName( video ).c_str() );
+    file << "SEEKINDEX 1\n"
+         << "file " << m_FileSize << " " << m_FileTime << "\n"
+         << "frames " << m_NumberOfFrames << "\n";
+    if( m_Stride > 0 )
+      {
+      file << "stride " << m_FirstOffset << " " << m_Stride << "\n";
+      }
+    else
+      {
+      file << "offsets " << m_Offsets.size() << "\n";
+      for( size_t i = 0; i < m_Offsets.size(); ++i )
+        {
+        file << m_Offsets[i] << "\n";
+        }
+      }
+    if( m_AllKeyFrames )
+      {
+      file << "keyframes all\n";
+      }
+    else
+      {
+      file << "keyframes " << m_KeyFrames.size() << "\n";
+      for( size_t i = 0; i < m_KeyFrames.size(); ++i )
+        {
+        file << m_KeyFrames[i] << "\n";
+        }
+      }
+    return static_cast< bool >( file );
+  }
+
+  /** Read the index of a video. Returns false if there is none or if it
+   * was built for another version of the file. */
+  bool Load( const std::string & video )
+  {
+    this->Clear();
+    OffsetType fileSize;
+    long long fileTime;
+    if( !GetFileIdentity( video, fileSize, fileTime ) )
+      {
+      return false;
+      }
+
+    std::ifstream file( GetIndexFileName( video ).c_str() );
+    std::string word;
+    int version = 0;
+    if( !( file >> word >> version ) || word != "SEEKINDEX" || version != 1 )
+      {
+      return false;
+      }
+    bool valid = static_cast< bool >( file >> word >> m_FileSize >> m_FileTime ) &&
+      word == "file" && m_FileSize == fileSize && m_FileTime == fileTime;
+    valid = valid && static_cast< bool >( file >> word >> m_NumberOfFrames ) &&
+      word == "frames";
+
+    size_t count = 0;
+    valid = valid && static_cast< bool >( file >> word );
+    if( valid && word == "stride" )
+      {
+      valid = static_cast< bool >( file >> m_FirstOffset >> m_Stride );
+      }
+    else if( valid && word == "offsets" && file >> count )
+      {
+      m_Offsets.resize( count );
+      for( size_t i = 0; valid && i < count; ++i )
+        {
+        valid = static_cast< bool >( file >> m_Offsets[i] );
+        }
+      valid = valid && ( count == 0 || count == m_NumberOfFrames );
+      }
+    else
+      {
+      valid = false;
+      }
+
+    std::string keyFrames;
+    valid = valid && static_cast< bool >( file >> word >> keyFrames ) &&
+      word == "keyframes";
+    if( valid && keyFrames == "all" )
+      {
+      m_AllKeyFrames = true;
+      }
+    else if( valid )
+      {
+      count = static_cast< size_t >( std::strtoul( keyFrames.c_str(), 0, 10 ) );
+      m_KeyFrames.resize( count );
+      for( size_t i = 0; valid && i < count; ++i )
+        {
+        valid = static_cast< bool >( file >> m_KeyFrames[i] ) &&
+          ( i == 0 || m_KeyFrames[i] > m_KeyFrames[i - 1] );
+        }
+      }
+
+    if( !valid )
+      {
+      this->Clear();
+      }
+    return valid;
+  }
+
+  /** Index a y4m file by reading its frame headers. Every frame is a key
+   * frame. */
+  bool BuildFromY4M( const std::string & video )
+  {
+    if( !this->Initialize( video ) )
+      {
+      return false;
+      }
+    std::FILE * file = std::fopen( video.c_str(), "rb" );
+    if( !file )
+      {
+      return false;
+      }
+
+    Y4MHeader header;
+    size_t lineSize = 0;
+    bool valid = header.Read( file, lineSize );
+    const OffsetType frameDataSize = valid ? header.GetFrameDataSize() : 0;
+
+    std::vector< OffsetType > offsets;
+    while( valid )
+      {
+      const OffsetType offset = TellLargeFile( file );
+      if( !Y4MHeader::ReadFrameHeader( file, lineSize ) ||
+          offset + lineSize + frameDataSize > m_FileSize )
+        {
+        // A truncated last frame is not indexed
+        break;
+        }
+      offsets.push_back( offset );
+      valid = SeekLargeFile( file, frameDataSize, SEEK_CUR ) == 0;
+      }
+    std::fclose( file );
+
+    if( !valid )
+      {
+      return false;
+      }
+    this->SetOffsets( offsets );
+    m_AllKeyFrames = true;
+    return true;
+  }
+
+private:
+  OffsetType                m_FileSize;
+  long long                 m_FileTime;
+  size_t                    m_NumberOfFrames;
+  OffsetType                m_FirstOffset;
+  OffsetType                m_Stride;
+  std::vector< OffsetType > m_Offsets;
+  bool                      m_AllKeyFrames;
+  std::vector< size_t >     m_KeyFrames;
+};
+
+} // end namespace bridge
+
+#endif
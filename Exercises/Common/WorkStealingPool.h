@@ -0,0 +1,238 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __WorkStealingPool_h
+#define __WorkStealingPool_h
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bridge
+{
+
+/** \class WorkStealingPool
+ * \brief Fixed set of worker threads, each with its own task deque.
+ *
+ * A task submitted from a worker goes to the back of that worker's deque
+ * and the worker takes its own tasks from the back, which keeps the frame
+ * it just decoded hot in its cache. Tasks submitted from outside are
+ * spread round-robin. An idle worker steals from the front of the other
+ * deques, so no core sits idle while work is queued anywhere.
+ *
+ * Tasks must not throw. Wait() returns once every submitted task, including
+ * the tasks submitted by other tasks, has run. The optional start function
+ * runs first on every worker, with the index of the worker, e.g. to pin it
+ * to a core.
+ */
+class WorkStealingPool
+{
+public:
+  typedef std::function< void () >             TaskType;
+  typedef std::function< void ( unsigned int ) > StartFunctionType;
+
+  explicit WorkStealingPool( unsigned int numberOfWorkers,
+    const StartFunctionType & start = StartFunctionType() ) :
+    m_Start( start ),
+    m_Stop( false ),
+    m_Pending( 0 ),
+    m_NextQueue( 0 )
+  {
+    if( numberOfWorkers == 0 )
+      {
+      numberOfWorkers = 1;
+      }
+    for( unsigned int i = 0; i < numberOfWorkers; ++i )
+      {
+      m_Queues.push_back( std::unique_ptr< Queue >( new Queue ) );
+      }
+    for( unsigned int i = 0; i < numberOfWorkers; ++i )
+      {
+      m_Workers.push_back( std::thread( &WorkStealingPool::Run, this, i ) );
+      }
+  }
+
+  ~WorkStealingPool()
+  {
+    {
+    std::lock_guard< std::mutex > lock( m_WakeMutex );
+    m_Stop = true;
+    }
+    m_Wake.notify_all();
+    for( size_t i = 0; i < m_Workers.size(); ++i )
+      {
+      m_Workers[i].join();
+      }
+  }
+
+  unsigned int GetNumberOfWorkers() const
+  {
+    return static_cast< unsigned int >( m_Workers.size() );
+  }
+
+  /** Index of the calling worker, or -1 when called from another thread */
+  static int GetCurrentWorkerIndex()
+  {
+    return CurrentWorker();
+  }
+
+  void Submit( const TaskType & task )
+  {
+    ++m_Pending;
+
+    int worker = CurrentWorker();
+    size_t queue = ( worker >= 0 && CurrentPool() == this )
+      ? static_cast< size_t >( worker )
+      : ( m_NextQueue++ % m_Queues.size() );
+    {
+    std::lock_guard< std::mutex > lock( m_Queues[queue]->Mutex );
+    m_Queues[queue]->Tasks.push_back( task );
+    }
+
+    {
+    std::lock_guard< std::mutex > lock( m_WakeMutex );
+    }
+    m_Wake.notify_one();
+  }
+
+  /** Block until all the submitted tasks have completed */
+  void Wait()
+  {
+    std::unique_lock< std::mutex > lock( m_WakeMutex );
+    m_Idle.wait( lock, [this] { return m_Pending.load() == 0; } );
+  }
+
+private:
+  WorkStealingPool( const WorkStealingPool & ); //purposely not implemented
+  void operator=( const WorkStealingPool & );   //purposely not implemented
+
+  struct Queue
+    {
+    std::mutex             Mutex;
+    std::deque< TaskType > Tasks;
+    };
+
+  static int & CurrentWorker()
+  {
+    static thread_local int index = -1;
+    return index;
+  }
+
+  static const WorkStealingPool * & CurrentPool()
+  {
+    static thread_local const WorkStealingPool * pool = 0;
+    return pool;
+  }
+
+  bool PopOwn( size_t worker, TaskType & task )
+  {
+    std::lock_guard< std::mutex > lock( m_Queues[worker]->Mutex );
+    if( m_Queues[worker]->Tasks.empty() )
+      {
+      return false;
+      }
+    task = m_Queues[worker]->Tasks.back();
+    m_Queues[worker]->Tasks.pop_back();
+    return true;
+  }
+
+  bool Steal( size_t worker, TaskType & task )
+  {
+    for( size_t i = 1; i < m_Queues.size(); ++i )
+      {
+      Queue & victim = *m_Queues[( worker + i ) % m_Queues.size()];
+      std::lock_guard< std::mutex > lock( victim.Mutex );
+      if( !victim.Tasks.empty() )
+        {
+        task = victim.Tasks.front();
+        victim.Tasks.pop_front();
+        return true;
+        }
+      }
+    return false;
+  }
+
+  void Run( unsigned int worker )
+  {
+    CurrentWorker() = static_cast< int >( worker );
+    CurrentPool() = this;
+    if( m_Start )
+      {
+      m_Start( worker );
+      }
+
+    TaskType task;
+    for(;;)
+      {
+      if( this->PopOwn( worker, task ) || this->Steal( worker, task ) )
+        {
+        task();
+        task = TaskType();
+        if( --m_Pending == 0 )
+          {
+          std::lock_guard< std::mutex > lock( m_WakeMutex );
+          m_Idle.notify_all();
+          }
+        continue;
+        }
+
+      std::unique_lock< std::mutex > lock( m_WakeMutex );
+      if( m_Stop )
+        {
+        return;
+        }
+      // Recheck under the lock: Submit() takes it after queuing a task, so
+      // a task queued after the scan above cannot be missed.
+      if( !this->HasQueuedTasks() )
+        {
+        m_Wake.wait( lock );
+        }
+      }
+  }
+
+  bool HasQueuedTasks()
+  {
+    for( size_t i = 0; i < m_Queues.size(); ++i )
+      {
+      std::lock_guard< std::mutex > lock( m_Queues[i]->Mutex );
+      if( !m_Queues[i]->Tasks.empty() )
+        {
+        return true;
+        }
+      }
+    return false;
+  }
+
+  StartFunctionType                       m_Start;
+  std::vector< std::unique_ptr< Queue > > m_Queues;
+  std::vector< std::thread >              m_Workers;
+  std::mutex                              m_WakeMutex;
+  std::condition_variable                 m_Wake;
+  std::condition_variable                 m_Idle;
+  bool                                    m_Stop;
+  std::atomic< size_t >                   m_Pending;
+  std::atomic< size_t >                   m_NextQueue;
+};
+
+} // end namespace bridge
+
+#endif
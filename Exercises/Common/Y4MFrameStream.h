@@ -0,0 +1,518 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __Y4MFrameStream_h
+#define __Y4MFrameStream_h
+
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined( _WIN32 )
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "BoundedFrameQueue.h"
+#include "Y4MHeader.h"
+#include "VideoSeekIndex.h"
+
+namespace bridge
+{
+
+/** Open a y4m stream. "-" is the standard input or output, switched to
+ * binary mode where that matters. */
+inline std::FILE * OpenY4MFile( const std::string & name, bool forWriting )
+{
+  if( name == "-" )
+    {
+    std::FILE * file = forWriting ? stdout : stdin;
+#if defined( _WIN32 )
+    _setmode( _fileno( file ), _O_BINARY );
+#endif
+    return file;
+    }
+  return std::fopen( name.c_str(), forWriting ? "wb" : "rb" );
+}
+
+/** \class Y4MFrameReader
+ * \brief Read the frames of a y4m file or of the standard input.
+ *
+ * A background thread reads the next raw frame while the caller works on
+ * the current one (double buffering), so a stage reading from a pipe does
+ * not wait for its upstream stage once the pipe is primed. Read() returns
+ * BGR frames, like cv::VideoCapture, or only the Y plane after
+ * SetGrayOutput( true ). Files, unlike the standard input, can be positioned
+ * on any frame with SeekToFrame(). A stream that ends in the middle of a
+ * frame is an error, not the end of the stream: Read() throws once the
+ * frames before it were read.
+ */
+class Y4MFrameReader
+{
+public:
+  Y4MFrameReader() :
+    m_File( 0 ),
+    m_HeaderSize( 0 ),
+    m_Gray( false ),
+    m_Truncated( false ),
+    m_Filled( 1 ),
+    m_Free( 2 )
+  {
+  }
+
+  ~Y4MFrameReader()
+  {
+    this->Close();
+  }
+
+  /** Return the Y plane only, without any color conversion */
+  void SetGrayOutput( bool gray )
+  {
+    m_Gray = gray;
+  }
+
+  /** Open the stream and read its header */
+  bool Open( const std::string & name )
+  {
+    this->Close();
+    m_Name = name;
+    m_File = OpenY4MFile( name, false );
+    if( !m_File )
+      {
+      return false;
+      }
+
+    if( !m_Header.Read( m_File, m_HeaderSize ) )
+      {
+      this->Close();
+      return false;
+      }
+    m_ScannedFrames.Clear();
+
+    this->StartPrefetch();
+    return true;
+  }
+
+  bool IsOpened() const
+  {
+    return m_File != 0;
+  }
+
+  const Y4MHeader & GetHeader() const
+  {
+    return m_Header;
+  }
+
+  double GetFramesPerSecond() const
+  {
+    return m_Header.GetFramesPerSecond();
+  }
+
+  cv::Size GetFrameSize() const
+  {
+    return cv::Size( static_cast< int >( m_Header.Width ),
+                     static_cast< int >( m_Header.Height ) );
+  }
+
+  /** Get the next frame. Returns false at the end of the stream and throws
+   * std::runtime_error if the stream ends with a truncated or corrupted
+   * frame. */
+  bool Read( cv::Mat & frame )
+  {
+    cv::Mat raw;
+    if( !m_File )
+      {
+      return false;
+      }
+    if( !m_Filled.Pop( raw ) )
+      {
+      if( m_Truncated )
+        {
+        throw std::runtime_error( "The last frame of " + m_Name +
+                                  " is truncated or corrupted" );
+        }
+      return false;
+      }
+    this->Convert( raw, frame );
+    m_Free.Push( raw );
+    return true;
+  }
+
+  /** Make frameNumber the next frame read. The offset comes from the seek
+   * index of the file when given and, otherwise, from a scan of the frame
+   * lines done by the first seek, since a frame line may have parameters.
+   * Fails on the standard input. */
+  bool SeekToFrame( size_t frameNumber, const VideoSeekIndex * index = 0 )
+  {
+    if( !m_File || m_File == stdin )
+      {
+      return false;
+      }
+    if( !index || !index->HasOffsets() )
+      {
+      if( !m_ScannedFrames.HasOffsets() && !m_ScannedFrames.BuildFromY4M( m_Name ) )
+        {
+        return false;
+        }
+      index = &m_ScannedFrames;
+      }
+    if( frameNumber >= index->GetNumberOfFrames() )
+      {
+      return false;
+      }
+    const VideoSeekIndex::OffsetType offset = index->GetOffset( frameNumber );
+
+    this->StopPrefetch();
+    const bool positioned = SeekLargeFile( m_File, offset, SEEK_SET ) == 0;
+    this->StartPrefetch();
+    return positioned;
+  }
+
+  void Close()
+  {
+    this->StopPrefetch();
+    if( m_File && m_File != stdin )
+      {
+      std::fclose( m_File );
+      }
+    m_File = 0;
+  }
+
+private:
+  Y4MFrameReader( const Y4MFrameReader & ); //purposely not implemented
+  void operator=( const Y4MFrameReader & ); //purposely not implemented
+
+  void StartPrefetch()
+  {
+    m_Truncated = false;
+    for( unsigned int i = 0; i < 2; ++i )
+      {
+      m_Free.Push( cv::Mat( 1, static_cast< int >( m_Header.GetFrameDataSize() ),
+                            CV_8UC1 ) );
+      }
+    m_Thread = std::thread( &Y4MFrameReader::Prefetch, this );
+  }
+
+  // Stop the reading thread and drop the frames it read ahead
+  void StopPrefetch()
+  {
+    m_Filled.Close();
+    m_Free.Close();
+    if( m_Thread.joinable() )
+      {
+      m_Thread.join();
+      }
+    m_Filled.Reopen();
+    m_Free.Reopen();
+  }
+
+  // Reading thread: fill the free buffers with the raw frames
+  void Prefetch()
+  {
+    cv::Mat raw;
+    size_t lineSize;
+    while( m_Free.Pop( raw ) )
+      {
+      // The stream may only end between two frames
+      const int c = std::getc( m_File );
+      if( c == EOF )
+        {
+        break;
+        }
+      std::ungetc( c, m_File );
+      const size_t dataSize = raw.total();
+      if( !Y4MHeader::ReadFrameHeader( m_File, lineSize ) ||
+          std::fread( raw.data, 1, dataSize, m_File ) != dataSize )
+        {
+        m_Truncated = true;
+        break;
+        }
+      if( !m_Filled.Push( raw ) )
+        {
+        break;
+        }
+      }
+    m_Filled.Close();
+  }
+
+  // Turn the planes of a raw frame into a gray or BGR image
+  void Convert( const cv::Mat & raw, cv::Mat & frame ) const
+  {
+    const int width = static_cast< int >( m_Header.Width );
+    const int height = static_cast< int >( m_Header.Height );
+    unsigned char * data = raw.data;
+    cv::Mat luma( height, width, CV_8UC1, data );
+
+    if( m_Gray || m_Header.Chroma == Y4MHeader::ChromaMono )
+      {
+      if( m_Gray )
+        {
+        luma.copyTo( frame );
+        }
+      else
+        {
+        cv::cvtColor( luma, frame, CV_GRAY2BGR );
+        }
+      return;
+      }
+
+    if( m_Header.Chroma == Y4MHeader::Chroma420 &&
+        width % 2 == 0 && height % 2 == 0 )
+      {
+      cv::Mat i420( height * 3 / 2, width, CV_8UC1, data );
+      cv::cvtColor( i420, frame, CV_YUV2BGR_I420 );
+      return;
+      }
+
+    // Other layouts: bring the chroma planes to full size
+    const int chromaWidth = static_cast< int >( m_Header.GetChromaWidth() );
+    const int chromaHeight = static_cast< int >( m_Header.GetChromaHeight() );
+    const size_t chromaSize = static_cast< size_t >( chromaWidth ) * chromaHeight;
+    cv::Mat cb( chromaHeight, chromaWidth, CV_8UC1, data + m_Header.GetLumaSize() );
+    cv::Mat cr( chromaHeight, chromaWidth, CV_8UC1,
+                data + m_Header.GetLumaSize() + chromaSize );
+    std::vector< cv::Mat > planes( 3 );
+    planes[0] = luma;
+    if( chromaWidth == width && chromaHeight == height )
+      {
+      planes[1] = cr;
+      planes[2] = cb;
+      }
+    else
+      {
+      cv::resize( cr, planes[1], luma.size(), 0, 0, cv::INTER_LINEAR );
+      cv::resize( cb, planes[2], luma.size(), 0, 0, cv::INTER_LINEAR );
+      }
+    cv::Mat ycrcb;
+    cv::merge( planes, ycrcb );
+    cv::cvtColor( ycrcb, frame, CV_YCrCb2BGR );
+  }
+
+  std::FILE *                  m_File;
+  std::string                  m_Name;
+  Y4MHeader                    m_Header;
+  size_t                       m_HeaderSize;
+  VideoSeekIndex               m_ScannedFrames;
+  bool                         m_Gray;
+  std::atomic< bool >          m_Truncated;
+  BoundedFrameQueue< cv::Mat > m_Filled;
+  BoundedFrameQueue< cv::Mat > m_Free;
+  std::thread                  m_Thread;
+};
+
+/** \class Y4MFrameWriter
+ * \brief Write frames to a y4m file or to the standard output.
+ *
+ * Write() converts the frame into a free raw buffer and hands it to a
+ * background thread, which writes it while the caller produces the next
+ * frame (double buffering). Gray streams are written with the "mono"
+ * colorspace and are lossless. Color frames are converted by OpenCV to
+ * 4:2:0 when the frame size is even and to 4:4:4 otherwise.
+ */
+class Y4MFrameWriter
+{
+public:
+  Y4MFrameWriter() :
+    m_File( 0 ),
+    m_Failed( false ),
+    m_Filled( 1 ),
+    m_Free( 2 )
+  {
+  }
+
+  ~Y4MFrameWriter()
+  {
+    this->Close();
+  }
+
+  /** Open the stream and write its header. As for cv::VideoWriter, isColor
+   * tells whether the frames are stored in color or in gray levels. */
+  bool Open( const std::string & name, double framesPerSecond,
+             cv::Size frameSize, bool isColor )
+  {
+    this->Close();
+    m_File = OpenY4MFile( name, true );
+    if( !m_File )
+      {
+      return false;
+      }
+
+    m_Header = Y4MHeader();
+    m_Header.Width = frameSize.width;
+    m_Header.Height = frameSize.height;
+    m_Header.SetFramesPerSecond( framesPerSecond );
+    if( !isColor )
+      {
+      m_Header.SetColorspace( "mono" );
+      }
+    else if( frameSize.width % 2 != 0 || frameSize.height % 2 != 0 )
+      {
+      m_Header.SetColorspace( "444" );
+      }
+
+    const std::string header = m_Header.Format();
+    if( std::fwrite( header.data(), 1, header.size(), m_File ) != header.size() )
+      {
+      this->Close();
+      return false;
+      }
+
+    m_Failed = false;
+    for( unsigned int i = 0; i < 2; ++i )
+      {
+      m_Free.Push( cv::Mat( 1, static_cast< int >( m_Header.GetFrameDataSize() ),
+                            CV_8UC1 ) );
+      }
+    m_Thread = std::thread( &Y4MFrameWriter::Flush, this );
+    return true;
+  }
+
+  bool IsOpened() const
+  {
+    return m_File != 0;
+  }
+
+  /** Queue a frame for writing. Returns false if the frame does not have
+   * the size of the stream or once writing failed, e.g. when the downstream
+   * end of the pipe was closed. */
+  bool Write( const cv::Mat & frame )
+  {
+    if( frame.cols != static_cast< int >( m_Header.Width ) ||
+        frame.rows != static_cast< int >( m_Header.Height ) )
+      {
+      return false;
+      }
+    cv::Mat raw;
+    if( !m_File || m_Failed || !m_Free.Pop( raw ) )
+      {
+      return false;
+      }
+    this->Convert( frame, raw );
+    return m_Filled.Push( raw );
+  }
+
+  /** Write the queued frames and close the stream */
+  void Close()
+  {
+    m_Filled.Close();
+    if( m_Thread.joinable() )
+      {
+      m_Thread.join();
+      }
+    m_Free.Close();
+    if( m_File )
+      {
+      if( m_File == stdout )
+        {
+        std::fflush( m_File );
+        }
+      else
+        {
+        std::fclose( m_File );
+        }
+      }
+    m_File = 0;
+    m_Filled.Reopen();
+    m_Free.Reopen();
+  }
+
+private:
+  Y4MFrameWriter( const Y4MFrameWriter & ); //purposely not implemented
+  void operator=( const Y4MFrameWriter & ); //purposely not implemented
+
+  // Writing thread: write the filled buffers and hand them back
+  void Flush()
+  {
+    cv::Mat raw;
+    const std::string frameLine = std::string( Y4MHeader::FrameSignature() ) + "\n";
+    while( m_Filled.Pop( raw ) )
+      {
+      if( std::fwrite( frameLine.data(), 1, frameLine.size(), m_File ) != frameLine.size() ||
+          std::fwrite( raw.data, 1, raw.total(), m_File ) != raw.total() )
+        {
+        m_Failed = true;
+        m_Filled.Close();
+        m_Free.Close();
+        break;
+        }
+      m_Free.Push( raw );
+      }
+    std::fflush( m_File );
+  }
+
+  // Lay the frame out as the planes of the stream
+  void Convert( const cv::Mat & frame, cv::Mat & raw ) const
+  {
+    const int width = static_cast< int >( m_Header.Width );
+    const int height = static_cast< int >( m_Header.Height );
+    unsigned char * data = raw.data;
+    cv::Mat luma( height, width, CV_8UC1, data );
+
+    if( m_Header.Chroma == Y4MHeader::ChromaMono )
+      {
+      if( frame.channels() == 1 )
+        {
+        frame.copyTo( luma );
+        }
+      else
+        {
+        cv::cvtColor( frame, luma, CV_BGR2GRAY );
+        }
+      return;
+      }
+
+    cv::Mat bgr = frame;
+    if( frame.channels() == 1 )
+      {
+      cv::cvtColor( frame, bgr, CV_GRAY2BGR );
+      }
+
+    if( m_Header.Chroma == Y4MHeader::Chroma420 )
+      {
+      cv::Mat i420( height * 3 / 2, width, CV_8UC1, data );
+      cv::cvtColor( bgr, i420, CV_BGR2YUV_I420 );
+      return;
+      }
+
+    // 4:4:4, the planes are stored in the Y, Cb, Cr order
+    const size_t planeSize = m_Header.GetLumaSize();
+    cv::Mat ycrcb;
+    cv::cvtColor( bgr, ycrcb, CV_BGR2YCrCb );
+    std::vector< cv::Mat > planes( 3 );
+    planes[0] = luma;
+    planes[1] = cv::Mat( height, width, CV_8UC1, data + 2 * planeSize );
+    planes[2] = cv::Mat( height, width, CV_8UC1, data + planeSize );
+    cv::split( ycrcb, planes );
+  }
+
+  std::FILE *                  m_File;
+  Y4MHeader                    m_Header;
+  std::atomic< bool >          m_Failed;
+  BoundedFrameQueue< cv::Mat > m_Filled;
+  BoundedFrameQueue< cv::Mat > m_Free;
+  std::thread                  m_Thread;
+};
+
+} // end namespace bridge
+
+#endif
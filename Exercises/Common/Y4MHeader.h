@@ -0,0 +1,300 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __Y4MHeader_h
+#define __Y4MHeader_h
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+namespace bridge
+{
+
+/** \class Y4MHeader
+ * \brief Stream header of a YUV4MPEG2 (y4m) file.
+ *
+ * A y4m file is a text header line followed by frames, each made of a
+ * "FRAME" line and the raw Y, Cb and Cr planes. Only 8-bit samples are
+ * supported. The frame parameters that may follow "FRAME" are skipped, so
+ * the frame lines may have different lengths: the offset of a frame is only
+ * known once the lines before it were read (see VideoSeekIndex.h).
+ */
+struct Y4MHeader
+{
+  enum ChromaType
+    {
+    Chroma420,
+    Chroma422,
+    Chroma444,
+    Chroma411,
+    ChromaMono
+    };
+
+  Y4MHeader() :
+    Width( 0 ),
+    Height( 0 ),
+    FrameRateNumerator( 25 ),
+    FrameRateDenominator( 1 ),
+    Interlacing( "p" ),
+    PixelAspectRatio( "1:1" ),
+    Colorspace( "420jpeg" ),
+    Chroma( Chroma420 )
+  {}
+
+  std::size_t Width;
+  std::size_t Height;
+  unsigned int FrameRateNumerator;
+  unsigned int FrameRateDenominator;
+  std::string Interlacing;
+  std::string PixelAspectRatio;
+  std::string Colorspace;
+  ChromaType  Chroma;
+
+  static const char * Signature()
+  {
+    return "YUV4MPEG2";
+  }
+
+  static const char * FrameSignature()
+  {
+    return "FRAME";
+  }
+
+  /** Longest header or frame line accepted */
+  static std::size_t GetMaximumLineLength()
+  {
+    return 4096;
+  }
+
+  /** Read a header or frame line and drop its terminating newline. Fails
+   * at the end of the file and on lines that are too long. */
+  static bool ReadLine( std::FILE * file, std::string & line )
+  {
+    line.clear();
+    int c;
+    while( ( c = std::getc( file ) ) != EOF && c != '\n' )
+      {
+      if( line.size() == GetMaximumLineLength() )
+        {
+        return false;
+        }
+      line += static_cast< char >( c );
+      }
+    return c == '\n';
+  }
+
+  /** Whether line, without its newline, is a frame line: "FRAME" alone or
+   * followed by parameters */
+  static bool IsFrameHeader( const std::string & line )
+  {
+    const std::string signature = FrameSignature();
+    return line.compare( 0, signature.size(), signature ) == 0 &&
+      ( line.size() == signature.size() || line[signature.size()] == ' ' );
+  }
+
+  /** Read the line of the next frame. lineSize is set to the bytes read,
+   * newline included. Fails at the end of the file and on a line that is
+   * not a frame line. */
+  static bool ReadFrameHeader( std::FILE * file, std::size_t & lineSize )
+  {
+    std::string line;
+    const bool valid = ReadLine( file, line ) && IsFrameHeader( line );
+    lineSize = valid ? line.size() + 1 : 0;
+    return valid;
+  }
+
+  double GetFramesPerSecond() const
+  {
+    return FrameRateDenominator == 0 ? 0.0 :
+      static_cast< double >( FrameRateNumerator ) / FrameRateDenominator;
+  }
+
+  /** Set the frame rate from a number of frames per second. Integer and
+   * NTSC rates are stored exactly. */
+  void SetFramesPerSecond( double framesPerSecond )
+  {
+    const double ntsc[] = { 24000.0 / 1001, 30000.0 / 1001, 60000.0 / 1001 };
+    for( unsigned int i = 0; i < 3; ++i )
+      {
+      if( framesPerSecond > ntsc[i] - 1e-3 && framesPerSecond < ntsc[i] + 1e-3 )
+        {
+        FrameRateNumerator = static_cast< unsigned int >( ntsc[i] * 1001 + 0.5 );
+        FrameRateDenominator = 1001;
+        return;
+        }
+      }
+    FrameRateNumerator = static_cast< unsigned int >( framesPerSecond * 1000 + 0.5 );
+    FrameRateDenominator = 1000;
+    if( FrameRateNumerator % 1000 == 0 )
+      {
+      FrameRateNumerator /= 1000;
+      FrameRateDenominator = 1;
+      }
+  }
+
+  /** Set the colorspace tag and the chroma layout it implies. Return false
+   * for an unsupported colorspace, e.g. a high bit depth one. */
+  bool SetColorspace( const std::string & colorspace )
+  {
+    if( colorspace == "420jpeg" || colorspace == "420paldv" ||
+        colorspace == "420mpeg2" || colorspace == "420" )
+      {
+      Chroma = Chroma420;
+      }
+    else if( colorspace == "422" )
+      {
+      Chroma = Chroma422;
+      }
+    else if( colorspace == "444" )
+      {
+      Chroma = Chroma444;
+      }
+    else if( colorspace == "411" )
+      {
+      Chroma = Chroma411;
+      }
+    else if( colorspace == "mono" )
+      {
+      Chroma = ChromaMono;
+      }
+    else
+      {
+      return false;
+      }
+    Colorspace = colorspace;
+    return true;
+  }
+
+  std::size_t GetLumaSize() const
+  {
+    return Width * Height;
+  }
+
+  /** Width and height of one chroma plane, 0 for mono */
+  std::size_t GetChromaWidth() const
+  {
+    switch( Chroma )
+      {
+      case Chroma420:
+      case Chroma422:
+        return ( Width + 1 ) / 2;
+      case Chroma411:
+        return ( Width + 3 ) / 4;
+      case Chroma444:
+        return Width;
+      default:
+        return 0;
+      }
+  }
+
+  std::size_t GetChromaHeight() const
+  {
+    if( Chroma == ChromaMono )
+      {
+      return 0;
+      }
+    return Chroma == Chroma420 ? ( Height + 1 ) / 2 : Height;
+  }
+
+  /** Bytes of the Y, Cb and Cr planes of one frame */
+  std::size_t GetFrameDataSize() const
+  {
+    return this->GetLumaSize() +
+      2 * this->GetChromaWidth() * this->GetChromaHeight();
+  }
+
+  /** Parse the header line, without its terminating newline */
+  bool Parse( const std::string & line )
+  {
+    std::istringstream fields( line );
+    std::string field;
+    if( !( fields >> field ) || field != Signature() )
+      {
+      return false;
+      }
+
+    *this = Y4MHeader();
+    while( fields >> field )
+      {
+      const std::string value = field.substr( 1 );
+      switch( field[0] )
+        {
+        case 'W':
+          Width = std::strtoul( value.c_str(), 0, 10 );
+          break;
+        case 'H':
+          Height = std::strtoul( value.c_str(), 0, 10 );
+          break;
+        case 'F':
+          if( std::sscanf( value.c_str(), "%u:%u",
+                           &FrameRateNumerator, &FrameRateDenominator ) != 2 )
+            {
+            return false;
+            }
+          break;
+        case 'I':
+          Interlacing = value;
+          break;
+        case 'A':
+          PixelAspectRatio = value;
+          break;
+        case 'C':
+          if( !this->SetColorspace( value ) )
+            {
+            return false;
+            }
+          break;
+        default:
+          // X (application) fields and unknown fields are ignored
+          break;
+        }
+      }
+    return Width > 0 && Height > 0;
+  }
+
+  /** Read and parse the header line at the start of file. headerSize is
+   * set to the bytes read, newline included. */
+  bool Read( std::FILE * file, std::size_t & headerSize )
+  {
+    std::string line;
+    if( !ReadLine( file, line ) || !this->Parse( line ) )
+      {
+      headerSize = 0;
+      return false;
+      }
+    headerSize = line.size() + 1;
+    return true;
+  }
+
+  /** Header line, including its terminating newline */
+  std::string Format() const
+  {
+    std::ostringstream line;
+    line << Signature() << " W" << Width << " H" << Height
+         << " F" << FrameRateNumerator << ":" << FrameRateDenominator
+         << " I" << Interlacing << " A" << PixelAspectRatio
+         << " C" << Colorspace << "\n";
+    return line.str();
+  }
+};
+
+} // end namespace bridge
+
+#endif
@@ -0,0 +1,125 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkAlignedImportImageContainer_h
+#define __itkAlignedImportImageContainer_h
+
+#include "itkImportImageContainer.h"
+
+namespace itk
+{
+
+/** \class AlignedImportImageContainer
+ * \brief Pixel container whose buffer starts on an Alignment byte boundary.
+ *
+ * ImportImageContainer allocates with new[], which only guarantees the
+ * alignment of the element type. Vectorized filters load whole cache lines
+ * or SIMD registers at once and pay for loads that straddle them. This
+ * container allocates its buffer itself, aligned on Alignment bytes (64 by
+ * default, a cache line), imports it, and frees it when destroyed.
+ *
+ * ITK images have no row padding, so the rows are aligned as well only
+ * when a row is a multiple of Alignment bytes. An image gets the container
+ * with SetPixelContainer() after AllocateAligned(); a later Allocate() of
+ * the image keeps the buffer as long as it is large enough.
+ */
+template< typename TElementIdentifier, typename TElement >
+class AlignedImportImageContainer :
+  public ImportImageContainer< TElementIdentifier, TElement >
+{
+public:
+
+  /** Standard class typedefs */
+  typedef AlignedImportImageContainer                         Self;
+  typedef ImportImageContainer< TElementIdentifier, TElement > Superclass;
+  typedef SmartPointer< Self >                                Pointer;
+  typedef SmartPointer< const Self >                          ConstPointer;
+
+  typedef TElementIdentifier ElementIdentifier;
+  typedef TElement           Element;
+
+  itkNewMacro(Self);
+  itkTypeMacro(AlignedImportImageContainer, ImportImageContainer);
+
+  /** Byte boundary of the buffer start, a power of two */
+  itkSetMacro(Alignment, size_t);
+  itkGetConstMacro(Alignment, size_t);
+
+  /** Allocate an aligned buffer of size elements, unless the current one
+   * is large enough */
+  void AllocateAligned(ElementIdentifier size)
+  {
+    if( m_AlignedBuffer && size <= m_AlignedSize &&
+        this->GetImportPointer() == m_AlignedPointer )
+      {
+      this->SetImportPointer( m_AlignedPointer, size, false );
+      return;
+      }
+    this->ReleaseAligned();
+    const size_t bytes = static_cast< size_t >( size ) * sizeof( Element );
+    m_AlignedBuffer = new char[bytes + m_Alignment];
+    const size_t address = reinterpret_cast< size_t >( m_AlignedBuffer );
+    m_AlignedPointer = reinterpret_cast< Element * >(
+      ( address + m_Alignment - 1 ) & ~( m_Alignment - 1 ) );
+    m_AlignedSize = size;
+    this->SetImportPointer( m_AlignedPointer, size, false );
+  }
+
+protected:
+  AlignedImportImageContainer() :
+    m_Alignment( 64 ),
+    m_AlignedBuffer( NULL ),
+    m_AlignedPointer( NULL ),
+    m_AlignedSize( 0 )
+  {
+  }
+
+  virtual ~AlignedImportImageContainer()
+  {
+    // The superclass does not own the imported buffer
+    this->SetImportPointer( NULL, 0, false );
+    this->ReleaseAligned();
+  }
+
+  void PrintSelf(std::ostream & os, Indent indent) const
+  {
+    Superclass::PrintSelf( os, indent );
+    os << indent << "Alignment: " << m_Alignment << std::endl;
+    os << indent << "AlignedSize: " << m_AlignedSize << std::endl;
+  }
+
+private:
+  AlignedImportImageContainer(const Self &); //purposely not implemented
+  void operator=(const Self &);              //purposely not implemented
+
+  void ReleaseAligned()
+  {
+    delete[] m_AlignedBuffer;
+    m_AlignedBuffer = NULL;
+    m_AlignedPointer = NULL;
+    m_AlignedSize = 0;
+  }
+
+  size_t            m_Alignment;
+  char *            m_AlignedBuffer;
+  Element *         m_AlignedPointer;
+  ElementIdentifier m_AlignedSize;
+};
+
+} // end namespace itk
+
+#endif
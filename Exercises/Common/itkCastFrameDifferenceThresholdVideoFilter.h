@@ -0,0 +1,151 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkCastFrameDifferenceThresholdVideoFilter_h
+#define __itkCastFrameDifferenceThresholdVideoFilter_h
+
+#include <vector>
+
+#include "itkVideoToVideoFilter.h"
+#include "itkNumericTraits.h"
+#include "itkIntermediatePixelTraits.h"
+
+namespace itk
+{
+
+/** \class CastFrameDifferenceThresholdVideoFilter
+ * \brief Cast, frame difference and threshold a video in a single pass.
+ *
+ * This filter computes the frames of the chain
+ *
+ *   ImageFilterToVideoFilterWrapper< CastImageFilter >
+ *   -> FrameDifferenceVideoFilter
+ *   -> ImageFilterToVideoFilterWrapper< ThresholdImageFilter >
+ *
+ * with the threshold set through ThresholdBelow(). Each output pixel is
+ * computed from the cast pixels of frames t - FrameOffset and t: their
+ * squared difference is computed as in FrameDifferenceVideoFilter, and
+ * values below the threshold are replaced by the OutsideValue. Fixed point
+ * input frames (see IntermediatePixelTraits) are cast from the real value
+ * they hold.
+ *
+ * The filter reads a single input frame per output frame and keeps the
+ * last FrameOffset cast frames itself, so the input VideoStream only
+ * buffers the current (float) frame and the history costs one output
+ * pixel per pixel and frame. The unthresholded differences are never
+ * stored: the two intermediate VideoStreams of the chain and the two extra
+ * passes over every frame disappear.
+ *
+ * As for FrameDifferenceVideoFilter, the output starts FrameOffset frames
+ * after the input, and output frame t compares input frames t - FrameOffset
+ * and t: the output is the one of the chain, frame for frame. The history
+ * follows the frames in order. When it starts again, for the first frame,
+ * when the frames are not consecutive, when a parameter changes or after
+ * Reset(), the filter reads the FrameOffset input frames before the
+ * current one to fill it.
+ */
+template< typename TInputVideoStream, typename TOutputVideoStream >
+class CastFrameDifferenceThresholdVideoFilter :
+  public VideoToVideoFilter< TInputVideoStream, TOutputVideoStream >
+{
+public:
+
+  /** Standard class typedefs */
+  typedef TInputVideoStream                           InputVideoStreamType;
+  typedef TOutputVideoStream                          OutputVideoStreamType;
+  typedef CastFrameDifferenceThresholdVideoFilter<
+    InputVideoStreamType, OutputVideoStreamType >     Self;
+  typedef VideoToVideoFilter<
+    InputVideoStreamType, OutputVideoStreamType >     Superclass;
+  typedef SmartPointer< Self >                        Pointer;
+  typedef SmartPointer< const Self >                  ConstPointer;
+
+  typedef typename TInputVideoStream::FrameType       InputFrameType;
+  typedef typename InputFrameType::PixelType          InputPixelType;
+  typedef typename InputFrameType::RegionType         InputFrameSpatialRegionType;
+  typedef typename TOutputVideoStream::FrameType      OutputFrameType;
+  typedef typename OutputFrameType::PixelType         OutputPixelType;
+  typedef typename OutputFrameType::RegionType        OutputFrameSpatialRegionType;
+  typedef typename NumericTraits< OutputPixelType >::RealType
+                                                      DifferenceRealType;
+
+  itkNewMacro(Self);
+  itkTypeMacro(CastFrameDifferenceThresholdVideoFilter, VideoToVideoFilter);
+
+  /** Number of frames between the two frames being compared, at least 1 */
+  void SetFrameOffset(SizeValueType numFrames);
+  itkGetConstMacro(FrameOffset, SizeValueType);
+
+  /** Differences below this value are set to the OutsideValue */
+  void ThresholdBelow(OutputPixelType threshold);
+  itkGetConstMacro(Threshold, OutputPixelType);
+
+  itkSetMacro(OutsideValue, OutputPixelType);
+  itkGetConstMacro(OutsideValue, OutputPixelType);
+
+  /** Drop the history; the next frame fills a new one */
+  void Reset();
+
+  /** The output starts FrameOffset frames after the input */
+  virtual void UpdateOutputInformation();
+
+protected:
+  CastFrameDifferenceThresholdVideoFilter();
+  virtual ~CastFrameDifferenceThresholdVideoFilter() {}
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+  /** Fill a new history from the input frames before the current one when
+   * needed */
+  virtual void BeforeThreadedGenerateData();
+
+  /** Compute the output frame for the given spatial region */
+  virtual void ThreadedGenerateData(
+    const OutputFrameSpatialRegionType & outputRegionForThread,
+    int threadId);
+
+  /** Move on to the next frame */
+  virtual void AfterThreadedGenerateData();
+
+private:
+  CastFrameDifferenceThresholdVideoFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);                          //purposely not implemented
+
+  /** Cast an input frame into a frame of the history */
+  void CastFrame(const InputFrameType * input, OutputFrameType * output) const;
+
+  SizeValueType   m_FrameOffset;
+  OutputPixelType m_Threshold;
+  OutputPixelType m_OutsideValue;
+
+  /** The last FrameOffset cast frames. Slot m_Slot holds frame
+   * t - FrameOffset and receives frame t. */
+  std::vector< typename OutputFrameType::Pointer > m_History;
+  SizeValueType   m_Slot;
+
+  /** Frame the history expects next, and the time it was started */
+  SizeValueType   m_NextFrame;
+  unsigned long   m_HistoryTime;
+  bool            m_Initialize;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkCastFrameDifferenceThresholdVideoFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,283 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkCastFrameDifferenceThresholdVideoFilter_hxx
+#define __itkCastFrameDifferenceThresholdVideoFilter_hxx
+
+#include "itkCastFrameDifferenceThresholdVideoFilter.h"
+
+#include <algorithm>
+
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+
+namespace itk
+{
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+CastFrameDifferenceThresholdVideoFilter< TInputVideoStream, TOutputVideoStream >
+::CastFrameDifferenceThresholdVideoFilter()
+{
+  m_FrameOffset = 1;
+  m_Threshold = NumericTraits< OutputPixelType >::NonpositiveMin();
+  m_OutsideValue = NumericTraits< OutputPixelType >::Zero;
+
+  m_Slot = 0;
+  m_NextFrame = 0;
+  m_HistoryTime = 0;
+  m_Initialize = true;
+
+  // One input frame per output frame: the earlier cast frames are kept by
+  // the filter, and output frame t reads input frame t
+  this->TemporalProcessObject::m_UnitInputNumberOfFrames = 1;
+  this->TemporalProcessObject::m_UnitOutputNumberOfFrames = 1;
+  this->TemporalProcessObject::m_FrameSkipPerOutput = 1;
+  this->TemporalProcessObject::m_InputStencilCurrentFrameIndex = 0;
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+CastFrameDifferenceThresholdVideoFilter< TInputVideoStream, TOutputVideoStream >
+::SetFrameOffset(SizeValueType numFrames)
+{
+  numFrames = std::max< SizeValueType >( numFrames, 1 );
+  if( m_FrameOffset != numFrames )
+    {
+    m_FrameOffset = numFrames;
+    this->Modified();
+    }
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+CastFrameDifferenceThresholdVideoFilter< TInputVideoStream, TOutputVideoStream >
+::ThresholdBelow(OutputPixelType threshold)
+{
+  if( m_Threshold != threshold )
+    {
+    m_Threshold = threshold;
+    this->Modified();
+    }
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+CastFrameDifferenceThresholdVideoFilter< TInputVideoStream, TOutputVideoStream >
+::Reset()
+{
+  m_Initialize = true;
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+CastFrameDifferenceThresholdVideoFilter< TInputVideoStream, TOutputVideoStream >
+::UpdateOutputInformation()
+{
+  // The superclass gives an output frame for every input frame, with the
+  // spatial regions of the input frames
+  Superclass::UpdateOutputInformation();
+
+  // The first FrameOffset input frames have no earlier frame to compare
+  // with, as in FrameDifferenceVideoFilter
+  const TemporalRegion inputLargestRegion =
+    this->GetInput()->GetLargestPossibleTemporalRegion();
+  const SizeValueType inputDuration = inputLargestRegion.GetFrameDuration();
+
+  TemporalRegion outputLargestRegion;
+  outputLargestRegion.SetFrameStart( inputLargestRegion.GetFrameStart() + m_FrameOffset );
+  outputLargestRegion.SetFrameDuration(
+    inputDuration > m_FrameOffset ? inputDuration - m_FrameOffset : 0 );
+  this->GetOutput()->SetLargestPossibleTemporalRegion( outputLargestRegion );
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+CastFrameDifferenceThresholdVideoFilter< TInputVideoStream, TOutputVideoStream >
+::CastFrame(const InputFrameType * input, OutputFrameType * output) const
+{
+  InputFrameSpatialRegionType inputRegion;
+  inputRegion.SetIndex( output->GetBufferedRegion().GetIndex() );
+  inputRegion.SetSize( output->GetBufferedRegion().GetSize() );
+
+  const Functor::IntermediateToPixel< InputPixelType, OutputPixelType > castPixel =
+    Functor::IntermediateToPixel< InputPixelType, OutputPixelType >();
+
+  ImageRegionConstIterator< InputFrameType > inputIt( input, inputRegion );
+  ImageRegionIterator< OutputFrameType > outputIt( output, output->GetBufferedRegion() );
+  for( ; !outputIt.IsAtEnd(); ++inputIt, ++outputIt )
+    {
+    outputIt.Set( castPixel( inputIt.Get() ) );
+    }
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+CastFrameDifferenceThresholdVideoFilter< TInputVideoStream, TOutputVideoStream >
+::BeforeThreadedGenerateData()
+{
+  InputVideoStreamType * input =
+    const_cast< InputVideoStreamType * >( this->GetInput() );
+  const SizeValueType frameNumber =
+    input->GetRequestedTemporalRegion().GetFrameStart();
+  const InputFrameSpatialRegionType & inputRegion =
+    input->GetFrame( frameNumber )->GetLargestPossibleRegion();
+
+  if( frameNumber != m_NextFrame || this->GetMTime() > m_HistoryTime )
+    {
+    m_Initialize = true;
+    }
+
+  OutputFrameSpatialRegionType frameRegion;
+  frameRegion.SetIndex( inputRegion.GetIndex() );
+  frameRegion.SetSize( inputRegion.GetSize() );
+  if( m_History.size() != m_FrameOffset ||
+      ( m_History[0].IsNotNull() &&
+        m_History[0]->GetBufferedRegion() != frameRegion ) )
+    {
+    m_History.clear();
+    m_History.resize( m_FrameOffset );
+    m_Initialize = true;
+    }
+
+  if( !m_Initialize )
+    {
+    return;
+    }
+
+  const SizeValueType inputStart =
+    input->GetLargestPossibleTemporalRegion().GetFrameStart();
+  if( frameNumber < inputStart + m_FrameOffset )
+    {
+    itkExceptionMacro( << "Frame " << frameNumber << " has no frame "
+                       << m_FrameOffset << " frames before it" );
+    }
+
+  // Fill the history with the cast frames t - FrameOffset .. t - 1, read
+  // one at a time so the input keeps buffering a single frame; slot 0 then
+  // holds frame t - FrameOffset
+  for( SizeValueType i = 0; i < m_FrameOffset; ++i )
+    {
+    const SizeValueType earlierFrame = frameNumber - m_FrameOffset + i;
+    TemporalRegion earlierRegion;
+    earlierRegion.SetFrameStart( earlierFrame );
+    earlierRegion.SetFrameDuration( 1 );
+    input->SetRequestedTemporalRegion( earlierRegion );
+    input->UpdateOutputData();
+
+    typename OutputFrameType::Pointer & slot = m_History[i];
+    if( slot.IsNull() )
+      {
+      slot = OutputFrameType::New();
+      slot->SetRegions( frameRegion );
+      slot->Allocate();
+      }
+    this->CastFrame( input->GetFrame( earlierFrame ), slot );
+    }
+
+  // Back to the current frame
+  TemporalRegion currentRegion;
+  currentRegion.SetFrameStart( frameNumber );
+  currentRegion.SetFrameDuration( 1 );
+  input->SetRequestedTemporalRegion( currentRegion );
+  input->UpdateOutputData();
+
+  m_Slot = 0;
+  m_HistoryTime = this->GetMTime();
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+CastFrameDifferenceThresholdVideoFilter< TInputVideoStream, TOutputVideoStream >
+::ThreadedGenerateData(const OutputFrameSpatialRegionType & outputRegionForThread,
+                       int itkNotUsed(threadId))
+{
+  const InputVideoStreamType * input = this->GetInput();
+  OutputVideoStreamType * output = this->GetOutput();
+
+  const InputFrameType * currentFrame =
+    input->GetFrame( input->GetRequestedTemporalRegion().GetFrameStart() );
+  OutputFrameType * outputFrame =
+    output->GetFrame( output->GetRequestedTemporalRegion().GetFrameStart() );
+  OutputFrameType * slotFrame = m_History[m_Slot];
+
+  // The input, output and history frames share the same spatial layout
+  InputFrameSpatialRegionType inputRegion;
+  inputRegion.SetIndex( outputRegionForThread.GetIndex() );
+  inputRegion.SetSize( outputRegionForThread.GetSize() );
+
+  const Functor::IntermediateToPixel< InputPixelType, OutputPixelType > castPixel =
+    Functor::IntermediateToPixel< InputPixelType, OutputPixelType >();
+
+  typedef ImageRegionConstIterator< InputFrameType > InputIterType;
+  typedef ImageRegionIterator< OutputFrameType >     OutputIterType;
+  InputIterType  currentIt( currentFrame, inputRegion );
+  OutputIterType slotIt( slotFrame, outputRegionForThread );
+  OutputIterType outputIt( outputFrame, outputRegionForThread );
+
+  // The slot holds frame t - FrameOffset
+  for( ; !outputIt.IsAtEnd(); ++currentIt, ++slotIt, ++outputIt )
+    {
+    // Cast as CastImageFilter does, or IntermediateCastImageFilter for
+    // fixed point frames
+    const OutputPixelType currentValue = castPixel( currentIt.Get() );
+
+    // Squared difference as FrameDifferenceVideoFilter computes it
+    DifferenceRealType difference =
+      static_cast< DifferenceRealType >( slotIt.Get() ) -
+      static_cast< DifferenceRealType >( currentValue );
+    difference *= difference;
+    OutputPixelType value = static_cast< OutputPixelType >( difference );
+
+    // ThresholdImageFilter::ThresholdBelow()
+    if( value < m_Threshold )
+      {
+      value = m_OutsideValue;
+      }
+    slotIt.Set( currentValue );
+    outputIt.Set( value );
+    }
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+CastFrameDifferenceThresholdVideoFilter< TInputVideoStream, TOutputVideoStream >
+::AfterThreadedGenerateData()
+{
+  m_Slot = ( m_Slot + 1 ) % m_FrameOffset;
+  m_NextFrame = this->GetInput()->GetRequestedTemporalRegion().GetFrameStart() + 1;
+  m_Initialize = false;
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+CastFrameDifferenceThresholdVideoFilter< TInputVideoStream, TOutputVideoStream >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "FrameOffset: " << m_FrameOffset << std::endl;
+  os << indent << "Threshold: "
+     << static_cast< typename NumericTraits< OutputPixelType >::PrintType >( m_Threshold )
+     << std::endl;
+  os << indent << "OutsideValue: "
+     << static_cast< typename NumericTraits< OutputPixelType >::PrintType >( m_OutsideValue )
+     << std::endl;
+}
+
+} // end namespace itk
+
+#endif
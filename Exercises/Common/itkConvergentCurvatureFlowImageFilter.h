@@ -0,0 +1,79 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkConvergentCurvatureFlowImageFilter_h
+#define __itkConvergentCurvatureFlowImageFilter_h
+
+#include "itkCurvatureFlowImageFilter.h"
+
+namespace itk
+{
+
+/** \class ConvergentCurvatureFlowImageFilter
+ * \brief CurvatureFlowImageFilter that stops once the image stops changing.
+ *
+ * CurvatureFlowImageFilter runs NumberOfIterations iterations, as its
+ * dense solver does not compute the RMS change that
+ * FiniteDifferenceImageFilter::Halt() compares with MaximumRMSError. This
+ * filter computes the RMS of every update (in intensity units) and stops
+ * as soon as it falls below MaximumRMSError, with NumberOfIterations as the
+ * upper bound. A MaximumRMSError of 0, the default, runs all the
+ * iterations, as CurvatureFlowImageFilter does.
+ *
+ * GetElapsedIterations() gives the iterations run by the last update and
+ * GetRMSChange() the RMS change of the last iteration.
+ */
+template< typename TInputImage, typename TOutputImage >
+class ConvergentCurvatureFlowImageFilter :
+  public CurvatureFlowImageFilter< TInputImage, TOutputImage >
+{
+public:
+
+  /** Standard class typedefs */
+  typedef ConvergentCurvatureFlowImageFilter                    Self;
+  typedef CurvatureFlowImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                                  Pointer;
+  typedef SmartPointer< const Self >                            ConstPointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(ConvergentCurvatureFlowImageFilter, CurvatureFlowImageFilter);
+
+  typedef typename Superclass::TimeStepType     TimeStepType;
+  typedef typename Superclass::UpdateBufferType UpdateBufferType;
+
+protected:
+  ConvergentCurvatureFlowImageFilter() {}
+  virtual ~ConvergentCurvatureFlowImageFilter() {}
+
+  /** Measure the RMS change of the update before applying it */
+  virtual void ApplyUpdate(const TimeStepType & dt);
+
+  /** Stop at NumberOfIterations or when the RMS change is small enough */
+  virtual bool Halt();
+
+private:
+  ConvergentCurvatureFlowImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);                     //purposely not implemented
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkConvergentCurvatureFlowImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,78 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkConvergentCurvatureFlowImageFilter_hxx
+#define __itkConvergentCurvatureFlowImageFilter_hxx
+
+#include <cmath>
+
+#include "itkConvergentCurvatureFlowImageFilter.h"
+
+namespace itk
+{
+
+template< typename TInputImage, typename TOutputImage >
+void
+ConvergentCurvatureFlowImageFilter< TInputImage, TOutputImage >
+::ApplyUpdate(const TimeStepType & dt)
+{
+  const UpdateBufferType * update = this->GetUpdateBuffer();
+  const typename UpdateBufferType::PixelType * value =
+    update->GetBufferPointer();
+  const SizeValueType numberOfPixels =
+    update->GetBufferedRegion().GetNumberOfPixels();
+
+  double sumOfSquares = 0.0;
+  for( SizeValueType i = 0; i < numberOfPixels; ++i )
+    {
+    const double change = static_cast< double >( value[i] ) * dt;
+    sumOfSquares += change * change;
+    }
+  this->SetRMSChange( numberOfPixels > 0
+                      ? std::sqrt( sumOfSquares / numberOfPixels ) : 0.0 );
+
+  Superclass::ApplyUpdate( dt );
+}
+
+template< typename TInputImage, typename TOutputImage >
+bool
+ConvergentCurvatureFlowImageFilter< TInputImage, TOutputImage >
+::Halt()
+{
+  const IdentifierType numberOfIterations = this->GetNumberOfIterations();
+  const IdentifierType elapsedIterations = this->GetElapsedIterations();
+
+  if( numberOfIterations != 0 )
+    {
+    this->UpdateProgress( static_cast< float >( elapsedIterations )
+                          / static_cast< float >( numberOfIterations ) );
+    }
+
+  if( elapsedIterations >= numberOfIterations )
+    {
+    return true;
+    }
+  if( elapsedIterations == 0 )
+    {
+    return false;
+    }
+  return this->GetRMSChange() < this->GetMaximumRMSError();
+}
+
+} // end namespace itk
+
+#endif
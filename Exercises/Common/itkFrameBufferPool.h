@@ -0,0 +1,110 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkFrameBufferPool_h
+#define __itkFrameBufferPool_h
+
+#include <mutex>
+#include <vector>
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+namespace itk
+{
+
+/** \class FrameBufferPool
+ * \brief Recycle the frames of a video instead of allocating new ones.
+ *
+ * All the frames handed out by Acquire() have the same region, so their
+ * buffers can be reused as soon as nobody references them any more. The
+ * pool keeps a reference to every frame it created; a frame is back in the
+ * pool when the pool holds the only reference to it, i.e. when the code
+ * that acquired it has dropped its SmartPointer. There is no explicit
+ * release step.
+ *
+ * The buffer must be free as well. A filter that grafted the frame onto
+ * its output (GraftOutput()) shares its pixel container, and keeps it
+ * after the frame itself was dropped; an in-place filter does the same
+ * with its input. A frame is therefore only free once its pixel container
+ * is referenced by the frame alone, so a buffer is never handed out while
+ * a filter can still read or write it. Code that grafts pool frames should
+ * release the graft after the update (e.g. with ReleaseData() on the
+ * filter output), otherwise every such filter pins one extra frame.
+ *
+ * The pool may be shared by several threads. GetNumberOfReuses() counts
+ * the allocations that were avoided and GetHighWaterMark() the largest
+ * number of frames the pool ever owned.
+ */
+template< typename TImage >
+class FrameBufferPool : public Object
+{
+public:
+
+  /** Standard class typedefs */
+  typedef FrameBufferPool< TImage >  Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  typedef TImage                         ImageType;
+  typedef typename ImageType::Pointer    ImagePointer;
+  typedef typename ImageType::RegionType RegionType;
+
+  itkNewMacro(Self);
+  itkTypeMacro(FrameBufferPool, Object);
+
+  /** Region of the frames handed out. Changing it empties the pool. */
+  void SetFrameRegion(const RegionType & region);
+  RegionType GetFrameRegion() const;
+
+  /** Get a frame whose buffer is allocated for the frame region. The
+   * content of the buffer is undefined. */
+  ImagePointer Acquire();
+
+  /** Counters */
+  SizeValueType GetNumberOfAllocations() const;
+  SizeValueType GetNumberOfReuses() const;
+  SizeValueType GetHighWaterMark() const;
+
+  /** Print the counters on a single line */
+  void Report(std::ostream & os) const;
+
+protected:
+  FrameBufferPool();
+  virtual ~FrameBufferPool() {}
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+private:
+  FrameBufferPool(const Self &); //purposely not implemented
+  void operator=(const Self &);  //purposely not implemented
+
+  mutable std::mutex          m_Mutex;
+  RegionType                  m_FrameRegion;
+  std::vector< ImagePointer > m_Frames;
+  SizeValueType               m_NumberOfAllocations;
+  SizeValueType               m_NumberOfReuses;
+  SizeValueType               m_HighWaterMark;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkFrameBufferPool.hxx"
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkFrameBufferPool_hxx
+#define __itkFrameBufferPool_hxx
+
+#include "itkFrameBufferPool.h"
+
+namespace itk
+{
+
+template< typename TImage >
+FrameBufferPool< TImage >
+::FrameBufferPool()
+{
+  m_NumberOfAllocations = 0;
+  m_NumberOfReuses = 0;
+  m_HighWaterMark = 0;
+}
+
+template< typename TImage >
+void
+FrameBufferPool< TImage >
+::SetFrameRegion(const RegionType & region)
+{
+  std::lock_guard< std::mutex > lock( m_Mutex );
+  if( region != m_FrameRegion )
+    {
+    m_FrameRegion = region;
+    m_Frames.clear();
+    this->Modified();
+    }
+}
+
+template< typename TImage >
+typename FrameBufferPool< TImage >::RegionType
+FrameBufferPool< TImage >
+::GetFrameRegion() const
+{
+  std::lock_guard< std::mutex > lock( m_Mutex );
+  return m_FrameRegion;
+}
+
+template< typename TImage >
+typename FrameBufferPool< TImage >::ImagePointer
+FrameBufferPool< TImage >
+::Acquire()
+{
+  std::lock_guard< std::mutex > lock( m_Mutex );
+
+  // A frame only referenced by the pool, whose buffer is only referenced by
+  // the frame, is free: a filter output grafted onto it would share its
+  // pixel container. Nobody else can take a new reference to it while the
+  // lock is held.
+  for( size_t i = 0; i < m_Frames.size(); ++i )
+    {
+    if( m_Frames[i]->GetReferenceCount() == 1 &&
+        m_Frames[i]->GetPixelContainer()->GetReferenceCount() == 1 )
+      {
+      ++m_NumberOfReuses;
+      return m_Frames[i];
+      }
+    }
+
+  ImagePointer frame = ImageType::New();
+  frame->SetRegions( m_FrameRegion );
+  frame->Allocate();
+  m_Frames.push_back( frame );
+
+  ++m_NumberOfAllocations;
+  if( m_Frames.size() > m_HighWaterMark )
+    {
+    m_HighWaterMark = m_Frames.size();
+    }
+  return frame;
+}
+
+template< typename TImage >
+SizeValueType
+FrameBufferPool< TImage >
+::GetNumberOfAllocations() const
+{
+  std::lock_guard< std::mutex > lock( m_Mutex );
+  return m_NumberOfAllocations;
+}
+
+template< typename TImage >
+SizeValueType
+FrameBufferPool< TImage >
+::GetNumberOfReuses() const
+{
+  std::lock_guard< std::mutex > lock( m_Mutex );
+  return m_NumberOfReuses;
+}
+
+template< typename TImage >
+SizeValueType
+FrameBufferPool< TImage >
+::GetHighWaterMark() const
+{
+  std::lock_guard< std::mutex > lock( m_Mutex );
+  return m_HighWaterMark;
+}
+
+template< typename TImage >
+void
+FrameBufferPool< TImage >
+::Report(std::ostream & os) const
+{
+  std::lock_guard< std::mutex > lock( m_Mutex );
+  os << "allocations: " << m_NumberOfAllocations
+     << "  reuses (allocations avoided): " << m_NumberOfReuses
+     << "  pool high-water mark: " << m_HighWaterMark << " frames"
+     << std::endl;
+}
+
+template< typename TImage >
+void
+FrameBufferPool< TImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  std::lock_guard< std::mutex > lock( m_Mutex );
+  os << indent << "FrameRegion: " << m_FrameRegion << std::endl;
+  os << indent << "NumberOfFrames: " << m_Frames.size() << std::endl;
+  os << indent << "NumberOfAllocations: " << m_NumberOfAllocations << std::endl;
+  os << indent << "NumberOfReuses: " << m_NumberOfReuses << std::endl;
+  os << indent << "HighWaterMark: " << m_HighWaterMark << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,119 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkFrameProviderVideoSource_h
+#define __itkFrameProviderVideoSource_h
+
+#include <functional>
+
+#include "itkVideoSource.h"
+
+namespace itk
+{
+
+/** \class FrameProviderVideoSource
+ * \brief Video source whose frames are filled in by a callback.
+ *
+ * This source lets frames that were produced outside of an ITK pipeline
+ * (by worker threads, by a capture device, ...) enter a VideoStream so that
+ * they can be consumed by video filters or a VideoFileWriter. The frame
+ * geometry and the number of frames have to be set beforehand; the
+ * provider is then called once per frame, in the order requested by the
+ * downstream pipeline, with an output frame that is already allocated.
+ */
+template< typename TOutputVideoStream >
+class FrameProviderVideoSource : public VideoSource< TOutputVideoStream >
+{
+public:
+
+  /** Standard class typedefs */
+  typedef FrameProviderVideoSource< TOutputVideoStream > Self;
+  typedef VideoSource< TOutputVideoStream >              Superclass;
+  typedef SmartPointer< Self >                           Pointer;
+  typedef SmartPointer< const Self >                     ConstPointer;
+
+  typedef TOutputVideoStream                         OutputVideoStreamType;
+  typedef typename TOutputVideoStream::FrameType     FrameType;
+  typedef typename FrameType::RegionType             FrameRegionType;
+  typedef typename FrameType::SpacingType            FrameSpacingType;
+  typedef typename FrameType::PointType              FramePointType;
+  typedef typename FrameType::DirectionType          FrameDirectionType;
+
+  /** The provider fills in the given frame and returns false if the frame
+   * is not available. */
+  typedef std::function< bool ( SizeValueType, FrameType * ) > FrameProviderType;
+
+  itkNewMacro(Self);
+  itkTypeMacro(FrameProviderVideoSource, VideoSource);
+
+  /** Set the callback that supplies the frames */
+  void SetFrameProvider(const FrameProviderType & provider)
+  {
+    m_FrameProvider = provider;
+    this->Modified();
+  }
+
+  /** Temporal extent of the output */
+  itkSetMacro(StartFrame, SizeValueType);
+  itkGetConstMacro(StartFrame, SizeValueType);
+  itkSetMacro(NumberOfFrames, SizeValueType);
+  itkGetConstMacro(NumberOfFrames, SizeValueType);
+
+  /** Geometry shared by all the output frames */
+  itkSetMacro(FrameRegion, FrameRegionType);
+  itkGetConstMacro(FrameRegion, FrameRegionType);
+  itkSetMacro(FrameSpacing, FrameSpacingType);
+  itkGetConstMacro(FrameSpacing, FrameSpacingType);
+  itkSetMacro(FrameOrigin, FramePointType);
+  itkGetConstMacro(FrameOrigin, FramePointType);
+  itkSetMacro(FrameDirection, FrameDirectionType);
+  itkGetConstMacro(FrameDirection, FrameDirectionType);
+
+  /** Copy the geometry of a frame that has the same layout as the output */
+  void SetFrameInformation(const FrameType * frame);
+
+protected:
+  FrameProviderVideoSource();
+  virtual ~FrameProviderVideoSource() {}
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+  /** Set the temporal and spatial extents of the output */
+  virtual void GenerateOutputInformation();
+
+  /** Ask the provider for the frame being requested */
+  virtual void TemporalStreamingGenerateData();
+
+private:
+  FrameProviderVideoSource(const Self &); //purposely not implemented
+  void operator=(const Self &);           //purposely not implemented
+
+  FrameProviderType  m_FrameProvider;
+  SizeValueType      m_StartFrame;
+  SizeValueType      m_NumberOfFrames;
+  FrameRegionType    m_FrameRegion;
+  FrameSpacingType   m_FrameSpacing;
+  FramePointType     m_FrameOrigin;
+  FrameDirectionType m_FrameDirection;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkFrameProviderVideoSource.hxx"
+#endif
+
+#endif
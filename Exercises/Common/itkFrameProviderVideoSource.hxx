@@ -0,0 +1,113 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkFrameProviderVideoSource_hxx
+#define __itkFrameProviderVideoSource_hxx
+
+#include "itkFrameProviderVideoSource.h"
+
+namespace itk
+{
+
+template< typename TOutputVideoStream >
+FrameProviderVideoSource< TOutputVideoStream >
+::FrameProviderVideoSource()
+{
+  m_StartFrame = 0;
+  m_NumberOfFrames = 0;
+  m_FrameSpacing.Fill( 1.0 );
+  m_FrameOrigin.Fill( 0.0 );
+  m_FrameDirection.SetIdentity();
+}
+
+template< typename TOutputVideoStream >
+void
+FrameProviderVideoSource< TOutputVideoStream >
+::SetFrameInformation(const FrameType * frame)
+{
+  this->SetFrameRegion( frame->GetLargestPossibleRegion() );
+  this->SetFrameSpacing( frame->GetSpacing() );
+  this->SetFrameOrigin( frame->GetOrigin() );
+  this->SetFrameDirection( frame->GetDirection() );
+}
+
+template< typename TOutputVideoStream >
+void
+FrameProviderVideoSource< TOutputVideoStream >
+::GenerateOutputInformation()
+{
+  OutputVideoStreamType * output = this->GetOutput();
+
+  TemporalRegion largestPossibleTemporalRegion;
+  largestPossibleTemporalRegion.SetFrameStart( m_StartFrame );
+  largestPossibleTemporalRegion.SetFrameDuration( m_NumberOfFrames );
+  output->SetLargestPossibleTemporalRegion( largestPossibleTemporalRegion );
+
+  output->SetAllLargestPossibleSpatialRegions( m_FrameRegion );
+  output->SetAllRequestedSpatialRegions( m_FrameRegion );
+  output->SetAllBufferedSpatialRegions( m_FrameRegion );
+  output->SetAllFramesSpacing( m_FrameSpacing );
+  output->SetAllFramesOrigin( m_FrameOrigin );
+  output->SetAllFramesDirection( m_FrameDirection );
+}
+
+template< typename TOutputVideoStream >
+void
+FrameProviderVideoSource< TOutputVideoStream >
+::TemporalStreamingGenerateData()
+{
+  if( !m_FrameProvider )
+    {
+    itkExceptionMacro( << "No frame provider has been set" );
+    }
+
+  this->AllocateOutputs();
+
+  OutputVideoStreamType * output = this->GetOutput();
+  const TemporalRegion requestedTemporalRegion =
+    output->GetRequestedTemporalRegion();
+  const SizeValueType frameStart = requestedTemporalRegion.GetFrameStart();
+  const SizeValueType frameEnd =
+    frameStart + requestedTemporalRegion.GetFrameDuration();
+
+  for( SizeValueType frameNumber = frameStart; frameNumber < frameEnd;
+       ++frameNumber )
+    {
+    if( !m_FrameProvider( frameNumber, output->GetFrame( frameNumber ) ) )
+      {
+      itkExceptionMacro( << "Frame " << frameNumber << " is not available" );
+      }
+    }
+}
+
+template< typename TOutputVideoStream >
+void
+FrameProviderVideoSource< TOutputVideoStream >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "StartFrame: " << m_StartFrame << std::endl;
+  os << indent << "NumberOfFrames: " << m_NumberOfFrames << std::endl;
+  os << indent << "FrameRegion: " << m_FrameRegion << std::endl;
+  os << indent << "FrameSpacing: " << m_FrameSpacing << std::endl;
+  os << indent << "FrameOrigin: " << m_FrameOrigin << std::endl;
+}
+
+} // end namespace itk
+
+#endif
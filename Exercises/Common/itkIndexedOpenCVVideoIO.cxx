@@ -0,0 +1,86 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkIndexedOpenCVVideoIO.h"
+
+namespace itk
+{
+
+bool
+IndexedOpenCVVideoIO::CanReadFile( const char * filename )
+{
+  bridge::VideoSeekIndex index;
+  return index.Load( filename ) && Superclass::CanReadFile( filename );
+}
+
+void
+IndexedOpenCVVideoIO::ReadImageInformation()
+{
+  Superclass::ReadImageInformation();
+
+  if( !m_SeekIndex.Load( this->GetFileName() ) )
+    {
+    itkExceptionMacro( << "The seek index of " << this->GetFileName()
+                       << " is missing or out of date" );
+    }
+  this->m_FrameTotal = m_SeekIndex.GetNumberOfFrames();
+  this->m_LastIFrame = this->m_FrameTotal > 0 ? this->m_FrameTotal - 1 : 0;
+}
+
+bool
+IndexedOpenCVVideoIO::SetNextFrameToRead( FrameOffsetType frameNumber )
+{
+  if( frameNumber >= this->m_FrameTotal )
+    {
+    return false;
+    }
+
+  // Before the first key frame, decode from the start of the video
+  size_t keyFrame = 0;
+  if( !m_SeekIndex.GetKeyFrame( frameNumber, keyFrame ) )
+    {
+    keyFrame = 0;
+    }
+  if( !Superclass::SetNextFrameToRead( keyFrame ) )
+    {
+    return false;
+    }
+
+  m_Scratch.resize( this->GetImageSizeInBytes() );
+  for( FrameOffsetType frame = keyFrame; frame < frameNumber; ++frame )
+    {
+    Superclass::Read( &m_Scratch[0] );
+    }
+  return true;
+}
+
+bool
+IndexedOpenCVVideoIO::CanWriteFile( const char * itkNotUsed(filename) )
+{
+  return false;
+}
+
+void
+IndexedOpenCVVideoIO::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfKeyFrames: " << m_SeekIndex.GetNumberOfKeyFrames()
+     << std::endl;
+}
+
+} // end namespace itk
@@ -0,0 +1,82 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkIndexedOpenCVVideoIO_h
+#define __itkIndexedOpenCVVideoIO_h
+
+#include <vector>
+
+#include "itkOpenCVVideoIO.h"
+
+#include "VideoSeekIndex.h"
+
+namespace itk
+{
+
+/** \class IndexedOpenCVVideoIO
+ * \brief OpenCVVideoIO that seeks exactly with the seek index of the file.
+ *
+ * OpenCVVideoIO seeks with CV_CAP_PROP_POS_FRAMES, which lands on the wrong
+ * frame with many codecs. This VideoIO only reads the files that have a
+ * seek index (see VideoSeekIndex.h and the BuildVideoSeekIndex tool). It
+ * seeks to the last key frame of the index before the requested frame and
+ * decodes the frames in between, so a VideoFileReader asked for a temporal
+ * region in the middle of a long video reads the right frames without
+ * decoding the video from its start. The number of frames also comes from
+ * the index rather than from the estimate of the container.
+ */
+class IndexedOpenCVVideoIO : public OpenCVVideoIO
+{
+public:
+
+  /** Standard class typedefs */
+  typedef IndexedOpenCVVideoIO  Self;
+  typedef OpenCVVideoIO         Superclass;
+  typedef SmartPointer< Self >  Pointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(IndexedOpenCVVideoIO, OpenCVVideoIO);
+
+  /** Only the files with a valid seek index are read */
+  virtual bool CanReadFile( const char * filename );
+
+  /** Read the video properties and the seek index */
+  virtual void ReadImageInformation();
+
+  /** Seek to the last key frame before frameNumber and decode up to it */
+  virtual bool SetNextFrameToRead( FrameOffsetType frameNumber );
+
+  /** Nothing is written through this class */
+  virtual bool CanWriteFile( const char * filename );
+
+protected:
+  IndexedOpenCVVideoIO() {}
+  ~IndexedOpenCVVideoIO() {}
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+  IndexedOpenCVVideoIO( const Self & ); //purposely not implemented
+  void operator=( const Self & ); //purposely not implemented
+
+  bridge::VideoSeekIndex m_SeekIndex;
+  std::vector< char >    m_Scratch;
+};
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,47 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkIndexedOpenCVVideoIOFactory.h"
+#include "itkIndexedOpenCVVideoIO.h"
+#include "itkVersion.h"
+
+namespace itk
+{
+
+IndexedOpenCVVideoIOFactory::IndexedOpenCVVideoIOFactory()
+{
+  this->RegisterOverride( "itkVideoIOBase",
+                          "itkIndexedOpenCVVideoIO",
+                          "Indexed OpenCV Video IO",
+                          1,
+                          CreateObjectFunction< IndexedOpenCVVideoIO >::New() );
+}
+
+const char *
+IndexedOpenCVVideoIOFactory::GetITKSourceVersion() const
+{
+  return ITK_SOURCE_VERSION;
+}
+
+const char *
+IndexedOpenCVVideoIOFactory::GetDescription() const
+{
+  return "Indexed OpenCV VideoIO Factory, allows exact seeks in the videos "
+         "that have a seek index";
+}
+
+} // end namespace itk
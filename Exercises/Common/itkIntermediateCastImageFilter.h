@@ -0,0 +1,65 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkIntermediateCastImageFilter_h
+#define __itkIntermediateCastImageFilter_h
+
+#include "itkUnaryFunctorImageFilter.h"
+#include "itkIntermediatePixelTraits.h"
+
+namespace itk
+{
+
+/** \class IntermediateCastImageFilter
+ * \brief Cast an intermediate image, float or fixed point, to the output
+ * pixel type.
+ *
+ * On a float image this is CastImageFilter. On a fixed point image the
+ * stored values are first turned back into real values, see
+ * IntermediatePixelTraits.
+ */
+template< typename TInputImage, typename TOutputImage >
+class IntermediateCastImageFilter :
+  public UnaryFunctorImageFilter< TInputImage, TOutputImage,
+    Functor::IntermediateToPixel< typename TInputImage::PixelType,
+                                  typename TOutputImage::PixelType > >
+{
+public:
+  /** Standard class typedefs */
+  typedef IntermediateCastImageFilter Self;
+  typedef UnaryFunctorImageFilter< TInputImage, TOutputImage,
+    Functor::IntermediateToPixel< typename TInputImage::PixelType,
+                                  typename TOutputImage::PixelType > >
+                                      Superclass;
+  typedef SmartPointer< Self >        Pointer;
+  typedef SmartPointer< const Self >  ConstPointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(IntermediateCastImageFilter, UnaryFunctorImageFilter);
+
+protected:
+  IntermediateCastImageFilter() {}
+  virtual ~IntermediateCastImageFilter() {}
+
+private:
+  IntermediateCastImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);              //purposely not implemented
+};
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,125 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkIntermediatePixelTraits_h
+#define __itkIntermediatePixelTraits_h
+
+#include "itkNumericTraits.h"
+
+namespace itk
+{
+
+/** \class IntermediatePixelTraits
+ * \brief How a pixel type holds the real values of an intermediate image.
+ *
+ * The exercises keep the output of CurvatureFlow in a RealPixelType image
+ * before casting it back to 8 bits. With float, the default, a pixel holds
+ * the real value itself. With unsigned short, it holds the value in Q8.8
+ * fixed point: 8 integer bits for the [0, 256) range of the 8-bit frames
+ * and 8 fraction bits, a step of 1/256, in half the bytes of a float.
+ * Values are rounded to the nearest step and clamped to the range.
+ */
+template< typename TPixel >
+class IntermediatePixelTraits
+{
+public:
+  typedef TPixel PixelType;
+
+  itkStaticConstMacro(IsFixedPoint, bool, false);
+
+  /** Stored value of 1.0 */
+  static double GetScale()
+  {
+    return 1.0;
+  }
+
+  static PixelType FromReal(double value)
+  {
+    return static_cast< PixelType >( value );
+  }
+
+  static double ToReal(PixelType value)
+  {
+    return static_cast< double >( value );
+  }
+};
+
+template<>
+class IntermediatePixelTraits< unsigned short >
+{
+public:
+  typedef unsigned short PixelType;
+
+  itkStaticConstMacro(IsFixedPoint, bool, true);
+  itkStaticConstMacro(FractionBits, unsigned int, 8);
+
+  static double GetScale()
+  {
+    return static_cast< double >( 1 << FractionBits );
+  }
+
+  static PixelType FromReal(double value)
+  {
+    const double scaled = value * GetScale() + 0.5;
+    if( scaled <= 0.0 )
+      {
+      return 0;
+      }
+    if( scaled >= static_cast< double >( NumericTraits< PixelType >::max() ) )
+      {
+      return NumericTraits< PixelType >::max();
+      }
+    return static_cast< PixelType >( scaled );
+  }
+
+  static double ToReal(PixelType value)
+  {
+    return static_cast< double >( value ) / GetScale();
+  }
+};
+
+namespace Functor
+{
+/** \class IntermediateToPixel
+ * \brief Cast the real value held by an intermediate pixel, as
+ * CastImageFilter casts a float pixel.
+ */
+template< typename TInput, typename TOutput >
+class IntermediateToPixel
+{
+public:
+  bool operator!=(const IntermediateToPixel &) const
+  {
+    return false;
+  }
+
+  bool operator==(const IntermediateToPixel & other) const
+  {
+    return !( *this != other );
+  }
+
+  inline TOutput operator()(const TInput & value) const
+  {
+    return static_cast< TOutput >(
+      IntermediatePixelTraits< TInput >::ToReal( value ) );
+  }
+};
+} // end namespace Functor
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,130 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkOpenCVCaptureVideoSource_h
+#define __itkOpenCVCaptureVideoSource_h
+
+#include <functional>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include "itkFrameProviderVideoSource.h"
+
+namespace itk
+{
+
+/** \class OpenCVCaptureVideoSource
+ * \brief Video source reading its frames from a cv::VideoCapture, or from
+ * any callback supplying cv::Mat frames, without going through a
+ * VideoFileReader and a VideoIO.
+ *
+ * The frames are read in order, once each: a capture device cannot go
+ * back, and the temporal pipeline only asks for the frames it has not
+ * buffered yet. Frames requested after a gap are read and dropped; asking
+ * again for a frame already read throws an exception.
+ *
+ * The callback is given a cv::Mat header on the buffer of the output frame.
+ * A callback writing into it, such as bridge::FrameSource::Read(), fills
+ * the frame without any copy. Otherwise the Mat it leaves is converted into
+ * the frame: color frames to gray, with the color conversion of
+ * itk::OpenCVImageBridge, and other depths to the output pixel type. A
+ * cv::VideoCapture decodes BGR frames, which are converted straight into
+ * the output frame.
+ *
+ * SetVideoCapture() takes the frame size from the capture, but not the
+ * number of frames: the frame count a cv::VideoCapture reports is an
+ * estimate from the container, and frames it counts but cannot decode
+ * would make the source throw halfway through the video. SetNumberOfFrames()
+ * bounds the video for a writer, with an exact count such as the one of a
+ * bridge::VideoSeekIndex, or the frames are pulled one at a time.
+ */
+template< typename TOutputVideoStream >
+class OpenCVCaptureVideoSource :
+  public FrameProviderVideoSource< TOutputVideoStream >
+{
+public:
+
+  /** Standard class typedefs */
+  typedef OpenCVCaptureVideoSource< TOutputVideoStream >      Self;
+  typedef FrameProviderVideoSource< TOutputVideoStream >      Superclass;
+  typedef SmartPointer< Self >                                Pointer;
+  typedef SmartPointer< const Self >                          ConstPointer;
+
+  typedef TOutputVideoStream                                  OutputVideoStreamType;
+  typedef typename Superclass::FrameType                      FrameType;
+  typedef typename FrameType::PixelType                       PixelType;
+  typedef typename Superclass::FrameRegionType                FrameRegionType;
+
+  /** Supplies the next frame, in the given Mat. Returns false at the end
+   * of the video. */
+  typedef std::function< bool ( cv::Mat & ) >                 MatProviderType;
+
+  itkNewMacro(Self);
+  itkTypeMacro(OpenCVCaptureVideoSource, FrameProviderVideoSource);
+
+  /** Set the callback supplying the frames. The frame region and the
+   * number of frames have to be set as well. */
+  void SetMatProvider(const MatProviderType & provider);
+
+  /** Read the frames from an opened capture, which must outlive the
+   * source */
+  void SetVideoCapture(cv::VideoCapture * capture);
+
+  /** Frame rate given by the capture, 0 if unknown */
+  itkGetConstMacro(FramesPerSecond, double);
+
+  /** Number of frames the capture reports, 0 if unknown. Not used as the
+   * number of frames of the video. */
+  itkGetConstMacro(EstimatedNumberOfFrames, SizeValueType);
+
+  /** Set the frame region from a frame size */
+  void SetFrameSize(const cv::Size & size);
+
+  /** Frames filled in place by the callback, and frames it supplied in a
+   * Mat of its own that had to be converted */
+  itkGetConstMacro(NumberOfDirectFrames, SizeValueType);
+  itkGetConstMacro(NumberOfConvertedFrames, SizeValueType);
+
+protected:
+  OpenCVCaptureVideoSource();
+  virtual ~OpenCVCaptureVideoSource() {}
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+  /** Read frames up to frameNumber, the last one into frame */
+  bool ReadFrame(SizeValueType frameNumber, FrameType * frame);
+
+private:
+  OpenCVCaptureVideoSource(const Self &); //purposely not implemented
+  void operator=(const Self &);           //purposely not implemented
+
+  MatProviderType    m_MatProvider;
+  cv::Mat            m_Captured;
+  double             m_FramesPerSecond;
+  SizeValueType      m_EstimatedNumberOfFrames;
+  SizeValueType      m_NextFrame;
+  SizeValueType      m_NumberOfDirectFrames;
+  SizeValueType      m_NumberOfConvertedFrames;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkOpenCVCaptureVideoSource.hxx"
+#endif
+
+#endif
@@ -0,0 +1,161 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkOpenCVCaptureVideoSource_hxx
+#define __itkOpenCVCaptureVideoSource_hxx
+
+#include "itkOpenCVCaptureVideoSource.h"
+#include "FrameBatch.h"
+
+namespace itk
+{
+
+template< typename TOutputVideoStream >
+OpenCVCaptureVideoSource< TOutputVideoStream >
+::OpenCVCaptureVideoSource()
+{
+  m_FramesPerSecond = 0.0;
+  m_EstimatedNumberOfFrames = 0;
+  m_NextFrame = 0;
+  m_NumberOfDirectFrames = 0;
+  m_NumberOfConvertedFrames = 0;
+  this->SetFrameProvider( [this]( SizeValueType frameNumber, FrameType * frame )
+    {
+    return this->ReadFrame( frameNumber, frame );
+    } );
+}
+
+template< typename TOutputVideoStream >
+void
+OpenCVCaptureVideoSource< TOutputVideoStream >
+::SetMatProvider(const MatProviderType & provider)
+{
+  m_MatProvider = provider;
+  m_NextFrame = this->GetStartFrame();
+  this->Modified();
+}
+
+template< typename TOutputVideoStream >
+void
+OpenCVCaptureVideoSource< TOutputVideoStream >
+::SetVideoCapture(cv::VideoCapture * capture)
+{
+  if( !capture || !capture->isOpened() )
+    {
+    itkExceptionMacro( << "The video capture is not opened" );
+    }
+
+  this->SetFrameSize( cv::Size(
+    static_cast< int >( capture->get( CV_CAP_PROP_FRAME_WIDTH ) ),
+    static_cast< int >( capture->get( CV_CAP_PROP_FRAME_HEIGHT ) ) ) );
+  m_FramesPerSecond = capture->get( CV_CAP_PROP_FPS );
+  // Only an estimate, from the container header or the duration; the
+  // number of frames is left to the caller
+  const double frameCount = capture->get( CV_CAP_PROP_FRAME_COUNT );
+  m_EstimatedNumberOfFrames =
+    frameCount > 0 ? static_cast< SizeValueType >( frameCount ) : 0;
+
+  // Decode into a BGR frame of our own, converted into the output frame
+  this->SetMatProvider( [this, capture]( cv::Mat & frame )
+    {
+    if( !capture->read( m_Captured ) )
+      {
+      return false;
+      }
+    frame = m_Captured;
+    return true;
+    } );
+}
+
+template< typename TOutputVideoStream >
+void
+OpenCVCaptureVideoSource< TOutputVideoStream >
+::SetFrameSize(const cv::Size & size)
+{
+  FrameRegionType region;
+  region.SetSize( 0, size.width );
+  region.SetSize( 1, size.height );
+  this->SetFrameRegion( region );
+}
+
+template< typename TOutputVideoStream >
+bool
+OpenCVCaptureVideoSource< TOutputVideoStream >
+::ReadFrame(SizeValueType frameNumber, FrameType * frame)
+{
+  if( !m_MatProvider )
+    {
+    itkExceptionMacro( << "No video capture or frame callback has been set" );
+    }
+  if( frameNumber < m_NextFrame )
+    {
+    itkExceptionMacro( << "Frame " << frameNumber << " was already read, the "
+                       << "next frame of the capture is " << m_NextFrame );
+    }
+
+  const typename FrameType::SizeType size = frame->GetBufferedRegion().GetSize();
+  cv::Mat view( static_cast< int >( size[1] ), static_cast< int >( size[0] ),
+                cv::DataType< PixelType >::type, frame->GetBufferPointer() );
+  for( ; m_NextFrame <= frameNumber; ++m_NextFrame )
+    {
+    cv::Mat target = view;
+    if( !m_MatProvider( target ) )
+      {
+      return false;
+      }
+    if( m_NextFrame < frameNumber )
+      {
+      // Dropped frame
+      continue;
+      }
+    if( target.data == view.data )
+      {
+      ++m_NumberOfDirectFrames;
+      continue;
+      }
+    if( target.size() != view.size() )
+      {
+      itkExceptionMacro( << "Frame " << frameNumber << " is " << target.cols
+                         << "x" << target.rows << ", not " << view.cols
+                         << "x" << view.rows );
+      }
+    bridge::ConvertToGrayView( target, view );
+    ++m_NumberOfConvertedFrames;
+    }
+  frame->Modified();
+  return true;
+}
+
+template< typename TOutputVideoStream >
+void
+OpenCVCaptureVideoSource< TOutputVideoStream >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "FramesPerSecond: " << m_FramesPerSecond << std::endl;
+  os << indent << "EstimatedNumberOfFrames: " << m_EstimatedNumberOfFrames
+     << std::endl;
+  os << indent << "NextFrame: " << m_NextFrame << std::endl;
+  os << indent << "NumberOfDirectFrames: " << m_NumberOfDirectFrames << std::endl;
+  os << indent << "NumberOfConvertedFrames: " << m_NumberOfConvertedFrames
+     << std::endl;
+}
+
+} // end namespace itk
+
+#endif
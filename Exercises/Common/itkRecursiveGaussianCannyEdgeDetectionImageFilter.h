@@ -0,0 +1,127 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRecursiveGaussianCannyEdgeDetectionImageFilter_h
+#define __itkRecursiveGaussianCannyEdgeDetectionImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkCannyEdgeDetectionImageFilter.h"
+#include "itkSmoothingRecursiveGaussianImageFilter.h"
+
+namespace itk
+{
+
+/** \class RecursiveGaussianCannyEdgeDetectionImageFilter
+ * \brief CannyEdgeDetectionImageFilter whose Gaussian smoothing can be done
+ * by a recursive (IIR) filter.
+ *
+ * CannyEdgeDetectionImageFilter smooths with DiscreteGaussianImageFilter,
+ * whose kernel, and cost per pixel, grows with the square root of the
+ * variance. With UseRecursiveGaussian on, the input is smoothed by
+ * SmoothingRecursiveGaussianImageFilter with the same standard deviation,
+ * at a cost per pixel that does not depend on the variance, and Canny then
+ * runs with a zero variance, i.e. without smoothing of its own. The edges
+ * are close to those of the discrete smoothing but not identical: the
+ * recursive filter approximates the Gaussian and does not truncate it (see
+ * the CannySmoothingBenchmark). With UseRecursiveGaussian off, or a zero
+ * variance, which has nothing to smooth and which the recursive filter
+ * rejects, this filter is CannyEdgeDetectionImageFilter.
+ */
+template< typename TInputImage, typename TOutputImage >
+class RecursiveGaussianCannyEdgeDetectionImageFilter :
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+
+  /** Standard class typedefs */
+  typedef RecursiveGaussianCannyEdgeDetectionImageFilter Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(RecursiveGaussianCannyEdgeDetectionImageFilter, ImageToImageFilter);
+
+  typedef TInputImage                                     InputImageType;
+  typedef TOutputImage                                    OutputImageType;
+  typedef typename OutputImageType::PixelType             OutputPixelType;
+  typedef CannyEdgeDetectionImageFilter< InputImageType, OutputImageType >
+                                                          DiscreteCannyFilterType;
+  typedef SmoothingRecursiveGaussianImageFilter< InputImageType, OutputImageType >
+                                                          SmoothingFilterType;
+  typedef CannyEdgeDetectionImageFilter< OutputImageType, OutputImageType >
+                                                          RecursiveCannyFilterType;
+
+  /** Variance of the Gaussian smoothing, as for CannyEdgeDetectionImageFilter */
+  itkSetMacro(Variance, double);
+  itkGetConstMacro(Variance, double);
+
+  /** Maximum error of the discrete Gaussian kernel */
+  itkSetMacro(MaximumError, double);
+  itkGetConstMacro(MaximumError, double);
+
+  /** Hysteresis thresholds */
+  itkSetMacro(LowerThreshold, OutputPixelType);
+  itkGetConstMacro(LowerThreshold, OutputPixelType);
+  itkSetMacro(UpperThreshold, OutputPixelType);
+  itkGetConstMacro(UpperThreshold, OutputPixelType);
+
+  /** Smooth with the recursive Gaussian filter (default off) */
+  itkSetMacro(UseRecursiveGaussian, bool);
+  itkGetConstMacro(UseRecursiveGaussian, bool);
+  itkBooleanMacro(UseRecursiveGaussian);
+
+protected:
+  RecursiveGaussianCannyEdgeDetectionImageFilter();
+  virtual ~RecursiveGaussianCannyEdgeDetectionImageFilter() {}
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+  /** The input is the output region padded by the support of the
+   * smoothing and of the derivatives. The hysteresis still follows edges
+   * beyond that halo, so the filter is not run on tiles (see
+   * TiledExecution.h) */
+  virtual void GenerateInputRequestedRegion();
+
+  /** Pixels of support on each side of an output pixel */
+  SizeValueType GetHaloRadius() const;
+
+  /** Whether the input is smoothed by the recursive filter */
+  bool SmoothsRecursively() const;
+
+  virtual void GenerateData();
+
+private:
+  RecursiveGaussianCannyEdgeDetectionImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);                                 //purposely not implemented
+
+  typename DiscreteCannyFilterType::Pointer  m_DiscreteCannyFilter;
+  typename SmoothingFilterType::Pointer      m_SmoothingFilter;
+  typename RecursiveCannyFilterType::Pointer m_RecursiveCannyFilter;
+  double                                     m_Variance;
+  double                                     m_MaximumError;
+  OutputPixelType                            m_LowerThreshold;
+  OutputPixelType                            m_UpperThreshold;
+  bool                                       m_UseRecursiveGaussian;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRecursiveGaussianCannyEdgeDetectionImageFilter.hxx"
+#endif
+
+#endif
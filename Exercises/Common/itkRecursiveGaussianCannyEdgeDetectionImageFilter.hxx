@@ -0,0 +1,166 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRecursiveGaussianCannyEdgeDetectionImageFilter_hxx
+#define __itkRecursiveGaussianCannyEdgeDetectionImageFilter_hxx
+
+#include <cmath>
+
+#include "itkRecursiveGaussianCannyEdgeDetectionImageFilter.h"
+#include "itkGaussianOperator.h"
+
+namespace itk
+{
+
+template< typename TInputImage, typename TOutputImage >
+RecursiveGaussianCannyEdgeDetectionImageFilter< TInputImage, TOutputImage >
+::RecursiveGaussianCannyEdgeDetectionImageFilter()
+{
+  m_DiscreteCannyFilter = DiscreteCannyFilterType::New();
+  m_SmoothingFilter = SmoothingFilterType::New();
+  m_RecursiveCannyFilter = RecursiveCannyFilterType::New();
+  m_RecursiveCannyFilter->SetInput( m_SmoothingFilter->GetOutput() );
+
+  m_Variance = 0.0;
+  m_MaximumError = 0.01;
+  m_LowerThreshold = NumericTraits< OutputPixelType >::Zero;
+  m_UpperThreshold = NumericTraits< OutputPixelType >::Zero;
+  m_UseRecursiveGaussian = false;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+RecursiveGaussianCannyEdgeDetectionImageFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType * input = const_cast< InputImageType * >( this->GetInput() );
+  if( !input )
+    {
+    return;
+    }
+  typename InputImageType::RegionType requested =
+    this->GetOutput()->GetRequestedRegion();
+  requested.PadByRadius( this->GetHaloRadius() );
+  requested.Crop( input->GetLargestPossibleRegion() );
+  input->SetRequestedRegion( requested );
+}
+
+template< typename TInputImage, typename TOutputImage >
+bool
+RecursiveGaussianCannyEdgeDetectionImageFilter< TInputImage, TOutputImage >
+::SmoothsRecursively() const
+{
+  // A zero sigma throws in the recursive filter; the discrete path then
+  // gives the same unsmoothed edges
+  return m_UseRecursiveGaussian && m_Variance > 0.0;
+}
+
+template< typename TInputImage, typename TOutputImage >
+SizeValueType
+RecursiveGaussianCannyEdgeDetectionImageFilter< TInputImage, TOutputImage >
+::GetHaloRadius() const
+{
+  // Two more pixels for the derivatives and the non-maximum suppression
+  if( this->SmoothsRecursively() )
+    {
+    // The recursive Gaussian has an infinite support, negligible beyond
+    // four standard deviations
+    return static_cast< SizeValueType >(
+      std::ceil( 4.0 * std::sqrt( m_Variance ) ) ) + 2;
+    }
+  // The kernel CannyEdgeDetectionImageFilter builds
+  GaussianOperator< double, InputImageType::ImageDimension > oper;
+  oper.SetDirection( 0 );
+  oper.SetVariance( m_Variance );
+  oper.SetMaximumError( m_MaximumError );
+  oper.SetMaximumKernelWidth( 32 );
+  oper.CreateDirectional();
+  return oper.GetRadius( 0 ) + 2;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+RecursiveGaussianCannyEdgeDetectionImageFilter< TInputImage, TOutputImage >
+::GenerateData()
+{
+  // The internal filters see the buffered input as the whole image, so that
+  // on a tile they do not ask the upstream filters for a larger region. The
+  // edges they find in the halo are computed with fewer neighbors and only
+  // the output requested region is used downstream.
+  typename InputImageType::Pointer input = InputImageType::New();
+  input->Graft( this->GetInput() );
+  input->SetLargestPossibleRegion( input->GetBufferedRegion() );
+  const typename OutputImageType::RegionType largestRegion =
+    this->GetOutput()->GetLargestPossibleRegion();
+
+  if( this->SmoothsRecursively() )
+    {
+    m_SmoothingFilter->SetInput( input );
+    m_SmoothingFilter->SetSigma( std::sqrt( m_Variance ) );
+    // The input is already smoothed: a zero variance gives Canny a kernel
+    // of a single tap
+    m_RecursiveCannyFilter->SetVariance( 0.0 );
+    m_RecursiveCannyFilter->SetMaximumError( m_MaximumError );
+    m_RecursiveCannyFilter->SetLowerThreshold( m_LowerThreshold );
+    m_RecursiveCannyFilter->SetUpperThreshold( m_UpperThreshold );
+    m_RecursiveCannyFilter->GraftOutput( this->GetOutput() );
+    m_RecursiveCannyFilter->Update();
+    this->GraftOutput( m_RecursiveCannyFilter->GetOutput() );
+
+    // Do not keep a reference to the input frame
+    m_SmoothingFilter->SetInput( NULL );
+    }
+  else
+    {
+    m_DiscreteCannyFilter->SetInput( input );
+    m_DiscreteCannyFilter->SetVariance( m_Variance );
+    m_DiscreteCannyFilter->SetMaximumError( m_MaximumError );
+    m_DiscreteCannyFilter->SetLowerThreshold( m_LowerThreshold );
+    m_DiscreteCannyFilter->SetUpperThreshold( m_UpperThreshold );
+    m_DiscreteCannyFilter->GraftOutput( this->GetOutput() );
+    m_DiscreteCannyFilter->Update();
+    this->GraftOutput( m_DiscreteCannyFilter->GetOutput() );
+
+    m_DiscreteCannyFilter->SetInput( NULL );
+    }
+  this->GetOutput()->SetLargestPossibleRegion( largestRegion );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+RecursiveGaussianCannyEdgeDetectionImageFilter< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Variance: " << m_Variance << std::endl;
+  os << indent << "MaximumError: " << m_MaximumError << std::endl;
+  os << indent << "LowerThreshold: "
+     << static_cast< typename NumericTraits< OutputPixelType >::PrintType >( m_LowerThreshold )
+     << std::endl;
+  os << indent << "UpperThreshold: "
+     << static_cast< typename NumericTraits< OutputPixelType >::PrintType >( m_UpperThreshold )
+     << std::endl;
+  os << indent << "UseRecursiveGaussian: "
+     << ( m_UseRecursiveGaussian ? "On" : "Off" ) << std::endl;
+}
+
+} // end namespace itk
+
+#endif
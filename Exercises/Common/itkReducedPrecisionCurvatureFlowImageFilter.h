@@ -0,0 +1,115 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkReducedPrecisionCurvatureFlowImageFilter_h
+#define __itkReducedPrecisionCurvatureFlowImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkConvergentCurvatureFlowImageFilter.h"
+#include "itkIntermediatePixelTraits.h"
+
+namespace itk
+{
+
+/** \class ReducedPrecisionCurvatureFlowImageFilter
+ * \brief ConvergentCurvatureFlowImageFilter whose output may be stored with
+ * less precision than float.
+ *
+ * CurvatureFlow iterates on a float image: its small updates would be lost
+ * in an integer image. This filter runs it on float internally and then
+ * stores the result in the output pixel type through
+ * IntermediatePixelTraits, e.g. Q8.8 fixed point in unsigned short. Only
+ * the float image of the frame being filtered exists; the frames buffered
+ * and passed downstream use the smaller type.
+ *
+ * With a float output the internal filter writes straight into the output
+ * and this filter is ConvergentCurvatureFlowImageFilter.
+ */
+template< typename TInputImage, typename TOutputImage >
+class ReducedPrecisionCurvatureFlowImageFilter :
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+
+  /** Standard class typedefs */
+  typedef ReducedPrecisionCurvatureFlowImageFilter        Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(ReducedPrecisionCurvatureFlowImageFilter, ImageToImageFilter);
+
+  typedef TInputImage                                     InputImageType;
+  typedef TOutputImage                                    OutputImageType;
+  typedef typename OutputImageType::PixelType             OutputPixelType;
+  typedef Image< float, TOutputImage::ImageDimension >    RealImageType;
+  typedef ConvergentCurvatureFlowImageFilter< InputImageType, RealImageType >
+                                                          CurvatureFlowFilterType;
+  typedef IntermediatePixelTraits< OutputPixelType >      TraitsType;
+  typedef typename CurvatureFlowFilterType::TimeStepType  TimeStepType;
+
+  /** Parameters of the CurvatureFlow filter */
+  itkSetMacro(TimeStep, TimeStepType);
+  itkGetConstMacro(TimeStep, TimeStepType);
+  itkSetMacro(NumberOfIterations, IdentifierType);
+  itkGetConstMacro(NumberOfIterations, IdentifierType);
+  itkSetMacro(MaximumRMSError, double);
+  itkGetConstMacro(MaximumRMSError, double);
+
+  /** Iterations run by the last update and RMS change of the last one */
+  IdentifierType GetElapsedIterations() const
+  {
+    return m_CurvatureFlowFilter->GetElapsedIterations();
+  }
+
+  double GetRMSChange() const
+  {
+    return m_CurvatureFlowFilter->GetRMSChange();
+  }
+
+protected:
+  ReducedPrecisionCurvatureFlowImageFilter();
+  virtual ~ReducedPrecisionCurvatureFlowImageFilter() {}
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+  /** With a fixed number of iterations the output is padded by one pixel
+   * per iteration, as CurvatureFlowImageFilter does, so the filter can run
+   * on tiles (see TiledExecution.h). With a tolerance the iterations depend
+   * on the whole image, which is always filtered whole. */
+  virtual void GenerateInputRequestedRegion();
+  virtual void EnlargeOutputRequestedRegion(DataObject *output);
+
+  virtual void GenerateData();
+
+private:
+  ReducedPrecisionCurvatureFlowImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);                           //purposely not implemented
+
+  typename CurvatureFlowFilterType::Pointer m_CurvatureFlowFilter;
+  TimeStepType                              m_TimeStep;
+  IdentifierType                            m_NumberOfIterations;
+  double                                    m_MaximumRMSError;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkReducedPrecisionCurvatureFlowImageFilter.hxx"
+#endif
+
+#endif
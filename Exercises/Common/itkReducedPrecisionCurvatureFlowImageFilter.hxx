@@ -0,0 +1,165 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkReducedPrecisionCurvatureFlowImageFilter_hxx
+#define __itkReducedPrecisionCurvatureFlowImageFilter_hxx
+
+#include <type_traits>
+
+#include "itkReducedPrecisionCurvatureFlowImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+
+namespace itk
+{
+
+template< typename TInputImage, typename TOutputImage >
+ReducedPrecisionCurvatureFlowImageFilter< TInputImage, TOutputImage >
+::ReducedPrecisionCurvatureFlowImageFilter()
+{
+  m_CurvatureFlowFilter = CurvatureFlowFilterType::New();
+  m_TimeStep = m_CurvatureFlowFilter->GetTimeStep();
+  m_NumberOfIterations = m_CurvatureFlowFilter->GetNumberOfIterations();
+  m_MaximumRMSError = m_CurvatureFlowFilter->GetMaximumRMSError();
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+ReducedPrecisionCurvatureFlowImageFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType * input = const_cast< InputImageType * >( this->GetInput() );
+  if( !input )
+    {
+    return;
+    }
+  if( m_MaximumRMSError > 0.0 )
+    {
+    input->SetRequestedRegionToLargestPossibleRegion();
+    return;
+    }
+
+  // The output region, already padded by EnlargeOutputRequestedRegion()
+  typename InputImageType::RegionType requested =
+    this->GetOutput()->GetRequestedRegion();
+  requested.Crop( input->GetLargestPossibleRegion() );
+  input->SetRequestedRegion( requested );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+ReducedPrecisionCurvatureFlowImageFilter< TInputImage, TOutputImage >
+::EnlargeOutputRequestedRegion(DataObject *output)
+{
+  Superclass::EnlargeOutputRequestedRegion( output );
+  if( m_MaximumRMSError > 0.0 )
+    {
+    output->SetRequestedRegionToLargestPossibleRegion();
+    return;
+    }
+
+  // As CurvatureFlowImageFilter, pad the output by one pixel per iteration
+  // so that the pixels of a tile do not depend on where the tile ends
+  OutputImageType * outputImage = dynamic_cast< OutputImageType * >( output );
+  if( outputImage )
+    {
+    typename OutputImageType::RegionType requested =
+      outputImage->GetRequestedRegion();
+    requested.PadByRadius( m_NumberOfIterations );
+    requested.Crop( outputImage->GetLargestPossibleRegion() );
+    outputImage->SetRequestedRegion( requested );
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+ReducedPrecisionCurvatureFlowImageFilter< TInputImage, TOutputImage >
+::GenerateData()
+{
+  const bool floatOutput = std::is_same< OutputImageType, RealImageType >::value;
+
+  // The internal filter sees the buffered input as the whole image, so
+  // that on a tile it does not pad its requests once more and ask the
+  // upstream filters for a larger region
+  typename InputImageType::Pointer input = InputImageType::New();
+  input->Graft( this->GetInput() );
+  input->SetLargestPossibleRegion( input->GetBufferedRegion() );
+  const typename OutputImageType::RegionType largestRegion =
+    this->GetOutput()->GetLargestPossibleRegion();
+
+  m_CurvatureFlowFilter->SetInput( input );
+  // The internal filter was created with the global default number of
+  // threads; use the one set on this filter
+  m_CurvatureFlowFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
+  m_CurvatureFlowFilter->SetTimeStep( m_TimeStep );
+  m_CurvatureFlowFilter->SetNumberOfIterations( m_NumberOfIterations );
+  m_CurvatureFlowFilter->SetMaximumRMSError( m_MaximumRMSError );
+  m_CurvatureFlowFilter->GetOutput()->SetRequestedRegion(
+    this->GetOutput()->GetRequestedRegion() );
+  if( floatOutput )
+    {
+    // Let the internal filter write into the output buffer
+    m_CurvatureFlowFilter->GraftOutput( this->GetOutput() );
+    }
+  m_CurvatureFlowFilter->Update();
+
+  if( floatOutput )
+    {
+    this->GraftOutput( m_CurvatureFlowFilter->GetOutput() );
+    this->GetOutput()->SetLargestPossibleRegion( largestRegion );
+    }
+  else
+    {
+    this->AllocateOutputs();
+
+    OutputImageType * output = this->GetOutput();
+    const RealImageType * real = m_CurvatureFlowFilter->GetOutput();
+    ImageRegionConstIterator< RealImageType > realIt( real,
+      output->GetRequestedRegion() );
+    ImageRegionIterator< OutputImageType > outputIt( output,
+      output->GetRequestedRegion() );
+    for( ; !outputIt.IsAtEnd(); ++realIt, ++outputIt )
+      {
+      outputIt.Set( TraitsType::FromReal( realIt.Get() ) );
+      }
+    // Only the smaller frame stays resident between frames
+    m_CurvatureFlowFilter->GetOutput()->ReleaseData();
+    }
+
+  // Do not keep a reference to the input frame
+  m_CurvatureFlowFilter->SetInput( NULL );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+ReducedPrecisionCurvatureFlowImageFilter< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "TimeStep: " << m_TimeStep << std::endl;
+  os << indent << "NumberOfIterations: " << m_NumberOfIterations << std::endl;
+  os << indent << "MaximumRMSError: " << m_MaximumRMSError << std::endl;
+  os << indent << "FixedPointOutput: "
+     << ( TraitsType::IsFixedPoint ? "On" : "Off" ) << std::endl;
+}
+
+} // end namespace itk
+
+#endif
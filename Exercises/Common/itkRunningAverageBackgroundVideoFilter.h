@@ -0,0 +1,167 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRunningAverageBackgroundVideoFilter_h
+#define __itkRunningAverageBackgroundVideoFilter_h
+
+#include "itkVideoToVideoFilter.h"
+#include "itkNumericTraits.h"
+
+namespace itk
+{
+
+/** \class RunningAverageBackgroundVideoFilter
+ * \brief Foreground mask of every frame against an exponential running
+ * average of the previous frames.
+ *
+ * The background model is one image of per-pixel means, updated after each
+ * frame as
+ *
+ *   mean = ( 1 - LearningRate ) * mean + LearningRate * frame
+ *
+ * A pixel is foreground when it differs from the mean of the previous frames
+ * by more than DifferenceThreshold gray levels. With UseVariance on, the
+ * model also keeps the exponentially weighted variance of every pixel, and a
+ * pixel is foreground when it lies more than StandardDeviationThreshold
+ * standard deviations from the mean. The standard deviation never drops
+ * below MinimumStandardDeviation, which is also its value after the first
+ * frame.
+ *
+ * Unlike FrameDifferenceVideoFilter the filter reads a single input frame
+ * per output frame, so the input VideoStream only buffers the current frame.
+ * The model has the size of one or two frames however long the history it
+ * averages, and every frame costs the same.
+ *
+ * The model follows the frames in order. It starts again from the current
+ * frame when the frames are not consecutive, when a parameter changes or
+ * after Reset(). The first frame is all background.
+ */
+template< typename TInputVideoStream, typename TOutputVideoStream >
+class RunningAverageBackgroundVideoFilter :
+  public VideoToVideoFilter< TInputVideoStream, TOutputVideoStream >
+{
+public:
+
+  /** Standard class typedefs */
+  typedef TInputVideoStream                           InputVideoStreamType;
+  typedef TOutputVideoStream                          OutputVideoStreamType;
+  typedef RunningAverageBackgroundVideoFilter<
+    InputVideoStreamType, OutputVideoStreamType >     Self;
+  typedef VideoToVideoFilter<
+    InputVideoStreamType, OutputVideoStreamType >     Superclass;
+  typedef SmartPointer< Self >                        Pointer;
+  typedef SmartPointer< const Self >                  ConstPointer;
+
+  typedef typename TInputVideoStream::FrameType       InputFrameType;
+  typedef typename InputFrameType::PixelType          InputPixelType;
+  typedef typename InputFrameType::RegionType         InputFrameSpatialRegionType;
+  typedef typename TOutputVideoStream::FrameType      OutputFrameType;
+  typedef typename OutputFrameType::PixelType         OutputPixelType;
+  typedef typename OutputFrameType::RegionType        OutputFrameSpatialRegionType;
+
+  /** The mean and variance images of the model */
+  typedef Image< float, InputFrameType::ImageDimension > ModelImageType;
+
+  itkNewMacro(Self);
+  itkTypeMacro(RunningAverageBackgroundVideoFilter, VideoToVideoFilter);
+
+  /** Weight of the current frame in the model, in (0, 1]. The model
+   * remembers about 1 / LearningRate frames. */
+  itkSetClampMacro(LearningRate, double, NumericTraits< double >::min(), 1.0);
+  itkGetConstMacro(LearningRate, double);
+
+  /** Keep a running variance and threshold in standard deviations */
+  itkSetMacro(UseVariance, bool);
+  itkGetConstMacro(UseVariance, bool);
+  itkBooleanMacro(UseVariance);
+
+  /** Foreground threshold, in gray levels, without the variance */
+  itkSetMacro(DifferenceThreshold, double);
+  itkGetConstMacro(DifferenceThreshold, double);
+
+  /** Foreground threshold, in standard deviations, with the variance */
+  itkSetMacro(StandardDeviationThreshold, double);
+  itkGetConstMacro(StandardDeviationThreshold, double);
+
+  /** Lower bound of the standard deviation of every pixel */
+  itkSetMacro(MinimumStandardDeviation, double);
+  itkGetConstMacro(MinimumStandardDeviation, double);
+
+  /** Values of the foreground and background pixels of the mask */
+  itkSetMacro(ForegroundValue, OutputPixelType);
+  itkGetConstMacro(ForegroundValue, OutputPixelType);
+  itkSetMacro(BackgroundValue, OutputPixelType);
+  itkGetConstMacro(BackgroundValue, OutputPixelType);
+
+  /** Drop the model; the next frame starts a new one */
+  void Reset();
+
+  /** The current background model. The variance is only kept with
+   * UseVariance on. */
+  const ModelImageType * GetMeanImage() const
+  {
+    return m_Mean.GetPointer();
+  }
+  const ModelImageType * GetVarianceImage() const
+  {
+    return m_Variance.GetPointer();
+  }
+
+protected:
+  RunningAverageBackgroundVideoFilter();
+  virtual ~RunningAverageBackgroundVideoFilter() {}
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+  /** Start a new model when needed */
+  virtual void BeforeThreadedGenerateData();
+
+  /** Classify the pixels of the region and update their model */
+  virtual void ThreadedGenerateData(
+    const OutputFrameSpatialRegionType & outputRegionForThread,
+    int threadId);
+
+  /** Move on to the next frame */
+  virtual void AfterThreadedGenerateData();
+
+private:
+  RunningAverageBackgroundVideoFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);                      //purposely not implemented
+
+  double          m_LearningRate;
+  bool            m_UseVariance;
+  double          m_DifferenceThreshold;
+  double          m_StandardDeviationThreshold;
+  double          m_MinimumStandardDeviation;
+  OutputPixelType m_ForegroundValue;
+  OutputPixelType m_BackgroundValue;
+
+  typename ModelImageType::Pointer m_Mean;
+  typename ModelImageType::Pointer m_Variance;
+
+  /** Frame the model expects next, and the time the model was started */
+  SizeValueType   m_NextFrame;
+  unsigned long   m_ModelTime;
+  bool            m_Initialize;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRunningAverageBackgroundVideoFilter.hxx"
+#endif
+
+#endif
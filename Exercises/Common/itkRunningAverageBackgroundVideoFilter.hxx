@@ -0,0 +1,226 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRunningAverageBackgroundVideoFilter_hxx
+#define __itkRunningAverageBackgroundVideoFilter_hxx
+
+#include "itkRunningAverageBackgroundVideoFilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+
+namespace itk
+{
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+RunningAverageBackgroundVideoFilter< TInputVideoStream, TOutputVideoStream >
+::RunningAverageBackgroundVideoFilter()
+{
+  m_LearningRate = 0.05;
+  m_UseVariance = false;
+  m_DifferenceThreshold = 25.0;
+  m_StandardDeviationThreshold = 2.5;
+  m_MinimumStandardDeviation = 4.0;
+  m_ForegroundValue = NumericTraits< OutputPixelType >::max();
+  m_BackgroundValue = NumericTraits< OutputPixelType >::Zero;
+
+  m_NextFrame = 0;
+  m_ModelTime = 0;
+  m_Initialize = true;
+
+  // One input frame per output frame: the model carries the history
+  this->TemporalProcessObject::m_UnitInputNumberOfFrames = 1;
+  this->TemporalProcessObject::m_UnitOutputNumberOfFrames = 1;
+  this->TemporalProcessObject::m_FrameSkipPerOutput = 1;
+  this->TemporalProcessObject::m_InputStencilCurrentFrameIndex = 0;
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+RunningAverageBackgroundVideoFilter< TInputVideoStream, TOutputVideoStream >
+::Reset()
+{
+  m_Initialize = true;
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+RunningAverageBackgroundVideoFilter< TInputVideoStream, TOutputVideoStream >
+::BeforeThreadedGenerateData()
+{
+  const InputVideoStreamType * input = this->GetInput();
+  const SizeValueType frameNumber =
+    input->GetRequestedTemporalRegion().GetFrameStart();
+  const InputFrameType * frame = input->GetFrame( frameNumber );
+  const InputFrameSpatialRegionType & frameRegion =
+    frame->GetLargestPossibleRegion();
+
+  if( frameNumber != m_NextFrame || this->GetMTime() > m_ModelTime )
+    {
+    m_Initialize = true;
+    }
+
+  typename ModelImageType::RegionType modelRegion;
+  modelRegion.SetIndex( frameRegion.GetIndex() );
+  modelRegion.SetSize( frameRegion.GetSize() );
+  if( m_Mean.IsNull() || m_Mean->GetBufferedRegion() != modelRegion )
+    {
+    m_Mean = ModelImageType::New();
+    m_Mean->SetRegions( modelRegion );
+    m_Mean->Allocate();
+    m_Initialize = true;
+    }
+  if( !m_UseVariance )
+    {
+    m_Variance = NULL;
+    }
+  else if( m_Variance.IsNull() || m_Variance->GetBufferedRegion() != modelRegion )
+    {
+    m_Variance = ModelImageType::New();
+    m_Variance->SetRegions( modelRegion );
+    m_Variance->Allocate();
+    m_Initialize = true;
+    }
+
+  if( m_Initialize )
+    {
+    m_ModelTime = this->GetMTime();
+    }
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+RunningAverageBackgroundVideoFilter< TInputVideoStream, TOutputVideoStream >
+::ThreadedGenerateData(const OutputFrameSpatialRegionType & outputRegionForThread,
+                       int itkNotUsed(threadId))
+{
+  const InputVideoStreamType * input = this->GetInput();
+  OutputVideoStreamType * output = this->GetOutput();
+
+  const InputFrameType * inputFrame =
+    input->GetFrame( input->GetRequestedTemporalRegion().GetFrameStart() );
+  OutputFrameType * outputFrame =
+    output->GetFrame( output->GetRequestedTemporalRegion().GetFrameStart() );
+
+  // The input, output and model images share the same spatial layout
+  InputFrameSpatialRegionType inputRegion;
+  inputRegion.SetIndex( outputRegionForThread.GetIndex() );
+  inputRegion.SetSize( outputRegionForThread.GetSize() );
+  typename ModelImageType::RegionType modelRegion;
+  modelRegion.SetIndex( outputRegionForThread.GetIndex() );
+  modelRegion.SetSize( outputRegionForThread.GetSize() );
+
+  typedef ImageRegionConstIterator< InputFrameType > InputIterType;
+  typedef ImageRegionIterator< OutputFrameType >     OutputIterType;
+  typedef ImageRegionIterator< ModelImageType >      ModelIterType;
+  InputIterType  inputIt( inputFrame, inputRegion );
+  OutputIterType outputIt( outputFrame, outputRegionForThread );
+  ModelIterType  meanIt( m_Mean, modelRegion );
+
+  const float minimumVariance =
+    static_cast< float >( m_MinimumStandardDeviation * m_MinimumStandardDeviation );
+
+  if( m_Initialize )
+    {
+    // The first frame is the model
+    for( ; !outputIt.IsAtEnd(); ++inputIt, ++outputIt, ++meanIt )
+      {
+      meanIt.Set( static_cast< float >( inputIt.Get() ) );
+      outputIt.Set( m_BackgroundValue );
+      }
+    if( m_UseVariance )
+      {
+      ModelIterType varianceIt( m_Variance, modelRegion );
+      for( ; !varianceIt.IsAtEnd(); ++varianceIt )
+        {
+        varianceIt.Set( minimumVariance );
+        }
+      }
+    return;
+    }
+
+  const float alpha = static_cast< float >( m_LearningRate );
+
+  if( !m_UseVariance )
+    {
+    const float threshold = static_cast< float >( m_DifferenceThreshold );
+    for( ; !outputIt.IsAtEnd(); ++inputIt, ++outputIt, ++meanIt )
+      {
+      const float difference = static_cast< float >( inputIt.Get() ) - meanIt.Get();
+      outputIt.Set( std::abs( difference ) > threshold
+                    ? m_ForegroundValue : m_BackgroundValue );
+      meanIt.Set( meanIt.Get() + alpha * difference );
+      }
+    return;
+    }
+
+  // Exponentially weighted mean and variance, updated together:
+  //   mean     += alpha * difference
+  //   variance  = ( 1 - alpha ) * ( variance + alpha * difference^2 )
+  const float deviations = static_cast< float >( m_StandardDeviationThreshold );
+  const float deviations2 = deviations * deviations;
+  ModelIterType varianceIt( m_Variance, modelRegion );
+  for( ; !outputIt.IsAtEnd(); ++inputIt, ++outputIt, ++meanIt, ++varianceIt )
+    {
+    const float difference = static_cast< float >( inputIt.Get() ) - meanIt.Get();
+    const float difference2 = difference * difference;
+    const float variance = varianceIt.Get();
+    outputIt.Set( difference2 > deviations2 * variance
+                  ? m_ForegroundValue : m_BackgroundValue );
+    meanIt.Set( meanIt.Get() + alpha * difference );
+    varianceIt.Set( std::max( ( 1.0f - alpha ) * ( variance + alpha * difference2 ),
+                              minimumVariance ) );
+    }
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+RunningAverageBackgroundVideoFilter< TInputVideoStream, TOutputVideoStream >
+::AfterThreadedGenerateData()
+{
+  m_NextFrame = this->GetInput()->GetRequestedTemporalRegion().GetFrameStart() + 1;
+  m_Initialize = false;
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+RunningAverageBackgroundVideoFilter< TInputVideoStream, TOutputVideoStream >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "LearningRate: " << m_LearningRate << std::endl;
+  os << indent << "UseVariance: " << ( m_UseVariance ? "On" : "Off" ) << std::endl;
+  os << indent << "DifferenceThreshold: " << m_DifferenceThreshold << std::endl;
+  os << indent << "StandardDeviationThreshold: " << m_StandardDeviationThreshold
+     << std::endl;
+  os << indent << "MinimumStandardDeviation: " << m_MinimumStandardDeviation
+     << std::endl;
+  os << indent << "ForegroundValue: "
+     << static_cast< typename NumericTraits< OutputPixelType >::PrintType >( m_ForegroundValue )
+     << std::endl;
+  os << indent << "BackgroundValue: "
+     << static_cast< typename NumericTraits< OutputPixelType >::PrintType >( m_BackgroundValue )
+     << std::endl;
+}
+
+} // end namespace itk
+
+#endif
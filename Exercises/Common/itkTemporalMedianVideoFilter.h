@@ -0,0 +1,139 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkTemporalMedianVideoFilter_h
+#define __itkTemporalMedianVideoFilter_h
+
+#include <vector>
+
+#include "itkVideoToVideoFilter.h"
+#include "itkNumericTraits.h"
+
+namespace itk
+{
+
+/** \class TemporalMedianVideoFilter
+ * \brief Per-pixel median of the last WindowLength frames of an 8-bit video.
+ *
+ * Every pixel keeps a 256-bin histogram of its values over the window,
+ * together with its current median and the number of values below it. When
+ * a frame enters the window its value is added to the histogram, the value
+ * of the frame leaving the window is removed, and the median moves by the
+ * few bins the two values shift it. The cost of a frame therefore does not
+ * depend on the window length, where sorting the window of every pixel
+ * costs N log N.
+ *
+ * The histograms take 258 bytes per pixel (about 535 MB at 1920x1080) and
+ * the window keeps WindowLength frames. WindowLength is at most 255 so that
+ * the counts fit in a byte. The first WindowLength - 1 output frames are the
+ * median of the frames seen so far, so every input frame has an output
+ * frame with the same number.
+ *
+ * The frames must be consecutive; the model starts again from the current
+ * frame when they are not, when the window length changes or after Reset().
+ */
+template< typename TInputVideoStream, typename TOutputVideoStream >
+class TemporalMedianVideoFilter :
+  public VideoToVideoFilter< TInputVideoStream, TOutputVideoStream >
+{
+public:
+
+  /** Standard class typedefs */
+  typedef TInputVideoStream                           InputVideoStreamType;
+  typedef TOutputVideoStream                          OutputVideoStreamType;
+  typedef TemporalMedianVideoFilter<
+    InputVideoStreamType, OutputVideoStreamType >     Self;
+  typedef VideoToVideoFilter<
+    InputVideoStreamType, OutputVideoStreamType >     Superclass;
+  typedef SmartPointer< Self >                        Pointer;
+  typedef SmartPointer< const Self >                  ConstPointer;
+
+  typedef typename TInputVideoStream::FrameType       InputFrameType;
+  typedef typename InputFrameType::PixelType          InputPixelType;
+  typedef typename InputFrameType::RegionType         InputFrameSpatialRegionType;
+  typedef typename TOutputVideoStream::FrameType      OutputFrameType;
+  typedef typename OutputFrameType::PixelType         OutputPixelType;
+  typedef typename OutputFrameType::RegionType        OutputFrameSpatialRegionType;
+
+  /** Histogram of one pixel over the window */
+  typedef unsigned char CountType;
+  struct PixelHistogram
+  {
+    CountType Counts[256];
+    CountType Median;
+    CountType Below;
+  };
+  typedef Image< PixelHistogram, InputFrameType::ImageDimension >
+                                                      HistogramImageType;
+
+  itkNewMacro(Self);
+  itkTypeMacro(TemporalMedianVideoFilter, VideoToVideoFilter);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  /** The histograms have one bin per 8-bit value */
+  itkConceptMacro(InputPixelIsUnsignedChar,
+                  (Concept::SameType< InputPixelType, unsigned char >));
+#endif
+
+  /** Number of frames in the window, from 1 to 255 */
+  itkSetClampMacro(WindowLength, unsigned int, 1, 255);
+  itkGetConstMacro(WindowLength, unsigned int);
+
+  /** Empty the window; the next frame starts a new one */
+  void Reset();
+
+protected:
+  TemporalMedianVideoFilter();
+  virtual ~TemporalMedianVideoFilter() {}
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+  /** Start a new window when needed and pick the slot of the new frame */
+  virtual void BeforeThreadedGenerateData();
+
+  /** Move the frames of the region through the histograms */
+  virtual void ThreadedGenerateData(
+    const OutputFrameSpatialRegionType & outputRegionForThread,
+    int threadId);
+
+  /** Move on to the next frame */
+  virtual void AfterThreadedGenerateData();
+
+private:
+  TemporalMedianVideoFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);            //purposely not implemented
+
+  unsigned int m_WindowLength;
+
+  typename HistogramImageType::Pointer m_Histograms;
+
+  /** Copies of the frames in the window, oldest at m_Slot once full */
+  std::vector< typename InputFrameType::Pointer > m_Window;
+  unsigned int  m_Slot;
+  unsigned int  m_NumberOfFramesInWindow;
+
+  SizeValueType m_NextFrame;
+  unsigned long m_ModelTime;
+  bool          m_Initialize;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkTemporalMedianVideoFilter.hxx"
+#endif
+
+#endif
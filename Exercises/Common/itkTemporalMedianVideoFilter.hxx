@@ -0,0 +1,205 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkTemporalMedianVideoFilter_hxx
+#define __itkTemporalMedianVideoFilter_hxx
+
+#include "itkTemporalMedianVideoFilter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+
+namespace itk
+{
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+TemporalMedianVideoFilter< TInputVideoStream, TOutputVideoStream >
+::TemporalMedianVideoFilter()
+{
+  m_WindowLength = 15;
+  m_Slot = 0;
+  m_NumberOfFramesInWindow = 0;
+  m_NextFrame = 0;
+  m_ModelTime = 0;
+  m_Initialize = true;
+
+  // One input frame per output frame: the window is kept by the filter
+  this->TemporalProcessObject::m_UnitInputNumberOfFrames = 1;
+  this->TemporalProcessObject::m_UnitOutputNumberOfFrames = 1;
+  this->TemporalProcessObject::m_FrameSkipPerOutput = 1;
+  this->TemporalProcessObject::m_InputStencilCurrentFrameIndex = 0;
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+TemporalMedianVideoFilter< TInputVideoStream, TOutputVideoStream >
+::Reset()
+{
+  m_Initialize = true;
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+TemporalMedianVideoFilter< TInputVideoStream, TOutputVideoStream >
+::BeforeThreadedGenerateData()
+{
+  const InputVideoStreamType * input = this->GetInput();
+  const SizeValueType frameNumber =
+    input->GetRequestedTemporalRegion().GetFrameStart();
+  const InputFrameSpatialRegionType & frameRegion =
+    input->GetFrame( frameNumber )->GetLargestPossibleRegion();
+
+  if( frameNumber != m_NextFrame || this->GetMTime() > m_ModelTime )
+    {
+    m_Initialize = true;
+    }
+
+  typename HistogramImageType::RegionType histogramRegion;
+  histogramRegion.SetIndex( frameRegion.GetIndex() );
+  histogramRegion.SetSize( frameRegion.GetSize() );
+  if( m_Histograms.IsNull() || m_Histograms->GetBufferedRegion() != histogramRegion )
+    {
+    m_Histograms = HistogramImageType::New();
+    m_Histograms->SetRegions( histogramRegion );
+    m_Histograms->Allocate();
+    m_Window.clear();
+    m_Initialize = true;
+    }
+
+  if( m_Initialize )
+    {
+    std::memset( m_Histograms->GetBufferPointer(), 0,
+                 histogramRegion.GetNumberOfPixels() * sizeof( PixelHistogram ) );
+    m_Window.resize( m_WindowLength );
+    m_Slot = 0;
+    m_NumberOfFramesInWindow = 0;
+    m_ModelTime = this->GetMTime();
+    }
+
+  typename InputFrameType::Pointer & slot = m_Window[m_Slot];
+  if( slot.IsNull() )
+    {
+    slot = InputFrameType::New();
+    slot->SetRegions( frameRegion );
+    slot->Allocate();
+    }
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+TemporalMedianVideoFilter< TInputVideoStream, TOutputVideoStream >
+::ThreadedGenerateData(const OutputFrameSpatialRegionType & outputRegionForThread,
+                       int itkNotUsed(threadId))
+{
+  const InputVideoStreamType * input = this->GetInput();
+  OutputVideoStreamType * output = this->GetOutput();
+
+  const InputFrameType * inputFrame =
+    input->GetFrame( input->GetRequestedTemporalRegion().GetFrameStart() );
+  OutputFrameType * outputFrame =
+    output->GetFrame( output->GetRequestedTemporalRegion().GetFrameStart() );
+  InputFrameType * slotFrame = m_Window[m_Slot];
+
+  // The frames and the histograms share the same spatial layout
+  InputFrameSpatialRegionType inputRegion;
+  inputRegion.SetIndex( outputRegionForThread.GetIndex() );
+  inputRegion.SetSize( outputRegionForThread.GetSize() );
+  typename HistogramImageType::RegionType histogramRegion;
+  histogramRegion.SetIndex( outputRegionForThread.GetIndex() );
+  histogramRegion.SetSize( outputRegionForThread.GetSize() );
+
+  typedef ImageRegionConstIterator< InputFrameType > InputIterType;
+  typedef ImageRegionIterator< InputFrameType >      SlotIterType;
+  typedef ImageRegionIterator< OutputFrameType >     OutputIterType;
+  typedef ImageRegionIterator< HistogramImageType >  HistogramIterType;
+  InputIterType     inputIt( inputFrame, inputRegion );
+  SlotIterType      slotIt( slotFrame, inputRegion );
+  OutputIterType    outputIt( outputFrame, outputRegionForThread );
+  HistogramIterType histogramIt( m_Histograms, histogramRegion );
+
+  // Once the window is full the slot holds the frame leaving it
+  const bool removeOldest = m_NumberOfFramesInWindow == m_WindowLength;
+  const unsigned int numberOfValues =
+    std::min( m_NumberOfFramesInWindow + 1, m_WindowLength );
+  // Rank of the (lower) median: the median is the smallest value with at
+  // least that many values at or below it
+  const unsigned int rank = ( numberOfValues + 1 ) / 2;
+
+  for( ; !outputIt.IsAtEnd(); ++inputIt, ++slotIt, ++outputIt, ++histogramIt )
+    {
+    PixelHistogram & histogram = histogramIt.Value();
+    const unsigned int value = inputIt.Get();
+    unsigned int median = histogram.Median;
+    unsigned int below = histogram.Below;
+
+    if( removeOldest )
+      {
+      const unsigned int oldest = slotIt.Get();
+      --histogram.Counts[oldest];
+      below -= oldest < median;
+      }
+    ++histogram.Counts[value];
+    below += value < median;
+    slotIt.Set( inputIt.Get() );
+
+    // Move the median down or up to the bin holding the rank
+    while( below >= rank )
+      {
+      --median;
+      below -= histogram.Counts[median];
+      }
+    while( below + histogram.Counts[median] < rank )
+      {
+      below += histogram.Counts[median];
+      ++median;
+      }
+
+    histogram.Median = static_cast< CountType >( median );
+    histogram.Below = static_cast< CountType >( below );
+    outputIt.Set( static_cast< OutputPixelType >( median ) );
+    }
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+TemporalMedianVideoFilter< TInputVideoStream, TOutputVideoStream >
+::AfterThreadedGenerateData()
+{
+  m_NumberOfFramesInWindow = std::min( m_NumberOfFramesInWindow + 1, m_WindowLength );
+  m_Slot = ( m_Slot + 1 ) % m_WindowLength;
+  m_NextFrame = this->GetInput()->GetRequestedTemporalRegion().GetFrameStart() + 1;
+  m_Initialize = false;
+}
+
+template< typename TInputVideoStream, typename TOutputVideoStream >
+void
+TemporalMedianVideoFilter< TInputVideoStream, TOutputVideoStream >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "WindowLength: " << m_WindowLength << std::endl;
+  os << indent << "NumberOfFramesInWindow: " << m_NumberOfFramesInWindow
+     << std::endl;
+}
+
+} // end namespace itk
+
+#endif
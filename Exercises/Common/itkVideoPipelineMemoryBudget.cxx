@@ -0,0 +1,267 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkVideoPipelineMemoryBudget.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace itk
+{
+
+VideoPipelineMemoryBudget::VideoPipelineMemoryBudget()
+{
+  m_Budget = 0;
+  m_BudgetUnit = FramesBudget;
+
+  m_StartCommand = MemberCommand< Self >::New();
+  m_StartCommand->SetCallbackFunction( this, &Self::StageStarted );
+}
+
+VideoPipelineMemoryBudget::~VideoPipelineMemoryBudget()
+{
+  // The filters may outlive the budget
+  for( size_t i = 0; i < m_Stages.size(); ++i )
+    {
+    m_Stages[i].Filter->RemoveObserver( m_Stages[i].StartObserverTag );
+    }
+}
+
+void
+VideoPipelineMemoryBudget::SetBudgetInBytes(SizeValueType bytes)
+{
+  m_Budget = bytes;
+  m_BudgetUnit = BytesBudget;
+  this->Modified();
+}
+
+void
+VideoPipelineMemoryBudget::SetBudgetInFrames(SizeValueType frames)
+{
+  m_Budget = frames;
+  m_BudgetUnit = FramesBudget;
+  this->Modified();
+}
+
+void
+VideoPipelineMemoryBudget::AddStage(const std::string & name,
+                                    TemporalProcessObject * filter,
+                                    TemporalDataObject * stream,
+                                    SizeValueType bytesPerFrame,
+                                    SizeValueType minimumNumberOfFrames)
+{
+  if( !filter || !stream )
+    {
+    itkExceptionMacro( << "Stage " << name << " needs a filter and a stream" );
+    }
+  if( bytesPerFrame == 0 )
+    {
+    itkExceptionMacro( << "Stage " << name << " needs the bytes of a frame" );
+    }
+
+  Stage stage;
+  stage.Name = name;
+  stage.Filter = filter;
+  stage.Stream = stream;
+  stage.BytesPerFrame = bytesPerFrame;
+  stage.MinimumNumberOfFrames = std::max( minimumNumberOfFrames,
+                                          static_cast< SizeValueType >( 1 ) );
+  stage.NumberOfBuffers = 0;
+  stage.NumberOfClampedRequests = 0;
+  stage.StartObserverTag = filter->AddObserver( StartEvent(), m_StartCommand );
+  m_Stages.push_back( stage );
+
+  // Every stage is sampled when this filter ends an update
+  m_Accountant.AddStage( name, [stream, bytesPerFrame]() -> SizeValueType
+    {
+    return stream->GetBufferedTemporalRegion().GetFrameDuration() * bytesPerFrame;
+    }, filter );
+  this->Modified();
+}
+
+void
+VideoPipelineMemoryBudget::ApplyBudget()
+{
+  if( m_Stages.empty() )
+    {
+    itkExceptionMacro( << "No stages have been registered" );
+    }
+
+  // Every stage must at least hold its stencil. Whatever is left of the
+  // budget is handed out as the same number of extra frames per stage so
+  // that no stage can run further ahead than the others.
+  SizeValueType required = 0;
+  SizeValueType bytesPerExtraFrame = 0;
+  for( size_t i = 0; i < m_Stages.size(); ++i )
+    {
+    if( m_BudgetUnit == BytesBudget )
+      {
+      required += m_Stages[i].MinimumNumberOfFrames * m_Stages[i].BytesPerFrame;
+      bytesPerExtraFrame += m_Stages[i].BytesPerFrame;
+      }
+    else
+      {
+      required += m_Stages[i].MinimumNumberOfFrames;
+      }
+    }
+
+  if( required > m_Budget )
+    {
+    itkExceptionMacro( << "Budget of " << m_Budget
+                       << ( m_BudgetUnit == BytesBudget ? " bytes" : " frames" )
+                       << " is smaller than the " << required
+                       << " needed by the pipeline stencils" );
+    }
+
+  SizeValueType extraFrames = 0;
+  if( m_BudgetUnit == BytesBudget )
+    {
+    if( bytesPerExtraFrame > 0 )
+      {
+      extraFrames = ( m_Budget - required ) / bytesPerExtraFrame;
+      }
+    }
+  else
+    {
+    extraFrames = ( m_Budget - required ) / m_Stages.size();
+    }
+
+  for( size_t i = 0; i < m_Stages.size(); ++i )
+    {
+    m_Stages[i].NumberOfBuffers = m_Stages[i].MinimumNumberOfFrames + extraFrames;
+    m_Stages[i].Stream->SetNumberOfBuffers( m_Stages[i].NumberOfBuffers );
+    }
+}
+
+void
+VideoPipelineMemoryBudget::ClampRequestedTemporalRegion(SizeValueType stage)
+{
+  Stage & s = m_Stages.at( stage );
+  if( s.NumberOfBuffers == 0 )
+    {
+    return;
+    }
+
+  // Cutting the request, rather than letting the stream grow its frame
+  // buffer to hold it, keeps the stage within its share of the budget
+  TemporalRegion requested = s.Stream->GetRequestedTemporalRegion();
+  if( requested.GetFrameDuration() > s.NumberOfBuffers )
+    {
+    requested.SetFrameDuration( s.NumberOfBuffers );
+    s.Stream->SetRequestedTemporalRegion( requested );
+    ++s.NumberOfClampedRequests;
+    }
+}
+
+void
+VideoPipelineMemoryBudget::StageStarted(Object * caller,
+                                        const EventObject & itkNotUsed(event))
+{
+  for( size_t i = 0; i < m_Stages.size(); ++i )
+    {
+    if( m_Stages[i].Filter.GetPointer() == caller )
+      {
+      this->ClampRequestedTemporalRegion( i );
+      }
+    }
+}
+
+void
+VideoPipelineMemoryBudget::SampleStages()
+{
+  m_Accountant.Sample();
+}
+
+SizeValueType
+VideoPipelineMemoryBudget::GetNumberOfStages() const
+{
+  return m_Stages.size();
+}
+
+SizeValueType
+VideoPipelineMemoryBudget::GetStageNumberOfBuffers(SizeValueType stage) const
+{
+  return m_Stages.at( stage ).NumberOfBuffers;
+}
+
+SizeValueType
+VideoPipelineMemoryBudget::GetStageHighWaterMarkInFrames(SizeValueType stage) const
+{
+  return this->GetStageHighWaterMarkInBytes( stage ) /
+    m_Stages.at( stage ).BytesPerFrame;
+}
+
+SizeValueType
+VideoPipelineMemoryBudget::GetStageHighWaterMarkInBytes(SizeValueType stage) const
+{
+  return m_Accountant.GetStagePeakBytes( m_Stages.at( stage ).Name );
+}
+
+SizeValueType
+VideoPipelineMemoryBudget::GetStageNumberOfClampedRequests(SizeValueType stage) const
+{
+  return m_Stages.at( stage ).NumberOfClampedRequests;
+}
+
+SizeValueType
+VideoPipelineMemoryBudget::GetHighWaterMarkInBytes() const
+{
+  return m_Accountant.GetPeakBytes();
+}
+
+void
+VideoPipelineMemoryBudget::Report(std::ostream & os) const
+{
+  os << "Stage                 Buffers  Peak frames  Peak bytes" << std::endl;
+  for( size_t i = 0; i < m_Stages.size(); ++i )
+    {
+    os << std::left << std::setw(20) << m_Stages[i].Name << std::right
+       << std::setw(10) << m_Stages[i].NumberOfBuffers
+       << std::setw(13) << this->GetStageHighWaterMarkInFrames( i )
+       << std::setw(12) << this->GetStageHighWaterMarkInBytes( i ) << std::endl;
+    if( m_Stages[i].NumberOfClampedRequests > 0 )
+      {
+      os << "  " << m_Stages[i].NumberOfClampedRequests
+         << " requests cut to the frame buffer" << std::endl;
+      }
+    }
+  os << "Total peak bytes: " << this->GetHighWaterMarkInBytes() << std::endl;
+
+  const SizeValueType rss = bridge::MemoryAccountant::GetPeakResidentSetSize();
+  os << "Process peak RSS: ";
+  if( rss > 0 )
+    {
+    os << rss << " bytes" << std::endl;
+    }
+  else
+    {
+    os << "unavailable" << std::endl;
+    }
+}
+
+void
+VideoPipelineMemoryBudget::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Budget: " << m_Budget
+     << ( m_BudgetUnit == BytesBudget ? " bytes" : " frames" ) << std::endl;
+  os << indent << "NumberOfStages: " << m_Stages.size() << std::endl;
+}
+
+} // end namespace itk
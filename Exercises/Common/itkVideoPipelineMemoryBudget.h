@@ -0,0 +1,152 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkVideoPipelineMemoryBudget_h
+#define __itkVideoPipelineMemoryBudget_h
+
+#include <string>
+#include <vector>
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkCommand.h"
+#include "itkTemporalDataObject.h"
+#include "itkTemporalProcessObject.h"
+
+#include "MemoryAccountant.h"
+
+namespace itk
+{
+
+/** \class VideoPipelineMemoryBudget
+ * \brief Share a memory budget among the stages of a video pipeline.
+ *
+ * A stage is a reader or video filter together with the VideoStream it
+ * produces. The budget, given either in bytes or in frames, is divided
+ * among the registered stages and used to size the frame buffer of each
+ * stream, never going below the number of frames the downstream filter
+ * needs for its temporal stencil.
+ *
+ * A stream only holds the frames of its frame buffer, so the requests are
+ * kept within it as well: when a stage filter starts an update, a requested
+ * temporal region longer than the frame buffer of its stream is cut to the
+ * first frames the buffer holds. The caller finds the frames produced in
+ * the requested temporal region after the update and requests the rest
+ * next, so a long request is split into pieces that fit the budget. The
+ * filters of a pipeline request their inputs one stencil at a time, which
+ * is never cut.
+ *
+ * While the pipeline runs, the frames buffered by every stream are sampled
+ * by a bridge::MemoryAccountant every time a stage filter finishes an
+ * update, so that the high-water mark of every stage, and of the pipeline
+ * as a whole, can be reported at the end of the run.
+ */
+class VideoPipelineMemoryBudget : public Object
+{
+public:
+
+  /** Standard class typedefs */
+  typedef VideoPipelineMemoryBudget  Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(VideoPipelineMemoryBudget, Object);
+
+  /** Units in which the budget is expressed */
+  typedef enum { BytesBudget, FramesBudget } BudgetUnitType;
+
+  /** Set the budget for the whole pipeline */
+  void SetBudgetInBytes(SizeValueType bytes);
+  void SetBudgetInFrames(SizeValueType frames);
+  itkGetConstMacro(Budget, SizeValueType);
+  itkGetConstMacro(BudgetUnit, BudgetUnitType);
+
+  /** Register a stage of the pipeline. bytesPerFrame is the memory held by
+   * one frame of the stream, which must not be 0, and minimumNumberOfFrames
+   * the number of frames the downstream filter requests at once
+   * (FrameOffset + 1 for a FrameDifferenceVideoFilter). */
+  void AddStage(const std::string & name,
+                TemporalProcessObject * filter,
+                TemporalDataObject * stream,
+                SizeValueType bytesPerFrame,
+                SizeValueType minimumNumberOfFrames = 1);
+
+  /** Divide the budget among the stages and resize their frame buffers.
+   * An exception is thrown if the budget cannot hold the minimum number of
+   * frames of every stage. */
+  void ApplyBudget();
+
+  /** Cut the requested temporal region of the stream of a stage to its
+   * frame buffer. This is called automatically when the stage filter
+   * starts an update, once the budget is applied. */
+  void ClampRequestedTemporalRegion(SizeValueType stage);
+
+  /** Record the frames currently buffered by every stage. This is called
+   * automatically when a stage filter finishes an update. */
+  void SampleStages();
+
+  /** Access to the per-stage results */
+  SizeValueType GetNumberOfStages() const;
+  SizeValueType GetStageNumberOfBuffers(SizeValueType stage) const;
+  SizeValueType GetStageHighWaterMarkInFrames(SizeValueType stage) const;
+  SizeValueType GetStageHighWaterMarkInBytes(SizeValueType stage) const;
+  /** Number of requests of the stage cut to its frame buffer */
+  SizeValueType GetStageNumberOfClampedRequests(SizeValueType stage) const;
+  /** Largest number of bytes buffered by all the stages at once */
+  SizeValueType GetHighWaterMarkInBytes() const;
+
+  /** Print one line per stage with its buffer size and high-water mark,
+   * then the peak of the pipeline and of the process */
+  void Report(std::ostream & os) const;
+
+protected:
+  VideoPipelineMemoryBudget();
+  virtual ~VideoPipelineMemoryBudget();
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+private:
+  VideoPipelineMemoryBudget(const Self &); //purposely not implemented
+  void operator=(const Self &);            //purposely not implemented
+
+  /** Clamp the request of the stage whose filter starts an update */
+  void StageStarted(Object * caller, const EventObject & event);
+
+  struct Stage
+    {
+    std::string                    Name;
+    TemporalProcessObject::Pointer Filter;
+    TemporalDataObject::Pointer    Stream;
+    SizeValueType                  BytesPerFrame;
+    SizeValueType                  MinimumNumberOfFrames;
+    SizeValueType                  NumberOfBuffers;
+    SizeValueType                  NumberOfClampedRequests;
+    unsigned long                  StartObserverTag;
+    };
+
+  SizeValueType              m_Budget;
+  BudgetUnitType             m_BudgetUnit;
+  std::vector< Stage >       m_Stages;
+  bridge::MemoryAccountant   m_Accountant;
+
+  MemberCommand< Self >::Pointer m_StartCommand;
+};
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,393 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkY4MVideoIO.h"
+
+#include <cctype>
+#include <cstring>
+#include <string>
+
+namespace itk
+{
+
+namespace
+{
+
+// The stream buffer of the file: large enough to read a frame in a few calls
+const std::size_t StreamBufferSize = 1 << 20;
+
+int SeekFile( std::FILE * file, std::size_t offset, int whence )
+{
+#if defined( _WIN32 )
+  return _fseeki64( file, static_cast< __int64 >( offset ), whence );
+#else
+  return fseeko( file, static_cast< off_t >( offset ), whence );
+#endif
+}
+
+} // end anonymous namespace
+
+Y4MVideoIO::Y4MVideoIO()
+{
+  m_File = 0;
+  this->ResetMembers();
+}
+
+Y4MVideoIO::~Y4MVideoIO()
+{
+  this->FinishReadingOrWriting();
+}
+
+void
+Y4MVideoIO::ResetMembers()
+{
+  m_Header = bridge::Y4MHeader();
+  m_HeaderSize = 0;
+  m_SeekIndex.Clear();
+  m_Indexed = false;
+  this->m_FramesPerSecond = 0;
+  this->m_FrameTotal = 0;
+  this->m_CurrentFrame = 0;
+  this->m_IFrameInterval = 1;
+  this->m_LastIFrame = 0;
+  this->m_Ratio = 0;
+  this->m_PositionInMSec = 0;
+  this->m_WriterOpen = false;
+  this->m_ReaderOpen = false;
+}
+
+void
+Y4MVideoIO::FinishReadingOrWriting()
+{
+  if( m_File )
+    {
+    std::fclose( m_File );
+    m_File = 0;
+    }
+  this->m_WriterOpen = false;
+  this->m_ReaderOpen = false;
+}
+
+void
+Y4MVideoIO::SetReadFromCamera()
+{
+  itkExceptionMacro( << "Y4MVideoIO cannot read from a camera" );
+}
+
+bool
+Y4MVideoIO::CanReadCamera( CameraIDType itkNotUsed(cameraID) ) const
+{
+  return false;
+}
+
+Y4MVideoIO::TemporalOffsetType
+Y4MVideoIO::GetPositionInMSec() const
+{
+  return this->m_PositionInMSec;
+}
+
+Y4MVideoIO::TemporalRatioType
+Y4MVideoIO::GetRatio() const
+{
+  return this->m_Ratio;
+}
+
+Y4MVideoIO::FrameOffsetType
+Y4MVideoIO::GetFrameTotal() const
+{
+  return this->m_FrameTotal;
+}
+
+Y4MVideoIO::TemporalRatioType
+Y4MVideoIO::GetFramesPerSecond() const
+{
+  return this->m_FramesPerSecond;
+}
+
+Y4MVideoIO::FrameOffsetType
+Y4MVideoIO::GetCurrentFrame() const
+{
+  return this->m_CurrentFrame;
+}
+
+Y4MVideoIO::FrameOffsetType
+Y4MVideoIO::GetIFrameInterval() const
+{
+  return this->m_IFrameInterval;
+}
+
+Y4MVideoIO::FrameOffsetType
+Y4MVideoIO::GetLastIFrame() const
+{
+  return this->m_LastIFrame;
+}
+
+bool
+Y4MVideoIO::SetNextFrameToRead( FrameOffsetType frameNumber )
+{
+  if( !this->m_ReaderOpen || frameNumber >= this->m_FrameTotal )
+    {
+    return false;
+    }
+
+  this->Seek( m_SeekIndex.GetOffset( frameNumber ) );
+  this->m_CurrentFrame = frameNumber;
+  this->m_PositionInMSec = this->m_FramesPerSecond > 0 ?
+    1000.0 * frameNumber / this->m_FramesPerSecond : 0;
+  this->m_Ratio = static_cast< double >( frameNumber ) / this->m_FrameTotal;
+  return true;
+}
+
+bool
+Y4MVideoIO::CanReadFile( const char * filename )
+{
+  std::FILE * file = std::fopen( filename, "rb" );
+  if( !file )
+    {
+    return false;
+    }
+
+  const std::size_t signatureLength =
+    std::strlen( bridge::Y4MHeader::Signature() );
+  char signature[16];
+  const bool isY4M =
+    std::fread( signature, 1, signatureLength, file ) == signatureLength &&
+    std::memcmp( signature, bridge::Y4MHeader::Signature(),
+                 signatureLength ) == 0;
+  std::fclose( file );
+  return isY4M;
+}
+
+void
+Y4MVideoIO::OpenReader()
+{
+  this->FinishReadingOrWriting();
+  this->ResetMembers();
+
+  m_File = std::fopen( this->GetFileName(), "rb" );
+  if( !m_File )
+    {
+    itkExceptionMacro( << "Cannot open " << this->GetFileName() );
+    }
+  m_StreamBuffer.resize( StreamBufferSize );
+  std::setvbuf( m_File, &m_StreamBuffer[0], _IOFBF, m_StreamBuffer.size() );
+
+  if( !m_Header.Read( m_File, m_HeaderSize ) )
+    {
+    this->FinishReadingOrWriting();
+    itkExceptionMacro( << this->GetFileName()
+                       << " does not have a supported y4m header" );
+    }
+
+  // The frame lines may have parameters, so the frame offsets come from the
+  // seek index of the file or, without one, from a scan of the frame lines
+  m_Indexed = m_SeekIndex.Load( this->GetFileName() ) && m_SeekIndex.HasOffsets();
+  if( !m_Indexed && !m_SeekIndex.BuildFromY4M( this->GetFileName() ) )
+    {
+    this->FinishReadingOrWriting();
+    itkExceptionMacro( << "Cannot scan the frames of " << this->GetFileName() );
+    }
+
+  this->m_FramesPerSecond = m_Header.GetFramesPerSecond();
+  this->m_FrameTotal = m_SeekIndex.GetNumberOfFrames();
+  this->m_LastIFrame =
+    this->m_FrameTotal > 0 ? this->m_FrameTotal - 1 : 0;
+  this->m_ReaderOpen = true;
+}
+
+void
+Y4MVideoIO::ReadImageInformation()
+{
+  this->OpenReader();
+
+  this->SetNumberOfDimensions( 2 );
+  this->m_Dimensions[0] = m_Header.Width;
+  this->m_Dimensions[1] = m_Header.Height;
+  this->m_Spacing[0] = 1.0;
+  this->m_Spacing[1] = 1.0;
+  this->m_Origin[0] = 0.0;
+  this->m_Origin[1] = 0.0;
+  this->SetPixelType( SCALAR );
+  this->SetComponentType( UCHAR );
+  this->SetNumberOfComponents( 1 );
+}
+
+void
+Y4MVideoIO::Read( void * buffer )
+{
+  if( !this->m_ReaderOpen )
+    {
+    this->OpenReader();
+    }
+
+  std::size_t lineSize;
+  if( !bridge::Y4MHeader::ReadFrameHeader( m_File, lineSize ) )
+    {
+    itkExceptionMacro( << "Frame " << this->m_CurrentFrame << " of "
+                       << this->GetFileName() << " is missing or corrupted" );
+    }
+
+  // The Y plane is the gray frame
+  const std::size_t lumaSize = m_Header.GetLumaSize();
+  if( std::fread( buffer, 1, lumaSize, m_File ) != lumaSize )
+    {
+    itkExceptionMacro( << "Frame " << this->m_CurrentFrame << " of "
+                       << this->GetFileName() << " is truncated" );
+    }
+  this->SkipBytes( m_Header.GetFrameDataSize() - lumaSize );
+
+  ++this->m_CurrentFrame;
+  this->m_PositionInMSec = this->m_FramesPerSecond > 0 ?
+    1000.0 * this->m_CurrentFrame / this->m_FramesPerSecond : 0;
+  this->m_Ratio = this->m_FrameTotal > 0 ?
+    static_cast< double >( this->m_CurrentFrame ) / this->m_FrameTotal : 0;
+}
+
+bool
+Y4MVideoIO::CanWriteFile( const char * filename )
+{
+  std::string extension = filename;
+  const std::string::size_type dot = extension.rfind( '.' );
+  if( dot == std::string::npos )
+    {
+    return false;
+    }
+  extension = extension.substr( dot );
+  for( size_t i = 0; i < extension.size(); ++i )
+    {
+    extension[i] = static_cast< char >( std::tolower( extension[i] ) );
+    }
+  return extension == ".y4m";
+}
+
+void
+Y4MVideoIO::WriteImageInformation()
+{
+}
+
+void
+Y4MVideoIO::SetWriterParameters( TemporalRatioType framesPerSecond,
+                                 const std::vector< SizeValueType > & dim,
+                                 const char * itkNotUsed(fourCC),
+                                 unsigned int numberOfComponents,
+                                 IOComponentType componentType )
+{
+  if( dim.size() != 2 || numberOfComponents != 1 || componentType != UCHAR )
+    {
+    itkExceptionMacro( << "Y4MVideoIO only writes 2D unsigned char frames" );
+    }
+
+  this->SetNumberOfDimensions( 2 );
+  this->m_Dimensions[0] = dim[0];
+  this->m_Dimensions[1] = dim[1];
+  this->SetPixelType( SCALAR );
+  this->SetComponentType( UCHAR );
+  this->SetNumberOfComponents( 1 );
+  this->m_FramesPerSecond = framesPerSecond;
+}
+
+void
+Y4MVideoIO::OpenWriter()
+{
+  const TemporalRatioType framesPerSecond = this->m_FramesPerSecond;
+  this->FinishReadingOrWriting();
+  this->ResetMembers();
+  this->m_FramesPerSecond = framesPerSecond;
+
+  m_Header.Width = this->m_Dimensions[0];
+  m_Header.Height = this->m_Dimensions[1];
+  m_Header.SetFramesPerSecond( framesPerSecond );
+  m_Header.SetColorspace( "mono" );
+
+  m_File = std::fopen( this->GetFileName(), "wb" );
+  if( !m_File )
+    {
+    itkExceptionMacro( << "Cannot open " << this->GetFileName()
+                       << " for writing" );
+    }
+  m_StreamBuffer.resize( StreamBufferSize );
+  std::setvbuf( m_File, &m_StreamBuffer[0], _IOFBF, m_StreamBuffer.size() );
+
+  const std::string header = m_Header.Format();
+  std::fwrite( header.data(), 1, header.size(), m_File );
+  m_HeaderSize = header.size();
+  this->m_WriterOpen = true;
+}
+
+void
+Y4MVideoIO::Write( const void * buffer )
+{
+  if( !this->m_WriterOpen )
+    {
+    this->OpenWriter();
+    }
+
+  std::fputs( bridge::Y4MHeader::FrameSignature(), m_File );
+  std::fputc( '\n', m_File );
+  const std::size_t lumaSize = m_Header.GetLumaSize();
+  if( std::fwrite( buffer, 1, lumaSize, m_File ) != lumaSize )
+    {
+    itkExceptionMacro( << "Cannot write frame " << this->m_CurrentFrame
+                       << " to " << this->GetFileName() );
+    }
+
+  ++this->m_CurrentFrame;
+  this->m_FrameTotal = this->m_CurrentFrame;
+}
+
+void
+Y4MVideoIO::Seek( std::size_t offset )
+{
+  if( SeekFile( m_File, offset, SEEK_SET ) != 0 )
+    {
+    itkExceptionMacro( << "Cannot seek in " << this->GetFileName() );
+    }
+}
+
+void
+Y4MVideoIO::SkipBytes( std::size_t numberOfBytes )
+{
+  if( numberOfBytes == 0 )
+    {
+    return;
+    }
+  if( SeekFile( m_File, numberOfBytes, SEEK_CUR ) == 0 )
+    {
+    return;
+    }
+
+  // Not seekable: read and drop
+  m_Scratch.resize( numberOfBytes );
+  if( std::fread( &m_Scratch[0], 1, numberOfBytes, m_File ) != numberOfBytes )
+    {
+    itkExceptionMacro( << "Frame " << this->m_CurrentFrame << " of "
+                       << this->GetFileName() << " is truncated" );
+    }
+}
+
+void
+Y4MVideoIO::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Header: " << m_Header.Format();
+  os << indent << "HeaderSize: " << m_HeaderSize << std::endl;
+  os << indent << "FrameDataSize: " << m_Header.GetFrameDataSize() << std::endl;
+  os << indent << "Indexed: " << ( m_Indexed ? "Yes" : "No" ) << std::endl;
+}
+
+} // end namespace itk
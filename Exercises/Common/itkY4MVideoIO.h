@@ -0,0 +1,130 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkY4MVideoIO_h
+#define __itkY4MVideoIO_h
+
+#include <cstdio>
+#include <vector>
+
+#include "itkVideoIOBase.h"
+
+#include "Y4MHeader.h"
+#include "VideoSeekIndex.h"
+
+namespace itk
+{
+
+/** \class Y4MVideoIO
+ * \brief VideoIO for uncompressed YUV4MPEG2 (y4m) files.
+ *
+ * The frames are read as 8-bit gray images: the Y plane is read straight
+ * into the frame buffer handed to Read() and the chroma planes are skipped.
+ * Written frames must be 8-bit gray and are stored with the "mono"
+ * colorspace, so that a file written by one pipeline is read back
+ * losslessly by the next one.
+ *
+ * Any frame can be reached with a single seek. The frame offsets come
+ * from the seek index of the file (see VideoSeekIndex.h) or, without one,
+ * from a scan of the frame lines when the file is opened, since a frame
+ * line may have parameters after "FRAME". A truncated last frame is not
+ * counted.
+ */
+class Y4MVideoIO : public VideoIOBase
+{
+public:
+
+  /** Standard class typedefs */
+  typedef Y4MVideoIO           Self;
+  typedef VideoIOBase          Superclass;
+  typedef SmartPointer< Self > Pointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(Y4MVideoIO, VideoIOBase);
+
+  /** Close the file */
+  virtual void FinishReadingOrWriting();
+
+  /** Cameras are not supported */
+  virtual void SetReadFromCamera();
+  virtual bool CanReadCamera( CameraIDType cameraID ) const;
+
+  /** Video properties */
+  virtual TemporalOffsetType GetPositionInMSec() const;
+  virtual TemporalRatioType GetRatio() const;
+  virtual FrameOffsetType GetFrameTotal() const;
+  virtual TemporalRatioType GetFramesPerSecond() const;
+  virtual FrameOffsetType GetCurrentFrame() const;
+  virtual FrameOffsetType GetIFrameInterval() const;
+  virtual FrameOffsetType GetLastIFrame() const;
+
+  /** Seek to a frame. Every frame is a key frame. */
+  virtual bool SetNextFrameToRead( FrameOffsetType frameNumber );
+
+  /** Recognize a y4m file by its signature */
+  virtual bool CanReadFile( const char * filename );
+
+  /** Read the stream header */
+  virtual void ReadImageInformation();
+
+  /** Read the Y plane of the next frame into buffer */
+  virtual void Read( void * buffer );
+
+  /** Files with the .y4m extension can be written */
+  virtual bool CanWriteFile( const char * filename );
+
+  /** The header is written with the first frame */
+  virtual void WriteImageInformation();
+
+  /** Write a frame */
+  virtual void Write( const void * buffer );
+
+  /** The fourCC is ignored: y4m is uncompressed */
+  virtual void SetWriterParameters( TemporalRatioType framesPerSecond,
+                                    const std::vector< SizeValueType > & dim,
+                                    const char * fourCC,
+                                    unsigned int numberOfComponents,
+                                    IOComponentType componentType );
+
+protected:
+  Y4MVideoIO();
+  ~Y4MVideoIO();
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+  Y4MVideoIO( const Self & ); //purposely not implemented
+  void operator=( const Self & ); //purposely not implemented
+
+  void OpenReader();
+  void OpenWriter();
+  void ResetMembers();
+  void Seek( std::size_t offset );
+  void SkipBytes( std::size_t numberOfBytes );
+
+  std::FILE *            m_File;
+  bridge::Y4MHeader      m_Header;
+  std::size_t            m_HeaderSize;
+  std::vector< char >    m_StreamBuffer;
+  std::vector< char >    m_Scratch;
+  bridge::VideoSeekIndex m_SeekIndex;
+  bool                   m_Indexed;
+};
+
+} // end namespace itk
+
+#endif
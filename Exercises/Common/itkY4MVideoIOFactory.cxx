@@ -0,0 +1,46 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkY4MVideoIOFactory.h"
+#include "itkY4MVideoIO.h"
+#include "itkVersion.h"
+
+namespace itk
+{
+
+Y4MVideoIOFactory::Y4MVideoIOFactory()
+{
+  this->RegisterOverride( "itkVideoIOBase",
+                          "itkY4MVideoIO",
+                          "Y4M Video IO",
+                          1,
+                          CreateObjectFunction< Y4MVideoIO >::New() );
+}
+
+const char *
+Y4MVideoIOFactory::GetITKSourceVersion() const
+{
+  return ITK_SOURCE_VERSION;
+}
+
+const char *
+Y4MVideoIOFactory::GetDescription() const
+{
+  return "Y4M VideoIO Factory, allows the loading of uncompressed YUV4MPEG2 videos into ITK";
+}
+
+} // end namespace itk
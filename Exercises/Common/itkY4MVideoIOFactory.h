@@ -0,0 +1,69 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkY4MVideoIOFactory_h
+#define __itkY4MVideoIOFactory_h
+
+#include "itkObjectFactoryBase.h"
+#include "itkVideoIOBase.h"
+
+namespace itk
+{
+
+/** \class Y4MVideoIOFactory
+ * \brief Create instances of Y4MVideoIO objects using an object factory.
+ *
+ * Register it before OpenCVVideoIOFactory: OpenCV can also decode y4m
+ * files, and the first registered VideoIO able to read a file is used.
+ */
+class Y4MVideoIOFactory : public ObjectFactoryBase
+{
+public:
+
+  /** Standard class typedefs */
+  typedef Y4MVideoIOFactory          Self;
+  typedef ObjectFactoryBase          Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Class methods used to interface with the registered factories */
+  virtual const char * GetITKSourceVersion() const;
+  virtual const char * GetDescription() const;
+
+  /** Method for class instantiation */
+  itkFactorylessNewMacro(Self);
+  itkTypeMacro(Y4MVideoIOFactory, ObjectFactoryBase);
+
+  /** Register one factory of this type */
+  static void RegisterOneFactory()
+  {
+    Y4MVideoIOFactory::Pointer factory = Y4MVideoIOFactory::New();
+    ObjectFactoryBase::RegisterFactoryInternal( factory );
+  }
+
+protected:
+  Y4MVideoIOFactory();
+  ~Y4MVideoIOFactory() {}
+
+private:
+  Y4MVideoIOFactory( const Self & ); //purposely not implemented
+  void operator=( const Self & ); //purposely not implemented
+};
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,90 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <itkImageFileReader.h>
+#include <itkImageFileWriter.h>
+#include <itkMeanImageFilter.h>
+
+#include "TiledExecution.h"
+
+// BasicImageFilteringITKAnswer1 run in cache-sized tiles (see
+// TiledExecution.h). The mean filter only needs a halo of its radius, so
+// the output is the same as the one of the answer. The cache budget is
+// BRIDGE_TILE_BYTES, or the L2 cache size when it is not set.
+
+int main( int argc, char * argv [] )
+{
+  if( argc < 5 )
+    {
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << argv[0] << "  inputImageFile   outputImageFile  radiusX  radiusY" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef  unsigned char  InputPixelType;
+  typedef  unsigned char  OutputPixelType;
+
+  const unsigned int Dimension = 2;
+
+  typedef itk::Image< InputPixelType,  Dimension >   InputImageType;
+  typedef itk::Image< OutputPixelType, Dimension >   OutputImageType;
+
+  typedef itk::ImageFileReader< InputImageType  >  ReaderType;
+  typedef itk::ImageFileWriter< OutputImageType >  WriterType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  WriterType::Pointer writer = WriterType::New();
+
+  reader->SetFileName( argv[1] );
+  writer->SetFileName( argv[2] );
+
+  typedef itk::MeanImageFilter< InputImageType, OutputImageType > FilterType;
+
+  FilterType::Pointer filter = FilterType::New();
+
+  InputImageType::SizeType indexRadius;
+
+  indexRadius[0] = atoi( argv[3] ); // radius along x
+  indexRadius[1] = atoi( argv[4] ); // radius along y
+
+  filter->SetRadius( indexRadius );
+
+  filter->SetInput( reader->GetOutput() );
+
+  typedef bridge::TiledExecution< OutputImageType > TiledExecutionType;
+  TiledExecutionType tiled;
+  tiled.AddStage( "mean (8-bit)", filter.GetPointer() );
+  tiled.SetInput( filter->GetOutput() );
+  writer->SetInput( tiled.GetOutput() );
+
+  try
+    {
+    tiled.Update();
+    writer->Update();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  tiled.Report( std::cout );
+
+  return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,105 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <iostream>
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <itkImage.h>
+#include <itkOpenCVImageBridge.h>
+
+#include "itkReducedPrecisionCurvatureFlowImageFilter.h"
+#include "CurvatureFlowSettings.h"
+
+// BasicFilteringITKOpenCVBridgeAnswer with the CurvatureFlow options of the
+// video pipelines: the iterations stop once the updates fall below
+// BRIDGE_CURVATURE_TOLERANCE (see CurvatureFlowSettings.h), and the
+// OutputPixelType typedef may select a Q8.8 fixed point result.
+
+int main ( int argc, char **argv )
+{
+  if( argc < 2 )
+  {
+    std::cout << "Usage: "<< argv[0] <<" input_image output_image"<<std::endl;
+    return -1;
+  }
+
+  cv::Mat inputImage = cv::imread( argv[1] );
+
+  typedef unsigned char                            InputPixelType;
+  // float, or unsigned short for a Q8.8 fixed point result at half the
+  // memory traffic (see itkIntermediatePixelTraits.h)
+  typedef float                                    OutputPixelType;
+  const unsigned int Dimension =                   2;
+  typedef itk::Image< InputPixelType, Dimension >  InputImageType;
+  typedef itk::Image< OutputPixelType, Dimension > OutputImageType;
+  typedef itk::OpenCVImageBridge                   BridgeType;
+  typedef itk::ReducedPrecisionCurvatureFlowImageFilter< InputImageType,
+                                                   OutputImageType >
+                                                   FilterType;
+  typedef itk::IntermediatePixelTraits< OutputPixelType > OutputTraitsType;
+
+  InputImageType::Pointer itkImage =
+    BridgeType::CVMatToITKImage< InputImageType >( inputImage );
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetTimeStep( 0.5 );
+  // At most 20 iterations, fewer with BRIDGE_CURVATURE_TOLERANCE set
+  bridge::CurvatureFlowSettings::FromEnvironment( 20 ).ApplyTo(
+    filter.GetPointer() );
+  bridge::IterationReport< FilterType > iterations( filter );
+
+  filter->SetInput( itkImage );
+  try
+    {
+    filter->Update();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+  iterations.Report( std::cout );
+
+  cv::Mat resultImage =
+    BridgeType::ITKImageToCVMat< OutputImageType >( filter->GetOutput() );
+
+  // Fixed point results are turned back into gray levels
+  if( OutputTraitsType::IsFixedPoint )
+  {
+    resultImage.convertTo( resultImage, CV_8U,
+                           1.0 / OutputTraitsType::GetScale() );
+  }
+
+  if(argc < 3)
+  {
+    std::string windowName = "Exercise 1: Basic Filtering in OpenCV & ITK";
+    cv::namedWindow( windowName, CV_WINDOW_FREERATIO);
+    cvResizeWindow( windowName.c_str(), resultImage.cols, resultImage.rows+50 );
+    cv::Mat scaled;
+    resultImage.convertTo(scaled, CV_8UC1 );
+    cv::imshow( windowName, scaled );
+    cv::waitKey();
+  }
+  else
+  {
+    cv::imwrite( argv[2], resultImage );
+  }
+
+  return 0;
+}
@@ -0,0 +1,259 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <cstdlib>
+#include <iostream>
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <itkImage.h>
+#include <itkCastImageFilter.h>
+#include <itkCannyEdgeDetectionImageFilter.h>
+#include <itkRescaleIntensityImageFilter.h>
+#include <itkOpenCVImageBridge.h>
+#include <itkMultiThreader.h>
+
+#include "MemoryAccountant.h"
+#include "FrameLatencyMetrics.h"
+#include "ThreadBudget.h"
+
+// BasicVideoFilteringITKOpenCVBridgeAnswer with opt-in instrumentation. The
+// frames go through the same processFrame() as in the answer, which the
+// slides quote, and through nothing else:
+//   BRIDGE_MEMORY_REPORT=1   bytes of every copy made for a frame, reported
+//                            at the end of the run (see MemoryAccountant.h)
+//   BRIDGE_METRICS_FILE      latency of the capture, processing and output
+//                            of every frame, exported while the video plays
+//                            (see FrameLatencyMetrics.h); SIGUSR1 prints it
+//   BRIDGE_THREADS, ...      threads of the ITK and OpenCV pools and
+//                            pinning (see ThreadBudget.h); the frames are
+//                            processed one at a time, with the whole budget
+
+typedef bridge::FrameLatencyMetrics MetricsType;
+
+// The instrumentation requested, NULL when not
+struct Instrumentation
+{
+  bridge::MemoryAccountant* Memory;
+  MetricsType*              Metrics;
+};
+
+// Run a step of a frame, recording its latency when metrics are requested
+template< typename TStep >
+auto timeStep( MetricsType* metrics, MetricsType::Stage stage, TStep step )
+  -> decltype( step() )
+{
+  if( !metrics )
+  {
+    return step();
+  }
+  bridge::ScopedLatency latency( metrics->GetHistogram( stage ) );
+  return step();
+}
+
+// Bytes held by the pixels of an OpenCV image
+itk::SizeValueType matBytes( const cv::Mat& image )
+{
+  return static_cast< itk::SizeValueType >( image.total() * image.elemSize() );
+}
+
+// Process a single frame of video and return the resulting frame. With an
+// accountant, the bytes of every copy made for the frame are recorded.
+cv::Mat processFrame( const cv::Mat& inputImage,
+                      bridge::MemoryAccountant* accountant = NULL )
+{
+  typedef   unsigned char                          InputPixelType;
+  typedef   float                                  RealPixelType;
+  typedef   unsigned char                          OutputPixelType;
+  typedef itk::Image< InputPixelType,  2 >         InputImageType;
+  typedef itk::Image< RealPixelType,   2 >         RealImageType;
+  typedef itk::Image< OutputPixelType, 2 >         OutputImageType;
+  typedef itk::OpenCVImageBridge                   BridgeType;
+  typedef itk::CastImageFilter< InputImageType, RealImageType >
+                                                   CastFilterType;
+  typedef itk::CannyEdgeDetectionImageFilter< RealImageType, RealImageType >
+                                                   FilterType;
+  typedef itk::RescaleIntensityImageFilter< RealImageType, OutputImageType >
+                                                   RescaleFilterType;
+
+  CastFilterType::Pointer caster = CastFilterType::New();
+  FilterType::Pointer canny = FilterType::New();
+  RescaleFilterType::Pointer rescaler = RescaleFilterType::New();
+
+  InputImageType::Pointer itkFrame =
+    itk::OpenCVImageBridge::CVMatToITKImage< InputImageType >( inputImage );
+  caster->SetInput( itkFrame );
+  canny->SetInput( caster->GetOutput() );
+  rescaler->SetInput( canny->GetOutput() );
+
+  canny->SetVariance( 6 );
+  canny->SetLowerThreshold( 1 );
+  canny->SetUpperThreshold( 8 );
+
+  try
+    {
+    rescaler->Update();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    }
+
+  cv::Mat frameOut =
+    BridgeType::ITKImageToCVMat< OutputImageType >(rescaler->GetOutput(),true);
+
+  frameOut.convertTo( frameOut, CV_8U );
+
+  if( accountant )
+  {
+    typedef bridge::MemoryAccountant AccountantType;
+    accountant->Record( "captured frame", matBytes( inputImage ) );
+    accountant->Record( "OpenCV to ITK copy",
+      AccountantType::ImageBytes( itkFrame.GetPointer() )() );
+    accountant->Record( "cast (float)",
+      AccountantType::ImageBytes( caster->GetOutput() )() );
+    accountant->Record( "canny (float)",
+      AccountantType::ImageBytes( canny->GetOutput() )() );
+    accountant->Record( "rescale (8-bit)",
+      AccountantType::ImageBytes( rescaler->GetOutput() )() );
+    accountant->Record( "ITK to OpenCV copy", matBytes( frameOut ) );
+  }
+
+  return frameOut;
+}
+
+// Iterate through a video, process each frame, and display the result in a GUI.
+void processAndDisplayVideo(cv::VideoCapture& vidCap,
+                            const Instrumentation& instrumentation)
+{
+  double frameRate = vidCap.get( CV_CAP_PROP_FPS );
+  int width = vidCap.get( CV_CAP_PROP_FRAME_WIDTH );
+  int height = vidCap.get( CV_CAP_PROP_FRAME_HEIGHT );
+
+  std::string windowName = "Exercise 2: Basic Video Filtering in OpenCV";
+  cv::namedWindow( windowName, CV_WINDOW_FREERATIO);
+  cvResizeWindow( windowName.c_str(), width, height+50 );
+
+  unsigned delay = 1000 / frameRate;
+
+  MetricsType* metrics = instrumentation.Metrics;
+  cv::Mat frame;
+  while( timeStep( metrics, MetricsType::Capture,
+                   [&]() { return vidCap.read(frame); } ) )
+  {
+    cv::Mat outputFrame = timeStep( metrics, MetricsType::Process,
+      [&]() { return processFrame( frame, instrumentation.Memory ); } );
+    timeStep( metrics, MetricsType::Output,
+              [&]() { cv::imshow( windowName, outputFrame ); } );
+
+    if( cv::waitKey(delay) >= 0 )
+    {
+      break;
+    }
+  }
+}
+
+// Iterate through a video, process each frame, and save the processed video.
+void processAndSaveVideo(cv::VideoCapture& vidCap, const std::string& filename,
+                         const Instrumentation& instrumentation)
+{
+  double frameRate = vidCap.get( CV_CAP_PROP_FPS );
+  int width = vidCap.get( CV_CAP_PROP_FRAME_WIDTH );
+  int height = vidCap.get( CV_CAP_PROP_FRAME_HEIGHT );
+
+  int fourcc = CV_FOURCC('D','I','V','X');
+
+  cv::VideoWriter writer( filename, fourcc, frameRate,
+                          cv::Size(width, height) );
+
+  MetricsType* metrics = instrumentation.Metrics;
+  cv::Mat frame;
+  while( timeStep( metrics, MetricsType::Capture,
+                   [&]() { return vidCap.read(frame); } ) )
+  {
+    cv::Mat outputFrame = timeStep( metrics, MetricsType::Process,
+      [&]() { return processFrame( frame, instrumentation.Memory ); } );
+    timeStep( metrics, MetricsType::Output,
+              [&]() { writer << outputFrame; } );
+  }
+}
+
+int main ( int argc, char **argv )
+{
+  if( argc < 2 )
+  {
+    std::cout << "Usage: "<< argv[0] <<" input_image output_image"<<std::endl;
+    return -1;
+  }
+
+  cv::VideoCapture vidCap( argv[1] );
+  if( !vidCap.isOpened() )
+  {
+    std::cerr << "Unable to open video file: "<< argv[1] << std::endl;
+    return -1;
+  }
+
+  // A single stage: processFrame() runs the filters of one frame at a time
+  bridge::ThreadBudget budget;
+  budget.Distribute( 1 );
+  budget.Apply();
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( budget.GetITKThreads( 0 ) );
+  budget.PinCurrentThread();
+
+  Instrumentation instrumentation = { NULL, NULL };
+
+  // With BRIDGE_MEMORY_REPORT=1, report the memory of the bridge copies
+  bridge::MemoryAccountant accountant;
+  if( bridge::MemoryAccountant::IsRequested() )
+  {
+    instrumentation.Memory = &accountant;
+  }
+
+  // With BRIDGE_METRICS_FILE set, export the frame latencies
+  MetricsType metrics( argv[0] );
+  if( std::getenv( "BRIDGE_METRICS_FILE" ) )
+  {
+    instrumentation.Metrics = &metrics;
+    metrics.Start();
+  }
+
+  if(argc < 3)
+  {
+    processAndDisplayVideo( vidCap, instrumentation );
+  }
+  else
+  {
+    processAndSaveVideo( vidCap, argv[2], instrumentation );
+  }
+
+  if( instrumentation.Memory )
+  {
+    accountant.Report( std::cout );
+  }
+  if( instrumentation.Metrics )
+  {
+    metrics.Stop();
+    metrics.Report( std::cout );
+  }
+  if( instrumentation.Memory || instrumentation.Metrics )
+  {
+    budget.Report( std::cout );
+  }
+
+  return 0;
+}
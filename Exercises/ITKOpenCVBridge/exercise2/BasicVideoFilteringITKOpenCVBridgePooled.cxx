@@ -0,0 +1,143 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <iostream>
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include "CannyFrameProcessor.h"
+#include "FrameLatencyMetrics.h"
+
+typedef bridge::CannyFrameProcessor ProcessorType;
+typedef bridge::FrameLatencyMetrics MetricsType;
+
+// Read, process and write a frame, recording the latency of each step
+template< typename TWrite >
+bool processFrame(cv::VideoCapture& vidCap, ProcessorType& processor,
+                  MetricsType& metrics, cv::Mat& frame, cv::Mat& outputFrame,
+                  TWrite write)
+{
+  {
+    bridge::ScopedLatency latency( metrics.GetHistogram( MetricsType::Capture ) );
+    if( !vidCap.read(frame) )
+    {
+      return false;
+    }
+  }
+  {
+    bridge::ScopedLatency latency( metrics.GetHistogram( MetricsType::Process ) );
+    processor.Process( frame, outputFrame );
+  }
+  bridge::ScopedLatency latency( metrics.GetHistogram( MetricsType::Output ) );
+  write( outputFrame );
+  return true;
+}
+
+// Iterate through a video, process each frame, and display the result in a GUI.
+void processAndDisplayVideo(cv::VideoCapture& vidCap, ProcessorType& processor,
+                            MetricsType& metrics)
+{
+  double frameRate = vidCap.get( CV_CAP_PROP_FPS );
+  int width = vidCap.get( CV_CAP_PROP_FRAME_WIDTH );
+  int height = vidCap.get( CV_CAP_PROP_FRAME_HEIGHT );
+
+  std::string windowName = "Exercise 2: Basic Video Filtering in OpenCV";
+  cv::namedWindow( windowName, CV_WINDOW_FREERATIO);
+  cvResizeWindow( windowName.c_str(), width, height+50 );
+
+  unsigned delay = 1000 / frameRate;
+
+  cv::Mat frame;
+  cv::Mat outputFrame;
+  while( processFrame( vidCap, processor, metrics, frame, outputFrame,
+                       [&]( const cv::Mat& f ) { cv::imshow( windowName, f ); } ) )
+  {
+    if( cv::waitKey(delay) >= 0 )
+    {
+      break;
+    }
+  }
+}
+
+// Iterate through a video, process each frame, and save the processed video.
+void processAndSaveVideo(cv::VideoCapture& vidCap, const std::string& filename,
+                         ProcessorType& processor, MetricsType& metrics)
+{
+  double frameRate = vidCap.get( CV_CAP_PROP_FPS );
+  int width = vidCap.get( CV_CAP_PROP_FRAME_WIDTH );
+  int height = vidCap.get( CV_CAP_PROP_FRAME_HEIGHT );
+
+  int fourcc = CV_FOURCC('D','I','V','X');
+  
+  cv::VideoWriter writer( filename, fourcc, frameRate,
+                          cv::Size(width, height) );
+
+  // Both Mats keep their buffers from one frame to the next
+  cv::Mat frame;
+  cv::Mat outputFrame;
+  while( processFrame( vidCap, processor, metrics, frame, outputFrame,
+                       [&]( const cv::Mat& f ) { writer << f; } ) )
+  {
+  }
+}
+
+int main ( int argc, char **argv )
+{
+  if( argc < 2 )
+  {
+    std::cout << "Usage: "<< argv[0] <<" input_image output_image"<<std::endl;
+    return -1;
+  }
+
+  cv::VideoCapture vidCap( argv[1] );
+  if( !vidCap.isOpened() )
+  {
+    std::cerr << "Unable to open video file: "<< argv[1] << std::endl;
+    return -1;
+  }
+
+  // The latencies are exported while the video plays (see
+  // bridge::FrameLatencyMetrics); SIGUSR1 prints them
+  MetricsType metrics( argv[0] );
+  metrics.Start();
+
+  ProcessorType processor;
+  try
+  {
+    if(argc < 3)
+    {
+      processAndDisplayVideo( vidCap, processor, metrics );
+    }
+    else
+    {
+      processAndSaveVideo( vidCap, argv[2], processor, metrics );
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return -1;
+  }
+
+  metrics.Stop();
+  std::cout << "Input frame pool: ";
+  processor.GetFramePool()->Report( std::cout );
+  metrics.Report( std::cout );
+
+  return 0;
+}
@@ -0,0 +1,139 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+#include <itkMultiThreader.h>
+
+#include "CannyFrameProcessor.h"
+#include "FrameLatencyMetrics.h"
+#include "FrameStreamIO.h"
+#include "ThreadBudget.h"
+
+// Streaming version of the bridge video exercise. "-" as input or output
+// reads or writes uncompressed y4m frames on the standard input or output,
+// so that the video executables can be chained in a Unix pipe. Frames
+// travel as gray levels and only frames are written to the standard output.
+// The thread budget (see ThreadBudget.h) is shared by the capture thread and
+// the processing loop. BRIDGE_START_FRAME and BRIDGE_NUMBER_OF_FRAMES select
+// a clip of the input (see bridge::FrameClip).
+//
+// The capture, processing and output latencies are kept in histograms and
+// exported while the executable runs (see bridge::FrameLatencyMetrics);
+// SIGUSR1 prints them. With BRIDGE_LIVE_CAPTURE=1 the input is treated as
+// a live source: the frames read while the processing is behind are
+// dropped and counted instead of holding up the capture.
+int main ( int argc, char **argv )
+{
+  if( argc < 3 )
+  {
+    std::cout << "Usage: "<< argv[0] <<" input_video output_video"<<std::endl;
+    std::cout << "Use - for the standard input or output (y4m frames)."
+              << std::endl;
+    return -1;
+  }
+
+  bridge::FrameSource source;
+  if( !bridge::OpenFrameSource( argv[1], source,
+                                bridge::FrameClip::FromEnvironment() ) )
+  {
+    std::cerr << "Unable to open video file: "<< argv[1] << std::endl;
+    return -1;
+  }
+
+  bridge::FrameSink sink;
+  if( !bridge::OpenFrameSink( argv[2], source.FramesPerSecond,
+                              source.FrameSize, sink ) )
+  {
+    std::cerr << "Unable to open output file: "<< argv[2] << std::endl;
+    return -1;
+  }
+
+  // The capture thread and the processing loop run at the same time. The
+  // processing loop, the first stage, also gets the thread left over by an
+  // odd budget.
+  bridge::ThreadBudget budget;
+  budget.Distribute( 2 );
+  budget.Apply();
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( budget.GetITKThreads( 0 ) );
+  budget.PinCurrentThread();
+
+  // Frames are read on their own thread while the previous one is processed.
+  // The metrics read the dropped frames of the capture, so they are declared
+  // after it and stop before it is destroyed.
+  bridge::ThreadedFrameCapture capture( 4 );
+  const char * live = std::getenv( "BRIDGE_LIVE_CAPTURE" );
+  capture.SetDropWhenFull( live && std::strcmp( live, "1" ) == 0 );
+
+  typedef bridge::FrameLatencyMetrics MetricsType;
+  MetricsType metrics( argv[0] );
+  metrics.SetDroppedFramesFunction( [&capture]()
+    { return capture.GetNumberOfDroppedFrames(); } );
+  metrics.Start();
+
+  bridge::LatencyHistogram & captureLatency =
+    metrics.GetHistogram( MetricsType::Capture );
+  capture.Start( [&captureLatency, &source]( cv::Mat & frame )
+    {
+    bridge::ScopedLatency latency( captureLatency );
+    return source.Read( frame );
+    },
+    [&budget]() { budget.PinCurrentThread(); } );
+
+  bridge::CannyFrameProcessor processor;
+  try
+  {
+    cv::Mat frame;
+    cv::Mat outputFrame;
+    while( capture.Pop( frame ) )
+    {
+      {
+        bridge::ScopedLatency latency( metrics.GetHistogram( MetricsType::Process ) );
+        processor.Process( frame, outputFrame );
+      }
+      bridge::ScopedLatency latency( metrics.GetHistogram( MetricsType::Output ) );
+      if( !sink.Write( outputFrame ) )
+      {
+        std::cerr << "Unable to write to: "<< argv[2] << std::endl;
+        capture.Stop();
+        return -1;
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    capture.Stop();
+    return -1;
+  }
+  catch( std::exception & excp )
+  {
+    std::cerr << excp.what() << std::endl;
+    capture.Stop();
+    return -1;
+  }
+  capture.Stop();
+  sink.Close();
+  metrics.Stop();
+  budget.Report( std::cerr );
+  metrics.Report( std::cerr );
+
+  return 0;
+}
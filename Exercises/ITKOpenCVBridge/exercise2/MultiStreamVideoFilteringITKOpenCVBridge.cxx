@@ -0,0 +1,479 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <itkMultiThreader.h>
+
+#include "CannyFrameProcessor.h"
+#include "CurvatureFlowFrameProcessor.h"
+#include "ThreadBudget.h"
+#include "WorkStealingPool.h"
+
+// Run a list of video jobs through the same bridged pipeline, with the frames
+// of every stream scheduled on one shared work-stealing pool.
+//
+// Each stream has at most "frames_in_flight" frames decoded and not yet
+// written. This keeps any one stream from filling the pool with its frames,
+// so all the streams progress together. Decoding a stream is serialized
+// (cv::VideoCapture is not thread safe), filtering is not, and the filtered
+// frames are reordered before they are written.
+//
+// The pool workers share the thread budget of ThreadBudget.h with the ITK
+// and OpenCV pools: with as many workers as threads in the budget ("auto"),
+// ITK and OpenCV run single-threaded and the number of busy threads is the
+// number of workers.
+
+typedef std::chrono::steady_clock ClockType;
+
+// More workers than this is a typo, not a machine
+const unsigned long MaximumNumberOfWorkers = 256;
+
+struct Stream
+{
+  std::string                            InputFile;
+  std::string                            OutputFile;
+  cv::VideoCapture                       Capture;
+  cv::VideoWriter                        Writer;
+  double                                 FrameRate;
+  cv::Size                               FrameSize;
+
+  // Only touched by the decode task, at most one of which exists per stream
+  int                                    NextFrameToRead;
+
+  // Everything below is protected by Mutex
+  std::mutex                             Mutex;
+  bool                                   EndOfStream;
+  unsigned int                           FramesInFlight;
+  bool                                   DecodeParked;
+  bool                                   Failed;
+  bool                                   Finished;
+  std::string                            Error;
+  int                                    NextFrameToWrite;
+  std::map< int, cv::Mat >               ReorderBuffer;
+  std::map< int, ClockType::time_point > DecodeTimes;
+  std::vector< double >                  LatenciesInMs;
+  ClockType::time_point                  StartTime;
+  ClockType::time_point                  EndTime;
+};
+
+// Read the job list: one "input output" pair per line, '#' starts a comment
+bool readJobs( const std::string& filename,
+               std::vector< std::unique_ptr< Stream > >& streams )
+{
+  std::ifstream jobFile( filename.c_str() );
+  if( !jobFile )
+  {
+    std::cerr << "Unable to open job list: " << filename << std::endl;
+    return false;
+  }
+
+  std::string line;
+  while( std::getline( jobFile, line ) )
+  {
+    line = line.substr( 0, line.find( '#' ) );
+    std::istringstream fields( line );
+    std::string input;
+    std::string output;
+    if( !( fields >> input ) )
+    {
+      continue;
+    }
+    if( !( fields >> output ) )
+    {
+      std::cerr << "Missing output file for job: " << input << std::endl;
+      return false;
+    }
+
+    std::unique_ptr< Stream > stream( new Stream );
+    stream->InputFile = input;
+    stream->OutputFile = output;
+    stream->NextFrameToRead = 0;
+    stream->EndOfStream = false;
+    stream->FramesInFlight = 0;
+    stream->DecodeParked = false;
+    stream->Failed = false;
+    stream->Finished = false;
+    stream->NextFrameToWrite = 0;
+    streams.push_back( std::move( stream ) );
+  }
+  return true;
+}
+
+bool openStream( Stream& stream )
+{
+  if( !stream.Capture.open( stream.InputFile ) )
+  {
+    std::cerr << "Unable to open video file: " << stream.InputFile << std::endl;
+    return false;
+  }
+  stream.FrameRate = stream.Capture.get( CV_CAP_PROP_FPS );
+  stream.FrameSize = cv::Size(
+    static_cast< int >( stream.Capture.get( CV_CAP_PROP_FRAME_WIDTH ) ),
+    static_cast< int >( stream.Capture.get( CV_CAP_PROP_FRAME_HEIGHT ) ) );
+
+  int fourcc = CV_FOURCC('D','I','V','X');
+  if( !stream.Writer.open( stream.OutputFile, fourcc, stream.FrameRate,
+                           stream.FrameSize, false ) )
+  {
+    std::cerr << "Unable to open output file: " << stream.OutputFile
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+template< typename TProcessor >
+class MultiStreamRunner
+{
+public:
+  MultiStreamRunner( std::vector< std::unique_ptr< Stream > >& streams,
+                     unsigned int numberOfWorkers,
+                     unsigned int framesInFlight,
+                     bridge::ThreadBudget& budget ) :
+    m_Streams( streams ),
+    m_Pool( numberOfWorkers,
+            [&budget]( unsigned int ) { budget.PinCurrentThread(); } ),
+    m_FramesInFlight( std::max( framesInFlight, 1u ) )
+  {
+    // One processor per worker: the filters keep state between frames
+    for( unsigned int i = 0; i < m_Pool.GetNumberOfWorkers(); ++i )
+    {
+      m_Processors.push_back(
+        std::unique_ptr< TProcessor >( new TProcessor ) );
+    }
+  }
+
+  void Run()
+  {
+    for( size_t s = 0; s < m_Streams.size(); ++s )
+    {
+      Stream* stream = m_Streams[s].get();
+      stream->StartTime = ClockType::now();
+      m_Pool.Submit( [this, stream] { this->Decode( *stream ); } );
+    }
+    m_Pool.Wait();
+  }
+
+  TProcessor& GetProcessor( unsigned int worker )
+  {
+    return *m_Processors[worker];
+  }
+
+  unsigned int GetNumberOfWorkers() const
+  {
+    return m_Pool.GetNumberOfWorkers();
+  }
+
+private:
+  // Decode the next frame of a stream and queue its processing. The task
+  // resubmits itself until the stream has its share of frames in flight.
+  void Decode( Stream& stream )
+  {
+    ClockType::time_point decodeTime = ClockType::now();
+    cv::Mat frame;
+    const bool frameRead = stream.Capture.read( frame );
+
+    {
+    std::lock_guard< std::mutex > lock( stream.Mutex );
+    if( !frameRead )
+    {
+      stream.EndOfStream = true;
+    }
+    if( stream.EndOfStream || stream.Failed )
+    {
+      this->FinishIfDone( stream );
+      return;
+    }
+    stream.DecodeTimes[stream.NextFrameToRead] = decodeTime;
+    ++stream.FramesInFlight;
+    }
+
+    // The frame is processed by whichever worker gets to it first
+    const int frameIndex = stream.NextFrameToRead++;
+    m_Pool.Submit( [this, &stream, frameIndex, frame] {
+      this->Process( stream, frameIndex, frame ); } );
+
+    std::lock_guard< std::mutex > lock( stream.Mutex );
+    if( stream.FramesInFlight < m_FramesInFlight )
+    {
+      m_Pool.Submit( [this, &stream] { this->Decode( stream ); } );
+    }
+    else
+    {
+      stream.DecodeParked = true;
+    }
+  }
+
+  void Process( Stream& stream, int frameIndex, const cv::Mat& frame )
+  {
+    const int worker = bridge::WorkStealingPool::GetCurrentWorkerIndex();
+
+    cv::Mat result;
+    std::string error;
+    try
+    {
+      m_Processors[worker]->Process( frame, result );
+    }
+    catch( itk::ExceptionObject& excp )
+    {
+      error = excp.what();
+    }
+    catch( std::exception& excp )
+    {
+      error = excp.what();
+    }
+
+    std::lock_guard< std::mutex > lock( stream.Mutex );
+    --stream.FramesInFlight;
+    if( !error.empty() && !stream.Failed )
+    {
+      stream.Failed = true;
+      stream.Error = error;
+    }
+    if( stream.Failed )
+    {
+      this->FinishIfDone( stream );
+      return;
+    }
+
+    // Write the frames that are now in order
+    stream.ReorderBuffer[frameIndex] = result;
+    std::map< int, cv::Mat >::iterator next =
+      stream.ReorderBuffer.find( stream.NextFrameToWrite );
+    while( next != stream.ReorderBuffer.end() )
+    {
+      stream.Writer << next->second;
+      std::chrono::duration< double, std::milli > latency =
+        ClockType::now() - stream.DecodeTimes[next->first];
+      stream.LatenciesInMs.push_back( latency.count() );
+      stream.DecodeTimes.erase( next->first );
+      stream.ReorderBuffer.erase( next );
+      next = stream.ReorderBuffer.find( ++stream.NextFrameToWrite );
+    }
+
+    if( stream.DecodeParked )
+    {
+      stream.DecodeParked = false;
+      m_Pool.Submit( [this, &stream] { this->Decode( stream ); } );
+    }
+    this->FinishIfDone( stream );
+  }
+
+  // Called with the stream mutex held
+  void FinishIfDone( Stream& stream )
+  {
+    if( !stream.Finished && stream.FramesInFlight == 0 &&
+        ( stream.EndOfStream || stream.Failed ) )
+    {
+      stream.Finished = true;
+      stream.EndTime = ClockType::now();
+      stream.Writer.release();
+      stream.Capture.release();
+    }
+  }
+
+  std::vector< std::unique_ptr< Stream > >&   m_Streams;
+  std::vector< std::unique_ptr< TProcessor > > m_Processors;
+  bridge::WorkStealingPool                    m_Pool;
+  unsigned int                                m_FramesInFlight;
+};
+
+// Per-stream throughput and latency (decode of a frame to its write)
+void reportStreams( const std::vector< std::unique_ptr< Stream > >& streams,
+                    double wallSeconds )
+{
+  size_t totalFrames = 0;
+  std::cout << std::left << std::setw( 32 ) << "stream"
+            << std::right << std::setw( 8 ) << "frames"
+            << std::setw( 10 ) << "fps"
+            << std::setw( 14 ) << "mean ms"
+            << std::setw( 14 ) << "p95 ms" << std::endl;
+  for( size_t s = 0; s < streams.size(); ++s )
+  {
+    const Stream& stream = *streams[s];
+    std::vector< double > latencies = stream.LatenciesInMs;
+    std::sort( latencies.begin(), latencies.end() );
+
+    double mean = 0.0;
+    double p95 = 0.0;
+    if( !latencies.empty() )
+    {
+      for( size_t i = 0; i < latencies.size(); ++i )
+      {
+        mean += latencies[i];
+      }
+      mean /= latencies.size();
+      p95 = latencies[( latencies.size() * 95 - 1 ) / 100];
+    }
+    std::chrono::duration< double > seconds = stream.EndTime - stream.StartTime;
+    double fps = seconds.count() > 0.0 ? latencies.size() / seconds.count() : 0.0;
+
+    std::cout << std::left << std::setw( 32 ) << stream.InputFile
+              << std::right << std::setw( 8 ) << latencies.size()
+              << std::fixed << std::setprecision( 1 )
+              << std::setw( 10 ) << fps
+              << std::setw( 14 ) << mean
+              << std::setw( 14 ) << p95 << std::endl;
+    if( stream.Failed )
+    {
+      std::cout << "  failed: " << stream.Error << std::endl;
+    }
+    totalFrames += latencies.size();
+  }
+  std::cout << "total: " << totalFrames << " frames in " << wallSeconds
+            << " s (" << ( wallSeconds > 0.0 ? totalFrames / wallSeconds : 0.0 )
+            << " fps)" << std::endl;
+}
+
+template< typename TProcessor >
+int runJobs( std::vector< std::unique_ptr< Stream > >& streams,
+             unsigned int numberOfWorkers, unsigned int framesInFlight,
+             bridge::ThreadBudget& budget )
+{
+  MultiStreamRunner< TProcessor > runner( streams, numberOfWorkers,
+                                          framesInFlight, budget );
+
+  bridge::ConcurrencyMeter meter;
+  meter.Start();
+  ClockType::time_point start = ClockType::now();
+  runner.Run();
+  std::chrono::duration< double > wall = ClockType::now() - start;
+  meter.Stop();
+
+  reportStreams( streams, wall.count() );
+  budget.Report( std::cout );
+  meter.Report( std::cout );
+  for( unsigned int i = 0; i < runner.GetNumberOfWorkers(); ++i )
+  {
+    std::cout << "Worker " << i << " input frame pool: ";
+    runner.GetProcessor( i ).GetFramePool()->Report( std::cout );
+  }
+
+  for( size_t s = 0; s < streams.size(); ++s )
+  {
+    if( streams[s]->Failed )
+    {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Parse a count between 1 and maximum, written in decimal digits only
+bool parseCount( const char * text, unsigned long maximum, unsigned int & count )
+{
+  if( !std::isdigit( static_cast< unsigned char >( text[0] ) ) )
+  {
+    return false;
+  }
+  char * end = 0;
+  const unsigned long value = std::strtoul( text, &end, 10 );
+  if( *end != '\0' || value < 1 || value > maximum )
+  {
+    return false;
+  }
+  count = static_cast< unsigned int >( value );
+  return true;
+}
+
+void printUsage( const char * program )
+{
+  std::cout << "Usage: " << program
+            << " canny|curvature number_of_workers job_list"
+            << " [frames_in_flight]" << std::endl;
+  std::cout << "Each line of job_list holds an input and an output video file."
+            << std::endl;
+  std::cout << "number_of_workers is between 1 and " << MaximumNumberOfWorkers
+            << ", or auto for the BRIDGE_THREADS budget (default: all cores)."
+            << std::endl;
+}
+
+int main ( int argc, char **argv )
+{
+  if( argc < 4 )
+  {
+    printUsage( argv[0] );
+    return -1;
+  }
+
+  const std::string pipeline = argv[1];
+  bridge::ThreadBudget budget;
+  unsigned int numberOfWorkers = budget.GetTotalThreads();
+  if( std::string( argv[2] ) != "auto" &&
+      !parseCount( argv[2], MaximumNumberOfWorkers, numberOfWorkers ) )
+  {
+    std::cerr << "Invalid number of workers: " << argv[2] << std::endl;
+    printUsage( argv[0] );
+    return -1;
+  }
+  unsigned int framesInFlight = 2;
+  if( argc > 4 && !parseCount( argv[4], 1024, framesInFlight ) )
+  {
+    std::cerr << "Invalid number of frames in flight: " << argv[4] << std::endl;
+    printUsage( argv[0] );
+    return -1;
+  }
+
+  std::vector< std::unique_ptr< Stream > > streams;
+  if( !readJobs( argv[3], streams ) )
+  {
+    return -1;
+  }
+  for( size_t s = 0; s < streams.size(); ++s )
+  {
+    if( !openStream( *streams[s] ) )
+    {
+      return -1;
+    }
+  }
+
+  // Every worker filters its own frames, what is left of the budget goes to
+  // the ITK and OpenCV pools
+  budget.Distribute( numberOfWorkers );
+  budget.Apply();
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( budget.GetITKThreads() );
+
+  if( pipeline == "canny" )
+  {
+    return runJobs< bridge::CannyFrameProcessor >( streams, numberOfWorkers,
+                                                   framesInFlight, budget );
+  }
+  if( pipeline == "curvature" )
+  {
+    return runJobs< bridge::CurvatureFlowFrameProcessor >( streams,
+      numberOfWorkers, framesInFlight, budget );
+  }
+
+  std::cerr << "Unknown pipeline: " << pipeline << std::endl;
+  return -1;
+}
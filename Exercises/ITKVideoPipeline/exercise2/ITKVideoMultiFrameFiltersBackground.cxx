@@ -0,0 +1,89 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+
+#include <itkVideoStream.h>
+#include <itkVideoFileReader.h>
+#include <itkVideoFileWriter.h>
+#include <itkOpenCVVideoIOFactory.h>
+
+#include "itkRunningAverageBackgroundVideoFilter.h"
+#include "itkY4MVideoIOFactory.h"
+
+// Change detection against a running average background instead of the
+// previous frame. The input VideoStream only holds the current frame; the
+// history lives in the mean (and variance) image of the filter.
+
+int main ( int argc, char **argv )
+{
+  if( argc < 3 )
+    {
+    std::cout << "Usage: " << argv[0]
+              << " input_video output_video [learning_rate] [standard_deviations]"
+              << std::endl;
+    std::cout << "Without standard_deviations, pixels more than 25 gray levels"
+              << " from the background are foreground." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const unsigned int Dimension =                 2;
+  typedef unsigned char                          IOPixelType;
+  typedef itk::Image< IOPixelType, Dimension >   IOFrameType;
+  typedef itk::VideoStream< IOFrameType >        IOVideoType;
+
+  typedef itk::VideoFileReader< IOVideoType >    ReaderType;
+  typedef itk::VideoFileWriter< IOVideoType >    WriterType;
+  typedef itk::RunningAverageBackgroundVideoFilter< IOVideoType, IOVideoType >
+                                                 BackgroundFilterType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  WriterType::Pointer writer = WriterType::New();
+  BackgroundFilterType::Pointer backgroundFilter = BackgroundFilterType::New();
+
+  itk::ObjectFactoryBase::RegisterFactory( itk::Y4MVideoIOFactory::New() );
+  itk::ObjectFactoryBase::RegisterFactory( itk::OpenCVVideoIOFactory::New() );
+  reader->SetFileName( argv[1] );
+  writer->SetFileName( argv[2] );
+
+  if( argc > 3 )
+    {
+    backgroundFilter->SetLearningRate( atof( argv[3] ) );
+    }
+  if( argc > 4 )
+    {
+    backgroundFilter->UseVarianceOn();
+    backgroundFilter->SetStandardDeviationThreshold( atof( argv[4] ) );
+    }
+
+  backgroundFilter->SetInput( reader->GetOutput() );
+  writer->SetInput( backgroundFilter->GetOutput() );
+
+  try
+    {
+    writer->Update();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
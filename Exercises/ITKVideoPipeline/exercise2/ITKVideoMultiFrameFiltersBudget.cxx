@@ -0,0 +1,208 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cctype>
+
+#include <itkVideoStream.h>
+#include <itkThresholdImageFilter.h>
+#include <itkImageFilterToVideoFilterWrapper.h>
+#include <itkFrameDifferenceVideoFilter.h>
+#include <itkVideoFileReader.h>
+#include <itkVideoFileWriter.h>
+#include <itkVideoIOFactory.h>
+#include <itkOpenCVVideoIOFactory.h>
+
+#include "itkReducedPrecisionCurvatureFlowImageFilter.h"
+#include "CurvatureFlowSettings.h"
+#include "itkIntermediateCastImageFilter.h"
+#include "itkVideoPipelineMemoryBudget.h"
+#include "itkY4MVideoIOFactory.h"
+
+// Parse a budget such as "40", "512K", "64M" or "2G". Returns false for
+// anything else: no digits, a sign, an unknown suffix or trailing text.
+bool parseBudget( const std::string & text, itk::SizeValueType & value )
+{
+  if( text.empty() || !isdigit( static_cast< unsigned char >( text[0] ) ) )
+    {
+    return false;
+    }
+  char * end = 0;
+  value = strtoul( text.c_str(), &end, 10 );
+  if( end == text.c_str() )
+    {
+    return false;
+    }
+  if( *end == '\0' )
+    {
+    return true;
+    }
+
+  const std::string suffixes = "KMG";
+  const std::string::size_type power = suffixes.find( toupper( *end ) );
+  if( power == std::string::npos || end[1] != '\0' )
+    {
+    return false;
+    }
+  for( std::string::size_type i = 0; i <= power; ++i )
+    {
+    value *= 1024;
+    }
+  return true;
+}
+
+int main ( int argc, char **argv )
+{
+  itk::SizeValueType budgetValue = 0;
+  if( argc < 4 || !parseBudget( argv[3], budgetValue ) )
+    {
+    if( argc >= 4 )
+      {
+      std::cerr << "Invalid budget: " << argv[3] << std::endl;
+      }
+    std::cout << "Usage: " << argv[0]
+              << " input_video output_video budget [bytes|frames]" << std::endl;
+    std::cout << "  budget: a number, optionally followed by K, M or G"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const unsigned int Dimension =                 2;
+  typedef unsigned char                          IOPixelType;
+  // float, or unsigned short for Q8.8 fixed point intermediate frames at half
+  // the memory traffic (see itkIntermediatePixelTraits.h)
+  typedef float                                  RealPixelType;
+  typedef itk::Image< IOPixelType, Dimension >   IOFrameType;
+  typedef itk::Image< RealPixelType, Dimension > RealFrameType;
+  typedef itk::VideoStream< IOFrameType >        IOVideoType;
+  typedef itk::VideoStream< RealFrameType >      RealVideoType;
+
+  typedef itk::VideoFileReader< IOVideoType >    ReaderType;
+  typedef itk::VideoFileWriter< IOVideoType >    WriterType;
+  typedef itk::IntermediateCastImageFilter< RealFrameType, IOFrameType >
+                                                 CastImageFilterType;
+  typedef itk::ImageFilterToVideoFilterWrapper< CastImageFilterType >
+                                                 CastVideoFilterType;
+  typedef itk::ReducedPrecisionCurvatureFlowImageFilter< IOFrameType,
+                                                 RealFrameType >
+                                                 ImageFilterType;
+  typedef itk::ImageFilterToVideoFilterWrapper< ImageFilterType >
+                                                 VideoFilterType;
+  typedef itk::ThresholdImageFilter< IOFrameType >
+                                                 ThresholdImageFilterType;
+  typedef itk::ImageFilterToVideoFilterWrapper< ThresholdImageFilterType >
+                                                 ThresholdVideoFilterType;
+
+  typedef itk::FrameDifferenceVideoFilter< IOVideoType, IOVideoType >
+                                                 FrameDifferenceFilterType;
+  typedef itk::VideoPipelineMemoryBudget         BudgetType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  WriterType::Pointer writer = WriterType::New();
+  ImageFilterType::Pointer imageFilter = ImageFilterType::New();
+  VideoFilterType::Pointer videoFilter = VideoFilterType::New();
+  CastImageFilterType::Pointer imageCaster = CastImageFilterType::New();
+  CastVideoFilterType::Pointer videoCaster = CastVideoFilterType::New();
+  ThresholdImageFilterType::Pointer imageThresh = ThresholdImageFilterType::New();
+  ThresholdVideoFilterType::Pointer videoThresh = ThresholdVideoFilterType::New();
+  FrameDifferenceFilterType::Pointer frameDifferenceFilter =
+    FrameDifferenceFilterType::New();
+  BudgetType::Pointer budget = BudgetType::New();
+
+  // y4m files go through Y4MVideoIO, everything else through OpenCV
+  itk::ObjectFactoryBase::RegisterFactory( itk::Y4MVideoIOFactory::New() );
+  itk::ObjectFactoryBase::RegisterFactory( itk::OpenCVVideoIOFactory::New() );
+  reader->SetFileName( argv[1] );
+  writer->SetFileName( argv[2] );
+
+  const unsigned int frameOffset = 1;
+  frameDifferenceFilter->SetFrameOffset( frameOffset );
+
+  videoCaster->SetImageFilter( imageCaster );
+
+  imageThresh->ThresholdBelow( 128 );
+  videoThresh->SetImageFilter( imageThresh );
+
+  imageFilter->SetTimeStep( 0.5 );
+  // At most 20 iterations, fewer with BRIDGE_CURVATURE_TOLERANCE set
+  bridge::CurvatureFlowSettings::FromEnvironment( 20 ).ApplyTo(
+    imageFilter.GetPointer() );
+  bridge::IterationReport< ImageFilterType > iterations( imageFilter );
+  videoFilter->SetImageFilter( imageFilter );
+
+  videoFilter->SetInput( reader->GetOutput() );
+  videoCaster->SetInput( videoFilter->GetOutput() );
+  frameDifferenceFilter->SetInput( videoCaster->GetOutput() );
+  videoThresh->SetInput( frameDifferenceFilter->GetOutput() );
+  writer->SetInput( videoThresh->GetOutput() );
+
+  // The size of a frame is needed to turn a budget in bytes into frames.
+  itk::VideoIOBase::Pointer videoIO = itk::VideoIOFactory::CreateVideoIO(
+    itk::VideoIOFactory::ReadFileMode, argv[1] );
+  if( videoIO.IsNull() )
+    {
+    std::cerr << "Unable to open video file: " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+  videoIO->SetFileName( argv[1] );
+  videoIO->ReadImageInformation();
+  const itk::SizeValueType pixelsPerFrame =
+    videoIO->GetDimensions(0) * videoIO->GetDimensions(1);
+  videoIO->FinishReadingOrWriting();
+
+  const std::string unit = ( argc > 4 ) ? argv[4] : "frames";
+  if( unit == "bytes" )
+    {
+    budget->SetBudgetInBytes( budgetValue );
+    }
+  else
+    {
+    budget->SetBudgetInFrames( budgetValue );
+    }
+
+  // The frame difference filter needs FrameOffset+1 frames of its input.
+  budget->AddStage( "Reader", reader, reader->GetOutput(),
+                    pixelsPerFrame * sizeof( IOPixelType ) );
+  budget->AddStage( "CurvatureFlow", videoFilter, videoFilter->GetOutput(),
+                    pixelsPerFrame * sizeof( RealPixelType ) );
+  budget->AddStage( "Cast", videoCaster, videoCaster->GetOutput(),
+                    pixelsPerFrame * sizeof( IOPixelType ), frameOffset + 1 );
+  budget->AddStage( "FrameDifference", frameDifferenceFilter,
+                    frameDifferenceFilter->GetOutput(),
+                    pixelsPerFrame * sizeof( IOPixelType ) );
+  budget->AddStage( "Threshold", videoThresh, videoThresh->GetOutput(),
+                    pixelsPerFrame * sizeof( IOPixelType ) );
+
+  try
+    {
+    budget->ApplyBudget();
+    writer->Update();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  budget->Report( std::cout );
+  iterations.Report( std::cout );
+
+  return EXIT_SUCCESS;
+}
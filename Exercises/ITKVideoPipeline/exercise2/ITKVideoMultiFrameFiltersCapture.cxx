@@ -0,0 +1,213 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+#include <itkVideoStream.h>
+#include <itkCastImageFilter.h>
+#include <itkThresholdImageFilter.h>
+#include <itkImageFilterToVideoFilterWrapper.h>
+#include <itkFrameDifferenceVideoFilter.h>
+#include <itkVideoFileWriter.h>
+#include <itkOpenCVVideoIOFactory.h>
+
+#include "itkConvergentCurvatureFlowImageFilter.h"
+#include "itkOpenCVCaptureVideoSource.h"
+#include "itkY4MVideoIOFactory.h"
+#include "CurvatureFlowSettings.h"
+#include "FrameStreamIO.h"
+#include "VideoSeekIndex.h"
+
+// ITKVideoMultiFrameFiltersAnswer2 fed by an OpenCVCaptureVideoSource
+// instead of a VideoFileReader. The input is a camera index, a y4m stream
+// ("-" for the standard input), read straight into the ITK frames, or a
+// video decoded by cv::VideoCapture. The third argument gives how many
+// frames to process. Without it, a video takes the exact number of frames
+// of its seek index (see BuildVideoSeekIndex): the count cv::VideoCapture
+// reports is only an estimate, and a wrong one would truncate the output.
+// A camera or a stream has no number of frames.
+
+bool isCameraIndex( const std::string & name )
+{
+  return !name.empty() &&
+    name.find_first_not_of( "0123456789" ) == std::string::npos;
+}
+
+int main ( int argc, char **argv )
+{
+  if( argc < 3 )
+    {
+    std::cout << "Usage: " << argv[0]
+              << " input_video|camera_index output_video [number_of_frames]"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const unsigned int Dimension =                 2;
+  typedef unsigned char                          IOPixelType;
+  typedef float                                  RealPixelType;
+  typedef itk::Image< IOPixelType, Dimension >   IOFrameType;
+  typedef itk::Image< RealPixelType, Dimension > RealFrameType;
+  typedef itk::VideoStream< IOFrameType >        IOVideoType;
+  typedef itk::VideoStream< RealFrameType >      RealVideoType;
+
+  typedef itk::OpenCVCaptureVideoSource< IOVideoType >
+                                                 SourceType;
+  typedef itk::VideoFileWriter< IOVideoType >    WriterType;
+  typedef itk::CastImageFilter< RealFrameType, IOFrameType >
+                                                 CastImageFilterType;
+  typedef itk::ImageFilterToVideoFilterWrapper< CastImageFilterType >
+                                                 CastVideoFilterType;
+  typedef itk::ConvergentCurvatureFlowImageFilter< IOFrameType, RealFrameType >
+                                                 ImageFilterType;
+  typedef itk::ImageFilterToVideoFilterWrapper< ImageFilterType >
+                                                 VideoFilterType;
+  typedef itk::ThresholdImageFilter< IOFrameType >
+                                                 ThresholdImageFilterType;
+  typedef itk::ImageFilterToVideoFilterWrapper< ThresholdImageFilterType >
+                                                 ThresholdVideoFilterType;
+
+  typedef itk::FrameDifferenceVideoFilter< IOVideoType, IOVideoType >
+                                                 FrameDifferenceFilterType;
+
+  SourceType::Pointer source = SourceType::New();
+  WriterType::Pointer writer = WriterType::New();
+  ImageFilterType::Pointer imageFilter = ImageFilterType::New();
+  VideoFilterType::Pointer videoFilter = VideoFilterType::New();
+  CastImageFilterType::Pointer imageCaster = CastImageFilterType::New();
+  CastVideoFilterType::Pointer videoCaster = CastVideoFilterType::New();
+  ThresholdImageFilterType::Pointer imageThresh = ThresholdImageFilterType::New();
+  ThresholdVideoFilterType::Pointer videoThresh = ThresholdVideoFilterType::New();
+  FrameDifferenceFilterType::Pointer frameDifferenceFilter =
+    FrameDifferenceFilterType::New();
+
+  // Only the writer goes through a VideoIO
+  itk::ObjectFactoryBase::RegisterFactory( itk::Y4MVideoIOFactory::New() );
+  itk::ObjectFactoryBase::RegisterFactory( itk::OpenCVVideoIOFactory::New() );
+
+  const std::string inputName = argv[1];
+  cv::VideoCapture capture;
+  bridge::FrameSource frameSource;
+  double framesPerSecond = 0.0;
+  try
+    {
+    if( bridge::IsY4MStreamName( inputName ) )
+      {
+      if( !bridge::OpenFrameSource( inputName, frameSource ) )
+        {
+        std::cerr << "Unable to open video file: " << inputName << std::endl;
+        return EXIT_FAILURE;
+        }
+      source->SetFrameSize( frameSource.FrameSize );
+      source->SetMatProvider( frameSource.Read );
+      framesPerSecond = frameSource.FramesPerSecond;
+      }
+    else
+      {
+      if( isCameraIndex( inputName ) )
+        {
+        capture.open( atoi( inputName.c_str() ) );
+        }
+      else
+        {
+        capture.open( inputName );
+        }
+      if( !capture.isOpened() )
+        {
+        std::cerr << "Unable to open video: " << inputName << std::endl;
+        return EXIT_FAILURE;
+        }
+      source->SetVideoCapture( &capture );
+      framesPerSecond = source->GetFramesPerSecond();
+      }
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+  bridge::VideoSeekIndex seekIndex;
+  if( argc > 3 )
+    {
+    source->SetNumberOfFrames( atoi( argv[3] ) );
+    }
+  else if( capture.isOpened() && !isCameraIndex( inputName ) &&
+           seekIndex.Load( inputName ) )
+    {
+    source->SetNumberOfFrames( seekIndex.GetNumberOfFrames() );
+    }
+  if( source->GetNumberOfFrames() == 0 )
+    {
+    std::cerr << inputName << " does not give an exact number of frames,"
+              << " pass it as the third argument";
+    if( source->GetEstimatedNumberOfFrames() > 0 )
+      {
+      std::cerr << " (about " << source->GetEstimatedNumberOfFrames()
+                << ") or build its seek index with BuildVideoSeekIndex";
+      }
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  writer->SetFileName( argv[2] );
+  writer->SetFramesPerSecond( framesPerSecond > 0 ? framesPerSecond : 25 );
+
+  frameDifferenceFilter->SetFrameOffset(1);
+
+  videoCaster->SetImageFilter( imageCaster );
+
+  imageThresh->ThresholdBelow( 128 );
+  videoThresh->SetImageFilter( imageThresh );
+
+  imageFilter->SetTimeStep( 0.5 );
+  // At most 20 iterations, fewer with BRIDGE_CURVATURE_TOLERANCE set
+  bridge::CurvatureFlowSettings::FromEnvironment( 20 ).ApplyTo(
+    imageFilter.GetPointer() );
+  videoFilter->SetImageFilter( imageFilter );
+
+  videoFilter->SetInput( source->GetOutput() );
+  videoCaster->SetInput( videoFilter->GetOutput() );
+  frameDifferenceFilter->SetInput( videoCaster->GetOutput() );
+  videoThresh->SetInput( frameDifferenceFilter->GetOutput() );
+  writer->SetInput( videoThresh->GetOutput() );
+
+  try
+    {
+    writer->Update();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+  catch( std::exception & excp )
+    {
+    // A truncated y4m frame stops the frame provider
+    std::cerr << excp.what() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << source->GetNumberOfDirectFrames() << " frames read in place, "
+            << source->GetNumberOfConvertedFrames() << " frames converted"
+            << std::endl;
+
+  return EXIT_SUCCESS;
+}
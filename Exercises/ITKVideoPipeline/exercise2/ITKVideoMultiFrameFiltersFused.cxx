@@ -0,0 +1,106 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <iostream>
+
+#include <itkVideoStream.h>
+#include <itkImageFilterToVideoFilterWrapper.h>
+#include <itkVideoFileReader.h>
+#include <itkVideoFileWriter.h>
+#include <itkOpenCVVideoIOFactory.h>
+
+#include "itkReducedPrecisionCurvatureFlowImageFilter.h"
+#include "CurvatureFlowSettings.h"
+#include "itkCastFrameDifferenceThresholdVideoFilter.h"
+#include "itkY4MVideoIOFactory.h"
+
+int main ( int argc, char **argv )
+{
+  if( argc < 3 )
+    {
+    std::cout << "Usage: " << argv[0] << "input_image output_image" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const unsigned int Dimension =                 2;
+  typedef unsigned char                          IOPixelType;
+  // float, or unsigned short for Q8.8 fixed point intermediate frames at half
+  // the memory traffic (see itkIntermediatePixelTraits.h)
+  typedef float                                  RealPixelType;
+  typedef itk::Image< IOPixelType, Dimension >   IOFrameType;
+  typedef itk::Image< RealPixelType, Dimension > RealFrameType;
+  typedef itk::VideoStream< IOFrameType >        IOVideoType;
+  typedef itk::VideoStream< RealFrameType >      RealVideoType;
+
+  typedef itk::VideoFileReader< IOVideoType >    ReaderType;
+  typedef itk::VideoFileWriter< IOVideoType >    WriterType;
+  typedef itk::ReducedPrecisionCurvatureFlowImageFilter< IOFrameType,
+                                                 RealFrameType >
+                                                 ImageFilterType;
+  typedef itk::ImageFilterToVideoFilterWrapper< ImageFilterType >
+                                                 VideoFilterType;
+
+  // Cast, FrameDifference and Threshold fused into a single stage
+  typedef itk::CastFrameDifferenceThresholdVideoFilter< RealVideoType, IOVideoType >
+                                                 FusedFilterType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  WriterType::Pointer writer = WriterType::New();
+  ImageFilterType::Pointer imageFilter = ImageFilterType::New();
+  VideoFilterType::Pointer videoFilter = VideoFilterType::New();
+  FusedFilterType::Pointer fusedFilter =
+    FusedFilterType::New();
+
+  // y4m files go through Y4MVideoIO, everything else through OpenCV
+  itk::ObjectFactoryBase::RegisterFactory( itk::Y4MVideoIOFactory::New() );
+  itk::ObjectFactoryBase::RegisterFactory( itk::OpenCVVideoIOFactory::New() );
+  reader->SetFileName( argv[1] );
+  writer->SetFileName( argv[2] );
+
+  // The filter keeps the previous 8-bit frame, so the CurvatureFlow output
+  // only buffers the current float frame. The frames written are the ones
+  // of the chain.
+  fusedFilter->SetFrameOffset( 1 );
+  fusedFilter->ThresholdBelow( 128 );
+
+  imageFilter->SetTimeStep( 0.5 );
+  // At most 20 iterations, fewer with BRIDGE_CURVATURE_TOLERANCE set
+  bridge::CurvatureFlowSettings::FromEnvironment( 20 ).ApplyTo(
+    imageFilter.GetPointer() );
+  bridge::IterationReport< ImageFilterType > iterations( imageFilter );
+  videoFilter->SetImageFilter( imageFilter );
+
+  videoFilter->SetInput( reader->GetOutput() );
+  fusedFilter->SetInput( videoFilter->GetOutput() );
+  writer->SetInput( fusedFilter->GetOutput() );
+
+  try
+    {
+    writer->Update();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  iterations.Report( std::cout );
+
+  return EXIT_SUCCESS;
+}
+
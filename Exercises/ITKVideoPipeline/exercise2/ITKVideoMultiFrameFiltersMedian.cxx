@@ -0,0 +1,77 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+
+#include <itkVideoStream.h>
+#include <itkVideoFileReader.h>
+#include <itkVideoFileWriter.h>
+#include <itkOpenCVVideoIOFactory.h>
+
+#include "itkTemporalMedianVideoFilter.h"
+#include "itkY4MVideoIOFactory.h"
+
+// Temporal median of the last frames, which removes the noise and the
+// objects that pass through a pixel in less than half the window.
+
+int main ( int argc, char **argv )
+{
+  if( argc < 3 )
+    {
+    std::cout << "Usage: " << argv[0]
+              << " input_video output_video [window_length]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const unsigned int Dimension =                 2;
+  typedef unsigned char                          IOPixelType;
+  typedef itk::Image< IOPixelType, Dimension >   IOFrameType;
+  typedef itk::VideoStream< IOFrameType >        IOVideoType;
+
+  typedef itk::VideoFileReader< IOVideoType >    ReaderType;
+  typedef itk::VideoFileWriter< IOVideoType >    WriterType;
+  typedef itk::TemporalMedianVideoFilter< IOVideoType, IOVideoType >
+                                                 MedianFilterType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  WriterType::Pointer writer = WriterType::New();
+  MedianFilterType::Pointer medianFilter = MedianFilterType::New();
+
+  itk::ObjectFactoryBase::RegisterFactory( itk::Y4MVideoIOFactory::New() );
+  itk::ObjectFactoryBase::RegisterFactory( itk::OpenCVVideoIOFactory::New() );
+  reader->SetFileName( argv[1] );
+  writer->SetFileName( argv[2] );
+
+  medianFilter->SetWindowLength( argc > 3 ? atoi( argv[3] ) : 15 );
+
+  medianFilter->SetInput( reader->GetOutput() );
+  writer->SetInput( medianFilter->GetOutput() );
+
+  try
+    {
+    writer->Update();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
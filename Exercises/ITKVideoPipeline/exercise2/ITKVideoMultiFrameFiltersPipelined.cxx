@@ -0,0 +1,292 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <exception>
+#include <iostream>
+#include <cstdlib>
+
+#include <itkVideoStream.h>
+#include <itkThresholdImageFilter.h>
+#include <itkImageAlgorithm.h>
+#include <itkMultiThreader.h>
+#include <itkVideoFileReader.h>
+#include <itkVideoFileWriter.h>
+#include <itkOpenCVVideoIOFactory.h>
+
+#include "itkReducedPrecisionCurvatureFlowImageFilter.h"
+#include "CurvatureFlowSettings.h"
+#include "itkIntermediateCastImageFilter.h"
+#include "itkFrameProviderVideoSource.h"
+#include "itkFrameBufferPool.h"
+#include "PooledFrameStages.h"
+#include "StagePipeline.h"
+#include "ThreadBudget.h"
+#include "itkY4MVideoIOFactory.h"
+#include "itkIndexedOpenCVVideoIOFactory.h"
+
+const unsigned int Dimension =                 2;
+typedef unsigned char                          IOPixelType;
+// float, or unsigned short for Q8.8 fixed point intermediate frames at half
+// the memory traffic (see itkIntermediatePixelTraits.h)
+typedef float                                  RealPixelType;
+typedef itk::Image< IOPixelType, Dimension >   IOFrameType;
+typedef itk::Image< RealPixelType, Dimension > RealFrameType;
+typedef itk::VideoStream< IOFrameType >        IOVideoType;
+typedef itk::FrameBufferPool< IOFrameType >    IOFramePoolType;
+typedef itk::FrameBufferPool< RealFrameType >  RealFramePoolType;
+
+// A frame travelling through the stages together with its frame number.
+struct FrameToken
+{
+  itk::SizeValueType     Index;
+  IOFrameType::Pointer   Frame;
+  RealFrameType::Pointer RealFrame;
+};
+
+// Pull a single frame out of the reader and copy it out of the frame
+// buffer of its VideoStream.
+IOFrameType::Pointer readFrame( IOVideoType * readerOutput,
+                                itk::SizeValueType frameNumber,
+                                IOFramePoolType * pool )
+{
+  itk::TemporalRegion requestedRegion;
+  requestedRegion.SetFrameStart( frameNumber );
+  requestedRegion.SetFrameDuration( 1 );
+  readerOutput->SetRequestedTemporalRegion( requestedRegion );
+  readerOutput->PropagateRequestedRegion();
+  readerOutput->UpdateOutputData();
+
+  const IOFrameType * frame = readerOutput->GetFrame( frameNumber );
+  pool->SetFrameRegion( frame->GetLargestPossibleRegion() );
+  IOFrameType::Pointer copy = pool->Acquire();
+  copy->CopyInformation( frame );
+  itk::ImageAlgorithm::Copy( frame, copy.GetPointer(),
+                             frame->GetBufferedRegion(),
+                             copy->GetLargestPossibleRegion() );
+  return copy;
+}
+
+int main ( int argc, char **argv )
+{
+  if( argc < 3 )
+    {
+    std::cout << "Usage: " << argv[0]
+              << " input_video output_video [queue_capacity]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::VideoFileReader< IOVideoType >    ReaderType;
+  typedef itk::VideoFileWriter< IOVideoType >    WriterType;
+  typedef itk::FrameProviderVideoSource< IOVideoType >
+                                                 SourceType;
+  typedef itk::ReducedPrecisionCurvatureFlowImageFilter< IOFrameType,
+                                                 RealFrameType >
+                                                 ImageFilterType;
+  typedef itk::IntermediateCastImageFilter< RealFrameType, IOFrameType >
+                                                 CastImageFilterType;
+  typedef itk::ThresholdImageFilter< IOFrameType >
+                                                 ThresholdImageFilterType;
+  typedef bridge::StagePipeline< FrameToken >    PipelineType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  WriterType::Pointer writer = WriterType::New();
+  SourceType::Pointer source = SourceType::New();
+  ImageFilterType::Pointer imageFilter = ImageFilterType::New();
+  CastImageFilterType::Pointer imageCaster = CastImageFilterType::New();
+  ThresholdImageFilterType::Pointer imageThresh = ThresholdImageFilterType::New();
+  IOFramePoolType::Pointer ioFramePool = IOFramePoolType::New();
+  RealFramePoolType::Pointer realFramePool = RealFramePoolType::New();
+
+  // y4m files go through Y4MVideoIO, everything else through OpenCV. The
+  // frames are requested one by one, so videos with a seek index go through
+  // IndexedOpenCVVideoIO, which seeks exactly.
+  itk::ObjectFactoryBase::RegisterFactory( itk::Y4MVideoIOFactory::New() );
+  itk::ObjectFactoryBase::RegisterFactory( itk::IndexedOpenCVVideoIOFactory::New() );
+  itk::ObjectFactoryBase::RegisterFactory( itk::OpenCVVideoIOFactory::New() );
+  reader->SetFileName( argv[1] );
+  writer->SetFileName( argv[2] );
+
+  const itk::SizeValueType frameOffset = 1;
+
+  imageThresh->ThresholdBelow( 128 );
+  imageThresh->InPlaceOff();
+
+  imageFilter->SetTimeStep( 0.5 );
+  // At most 20 iterations, fewer with BRIDGE_CURVATURE_TOLERANCE set
+  bridge::CurvatureFlowSettings::FromEnvironment( 20 ).ApplyTo(
+    imageFilter.GetPointer() );
+  bridge::IterationReport< ImageFilterType > iterations( imageFilter );
+
+  PipelineType pipeline( argc > 3 ? atoi( argv[3] ) : 2 );
+
+  itk::SizeValueType startFrame = 0;
+  itk::SizeValueType nextFrame = 0;
+  itk::SizeValueType endFrame = 0;
+  FrameToken firstToken;
+  try
+    {
+    reader->UpdateOutputInformation();
+    const itk::TemporalRegion inputRegion =
+      reader->GetOutput()->GetLargestPossibleTemporalRegion();
+    startFrame = inputRegion.GetFrameStart();
+    endFrame = startFrame + inputRegion.GetFrameDuration();
+    if( inputRegion.GetFrameDuration() <= frameOffset )
+      {
+      std::cerr << "The video needs more than " << frameOffset << " frames"
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // The first frame is read here to learn the geometry of the output.
+    firstToken.Index = startFrame;
+    firstToken.Frame = readFrame( reader->GetOutput(), startFrame,
+                                  ioFramePool );
+    nextFrame = startFrame + 1;
+    realFramePool->SetFrameRegion( ioFramePool->GetFrameRegion() );
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+  catch( std::exception & excp )
+    {
+    std::cerr << excp.what() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Stage 0: decode
+  pipeline.SetSource( [&]( FrameToken & token )
+    {
+    if( firstToken.Frame.IsNotNull() )
+      {
+      token = firstToken;
+      firstToken.Frame = NULL;
+      return true;
+      }
+    if( nextFrame >= endFrame )
+      {
+      return false;
+      }
+    token.Index = nextFrame;
+    token.Frame = readFrame( reader->GetOutput(), nextFrame++, ioFramePool );
+    return true;
+    } );
+
+  // Stage 1: CurvatureFlow
+  pipeline.AddStage( [&]( FrameToken & token )
+    {
+    token.RealFrame = bridge::RunPooledFilter(
+      imageFilter.GetPointer(), token.Frame, realFramePool.GetPointer() );
+    token.Frame = NULL;
+    return true;
+    } );
+
+  // Stage 2: cast back to 8 bits
+  pipeline.AddStage( [&]( FrameToken & token )
+    {
+    token.Frame = bridge::RunPooledFilter(
+      imageCaster.GetPointer(), token.RealFrame, ioFramePool.GetPointer() );
+    token.RealFrame = NULL;
+    return true;
+    } );
+
+  // Stage 3: difference with the frame FrameOffset frames earlier, with the
+  // same arithmetic as itk::FrameDifferenceVideoFilter. The first frames
+  // only fill the history and produce no output.
+  bridge::FrameDifferenceStage< IOFrameType > frameDifference( frameOffset,
+                                                               ioFramePool );
+  pipeline.AddStage( [&]( FrameToken & token )
+    {
+    return frameDifference.Process( token.Frame );
+    } );
+
+  // Stage 4: threshold
+  pipeline.AddStage( [&]( FrameToken & token )
+    {
+    token.Frame = bridge::RunPooledFilter(
+      imageThresh.GetPointer(), token.Frame, ioFramePool.GetPointer() );
+    return true;
+    } );
+
+  // The writer pulls the processed frames out of the last queue. Their
+  // numbering starts at FrameOffset, as for FrameDifferenceVideoFilter.
+  source->SetFrameInformation( firstToken.Frame );
+  source->SetStartFrame( startFrame + frameOffset );
+  source->SetNumberOfFrames( endFrame - startFrame - frameOffset );
+  source->SetFrameProvider( [&]( itk::SizeValueType frameNumber,
+                                 IOFrameType * frame )
+    {
+    FrameToken token;
+    if( !pipeline.Pop( token ) || token.Index != frameNumber )
+      {
+      return false;
+      }
+    itk::ImageAlgorithm::Copy( token.Frame.GetPointer(), frame,
+                               token.Frame->GetLargestPossibleRegion(),
+                               frame->GetRequestedRegion() );
+    return true;
+    } );
+  writer->SetInput( source->GetOutput() );
+
+  // The source, the stages and the writer loop run at the same time
+  bridge::ThreadBudget budget;
+  budget.Distribute( static_cast< unsigned int >( pipeline.GetNumberOfThreads() ) + 1 );
+  budget.Apply();
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( budget.GetITKThreads() );
+  // The filters were created with the previous global default: the number
+  // of stages is only known once the stages, which use them, are added.
+  // The threads left over by the division go to the heaviest stages first.
+  imageFilter->SetNumberOfThreads( budget.GetITKThreads( 0 ) );
+  imageThresh->SetNumberOfThreads( budget.GetITKThreads( 1 ) );
+  imageCaster->SetNumberOfThreads( budget.GetITKThreads( 2 ) );
+  budget.PinCurrentThread();
+  pipeline.SetThreadStart( [&budget]( size_t ) { budget.PinCurrentThread(); } );
+
+  bridge::ConcurrencyMeter meter;
+  meter.Start();
+  try
+    {
+    pipeline.Start();
+    writer->Update();
+    pipeline.Stop();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    pipeline.Stop();
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+  catch( std::exception & excp )
+    {
+    pipeline.Stop();
+    std::cerr << excp.what() << std::endl;
+    return EXIT_FAILURE;
+    }
+  meter.Stop();
+
+  std::cout << "8-bit frame pool: ";
+  ioFramePool->Report( std::cout );
+  std::cout << "Real frame pool:  ";
+  realFramePool->Report( std::cout );
+  budget.Report( std::cout );
+  meter.Report( std::cout );
+  iterations.Report( std::cout );
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,394 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <itkVideoStream.h>
+#include <itkCastImageFilter.h>
+#include <itkThresholdImageFilter.h>
+#include <itkImageFilterToVideoFilterWrapper.h>
+#include <itkFrameDifferenceVideoFilter.h>
+#include <itkMultiThreader.h>
+#include <itkVideoFileReader.h>
+#include <itkVideoFileWriter.h>
+#include <itkOpenCVVideoIOFactory.h>
+
+#include "itkConvergentCurvatureFlowImageFilter.h"
+#include "itkFrameProviderVideoSource.h"
+#include "itkIndexedOpenCVVideoIOFactory.h"
+#include "itkY4MVideoIOFactory.h"
+#include "CurvatureFlowSettings.h"
+#include "FrameStreamIO.h"
+#include "ThreadBudget.h"
+#include "VideoSeekIndex.h"
+
+// Segment-parallel version of ITKVideoMultiFrameFiltersAnswer2. A single
+// reader decodes one frame at a time, which bounds the frame rate of the
+// whole chain. Here the output frames are split into time segments, and each
+// segment runs its own reader -> CurvatureFlow -> cast -> frame difference
+// -> threshold chain on its own thread.
+//
+// A segment producing the output frames [a, b) reads the input frames
+// [a - FrameOffset, b): the frames before its first output frame are read
+// again, so that the frame difference at the boundary is the one of the
+// sequential run. Every segment is written to a temporary y4m file, without
+// loss, and the segments are then written in order through a single
+// VideoFileWriter. The output matches the sequential run frame for frame.
+//
+// Each reader seeks to the start of its segment, which has to be exact:
+// y4m inputs and videos with a seek index (see the BuildVideoSeekIndex
+// tool) are split, other videos are processed as a single segment.
+
+const unsigned int Dimension =                 2;
+typedef unsigned char                          IOPixelType;
+typedef float                                  RealPixelType;
+typedef itk::Image< IOPixelType, Dimension >   IOFrameType;
+typedef itk::Image< RealPixelType, Dimension > RealFrameType;
+typedef itk::VideoStream< IOFrameType >        IOVideoType;
+
+// OpenCV view of the buffer of an 8-bit frame
+cv::Mat frameView( IOFrameType * frame )
+{
+  const IOFrameType::SizeType size = frame->GetBufferedRegion().GetSize();
+  return cv::Mat( static_cast< int >( size[1] ), static_cast< int >( size[0] ),
+                  CV_8UC1, frame->GetBufferPointer() );
+}
+
+// The filter chain of ITKVideoMultiFrameFiltersAnswer2, with its own reader
+class SegmentChain
+{
+public:
+  typedef itk::VideoFileReader< IOVideoType >    ReaderType;
+  typedef itk::CastImageFilter< RealFrameType, IOFrameType >
+                                                 CastImageFilterType;
+  typedef itk::ImageFilterToVideoFilterWrapper< CastImageFilterType >
+                                                 CastVideoFilterType;
+  typedef itk::ConvergentCurvatureFlowImageFilter< IOFrameType, RealFrameType >
+                                                 ImageFilterType;
+  typedef itk::ImageFilterToVideoFilterWrapper< ImageFilterType >
+                                                 VideoFilterType;
+  typedef itk::ThresholdImageFilter< IOFrameType >
+                                                 ThresholdImageFilterType;
+  typedef itk::ImageFilterToVideoFilterWrapper< ThresholdImageFilterType >
+                                                 ThresholdVideoFilterType;
+  typedef itk::FrameDifferenceVideoFilter< IOVideoType, IOVideoType >
+                                                 FrameDifferenceFilterType;
+
+  SegmentChain( const char * fileName, itk::SizeValueType frameOffset )
+  {
+    m_Reader = ReaderType::New();
+    m_ImageFilter = ImageFilterType::New();
+    m_VideoFilter = VideoFilterType::New();
+    m_ImageCaster = CastImageFilterType::New();
+    m_VideoCaster = CastVideoFilterType::New();
+    m_ImageThresh = ThresholdImageFilterType::New();
+    m_VideoThresh = ThresholdVideoFilterType::New();
+    m_FrameDifferenceFilter = FrameDifferenceFilterType::New();
+
+    m_Reader->SetFileName( fileName );
+
+    m_FrameDifferenceFilter->SetFrameOffset( frameOffset );
+
+    m_VideoCaster->SetImageFilter( m_ImageCaster );
+
+    m_ImageThresh->ThresholdBelow( 128 );
+    m_VideoThresh->SetImageFilter( m_ImageThresh );
+
+    m_ImageFilter->SetTimeStep( 0.5 );
+    bridge::CurvatureFlowSettings::FromEnvironment( 20 ).ApplyTo(
+      m_ImageFilter.GetPointer() );
+    m_VideoFilter->SetImageFilter( m_ImageFilter );
+
+    m_VideoFilter->SetInput( m_Reader->GetOutput() );
+    m_VideoCaster->SetInput( m_VideoFilter->GetOutput() );
+    m_FrameDifferenceFilter->SetInput( m_VideoCaster->GetOutput() );
+    m_VideoThresh->SetInput( m_FrameDifferenceFilter->GetOutput() );
+  }
+
+  // Open the video. The VideoIO factories are not meant to be used from
+  // several threads at once, so this runs before the segments start.
+  void Initialize()
+  {
+    m_Reader->UpdateOutputInformation();
+  }
+
+  const itk::TemporalRegion & GetInputTemporalRegion() const
+  {
+    return m_Reader->GetOutput()->GetLargestPossibleTemporalRegion();
+  }
+
+  double GetFramesPerSecond() const
+  {
+    return m_Reader->GetFramesPerSecond();
+  }
+
+  // Threads of the image filters of the chain
+  void SetNumberOfThreads( unsigned int numberOfThreads )
+  {
+    m_ImageFilter->SetNumberOfThreads( numberOfThreads );
+    m_ImageCaster->SetNumberOfThreads( numberOfThreads );
+    m_ImageThresh->SetNumberOfThreads( numberOfThreads );
+  }
+
+  // Compute the output frames [start, end) and write them to a y4m file
+  void Run( itk::SizeValueType start, itk::SizeValueType end,
+            const std::string & fileName, double framesPerSecond )
+  {
+    IOVideoType * output = m_VideoThresh->GetOutput();
+    bridge::Y4MFrameWriter writer;
+    for( itk::SizeValueType frameNumber = start; frameNumber < end; ++frameNumber )
+      {
+      itk::TemporalRegion requestedRegion;
+      requestedRegion.SetFrameStart( frameNumber );
+      requestedRegion.SetFrameDuration( 1 );
+      output->SetRequestedTemporalRegion( requestedRegion );
+      output->PropagateRequestedRegion();
+      output->UpdateOutputData();
+
+      cv::Mat frame = frameView( output->GetFrame( frameNumber ) );
+      if( !writer.IsOpened() &&
+          !writer.Open( fileName, framesPerSecond, frame.size(), false ) )
+        {
+        itkGenericExceptionMacro( << "Cannot open " << fileName );
+        }
+      if( !writer.Write( frame ) )
+        {
+        itkGenericExceptionMacro( << "Cannot write to " << fileName );
+        }
+      }
+    writer.Close();
+  }
+
+private:
+  ReaderType::Pointer                m_Reader;
+  ImageFilterType::Pointer           m_ImageFilter;
+  VideoFilterType::Pointer           m_VideoFilter;
+  CastImageFilterType::Pointer       m_ImageCaster;
+  CastVideoFilterType::Pointer       m_VideoCaster;
+  ThresholdImageFilterType::Pointer  m_ImageThresh;
+  ThresholdVideoFilterType::Pointer  m_VideoThresh;
+  FrameDifferenceFilterType::Pointer m_FrameDifferenceFilter;
+};
+
+int main ( int argc, char **argv )
+{
+  if( argc < 3 )
+    {
+    std::cout << "Usage: " << argv[0]
+              << " input_video output_video [number_of_segments]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::VideoFileWriter< IOVideoType >          WriterType;
+  typedef itk::FrameProviderVideoSource< IOVideoType > SourceType;
+
+  const std::string inputName = argv[1];
+  const std::string outputName = argv[2];
+  const itk::SizeValueType frameOffset = 1;
+
+  // y4m files go through Y4MVideoIO and videos with a seek index through
+  // IndexedOpenCVVideoIO, which both seek exactly
+  itk::ObjectFactoryBase::RegisterFactory( itk::Y4MVideoIOFactory::New() );
+  itk::ObjectFactoryBase::RegisterFactory( itk::IndexedOpenCVVideoIOFactory::New() );
+  itk::ObjectFactoryBase::RegisterFactory( itk::OpenCVVideoIOFactory::New() );
+
+  bridge::ThreadBudget budget;
+  unsigned int numberOfSegments =
+    argc > 3 ? std::max( 1, atoi( argv[3] ) ) : budget.GetTotalThreads();
+  bridge::VideoSeekIndex seekIndex;
+  if( numberOfSegments > 1 &&
+      !bridge::IsY4MStreamName( inputName ) && !seekIndex.Load( inputName ) )
+    {
+    std::cerr << inputName << " has no seek index, processing it as a single"
+              << " segment (see BuildVideoSeekIndex)" << std::endl;
+    numberOfSegments = 1;
+    }
+
+  // Every segment has the threads of one stage of the budget
+  budget.Distribute( numberOfSegments );
+  budget.Apply();
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( budget.GetITKThreads() );
+
+  std::vector< std::unique_ptr< SegmentChain > > chains;
+  itk::SizeValueType inputStart = 0;
+  itk::SizeValueType inputEnd = 0;
+  double framesPerSecond = 0.0;
+  try
+    {
+    for( unsigned int s = 0; s < numberOfSegments; ++s )
+      {
+      chains.push_back( std::unique_ptr< SegmentChain >(
+        new SegmentChain( inputName.c_str(), frameOffset ) ) );
+      // The first segments get the threads left over by the division
+      chains.back()->SetNumberOfThreads( budget.GetITKThreads( s ) );
+      chains.back()->Initialize();
+      }
+    const itk::TemporalRegion inputRegion = chains[0]->GetInputTemporalRegion();
+    inputStart = inputRegion.GetFrameStart();
+    inputEnd = inputStart + inputRegion.GetFrameDuration();
+    framesPerSecond = chains[0]->GetFramesPerSecond();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( inputEnd - inputStart <= frameOffset )
+    {
+    std::cerr << "The video needs more than " << frameOffset << " frames"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Split the output frames, numbered from FrameOffset as for
+  // FrameDifferenceVideoFilter, into contiguous segments
+  const itk::SizeValueType outputStart = inputStart + frameOffset;
+  const itk::SizeValueType numberOfOutputFrames = inputEnd - outputStart;
+  numberOfSegments = static_cast< unsigned int >(
+    std::min< itk::SizeValueType >( numberOfSegments, numberOfOutputFrames ) );
+  std::vector< itk::SizeValueType > boundaries( numberOfSegments + 1 );
+  std::vector< std::string > segmentNames( numberOfSegments );
+  for( unsigned int s = 0; s <= numberOfSegments; ++s )
+    {
+    boundaries[s] = outputStart + numberOfOutputFrames * s / numberOfSegments;
+    }
+  for( unsigned int s = 0; s < numberOfSegments; ++s )
+    {
+    std::ostringstream name;
+    name << outputName << ".segment" << s << ".y4m";
+    segmentNames[s] = name.str();
+    }
+
+  std::vector< std::string > errors( numberOfSegments );
+  std::vector< std::thread > threads;
+  for( unsigned int s = 0; s < numberOfSegments; ++s )
+    {
+    threads.push_back( std::thread( [&, s]()
+      {
+      budget.PinCurrentThread();
+      try
+        {
+        chains[s]->Run( boundaries[s], boundaries[s + 1], segmentNames[s],
+                        framesPerSecond );
+        }
+      catch( itk::ExceptionObject & excp )
+        {
+        errors[s] = excp.what();
+        }
+      } ) );
+    }
+  for( size_t t = 0; t < threads.size(); ++t )
+    {
+    threads[t].join();
+    }
+  chains.clear();
+
+  bool failed = false;
+  for( unsigned int s = 0; s < numberOfSegments; ++s )
+    {
+    if( !errors[s].empty() )
+      {
+      std::cerr << "Segment " << s << ": " << errors[s] << std::endl;
+      failed = true;
+      }
+    }
+
+  // Concatenate the segments through a single writer
+  if( !failed )
+    {
+    size_t segment = 0;
+    std::unique_ptr< bridge::Y4MFrameReader > segmentReader(
+      new bridge::Y4MFrameReader );
+    segmentReader->SetGrayOutput( true );
+    if( !segmentReader->Open( segmentNames[0] ) )
+      {
+      std::cerr << "Cannot read " << segmentNames[0] << std::endl;
+      failed = true;
+      }
+
+    SourceType::Pointer source = SourceType::New();
+    WriterType::Pointer writer = WriterType::New();
+    if( !failed )
+      {
+      const cv::Size frameSize = segmentReader->GetFrameSize();
+      IOFrameType::RegionType frameRegion;
+      frameRegion.SetSize( 0, frameSize.width );
+      frameRegion.SetSize( 1, frameSize.height );
+      source->SetFrameRegion( frameRegion );
+      source->SetStartFrame( outputStart );
+      source->SetNumberOfFrames( numberOfOutputFrames );
+      source->SetFrameProvider( [&]( itk::SizeValueType frameNumber,
+                                     IOFrameType * frame )
+        {
+        while( frameNumber >= boundaries[segment + 1] )
+          {
+          if( ++segment == numberOfSegments ||
+              !segmentReader->Open( segmentNames[segment] ) )
+            {
+            return false;
+            }
+          }
+        cv::Mat view = frameView( frame );
+        return segmentReader->Read( view ) &&
+          view.data == frame->GetBufferPointer();
+        } );
+      writer->SetFileName( outputName );
+      writer->SetFramesPerSecond( framesPerSecond );
+      writer->SetInput( source->GetOutput() );
+      try
+        {
+        writer->Update();
+        }
+      catch( itk::ExceptionObject & excp )
+        {
+        std::cerr << excp << std::endl;
+        failed = true;
+        }
+      catch( std::exception & excp )
+        {
+        std::cerr << excp.what() << std::endl;
+        failed = true;
+        }
+      }
+    segmentReader->Close();
+    }
+
+  for( unsigned int s = 0; s < numberOfSegments; ++s )
+    {
+    std::remove( segmentNames[s].c_str() );
+    }
+  if( failed )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << numberOfOutputFrames << " frames in " << numberOfSegments
+            << " segments" << std::endl;
+  budget.Report( std::cout );
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,248 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <exception>
+#include <iostream>
+#include <cstdlib>
+
+#include <itkThresholdImageFilter.h>
+#include <itkMultiThreader.h>
+
+#include "itkReducedPrecisionCurvatureFlowImageFilter.h"
+#include "CurvatureFlowSettings.h"
+#include "itkIntermediateCastImageFilter.h"
+#include "itkFrameBufferPool.h"
+#include "PooledFrameStages.h"
+#include "FrameLatencyMetrics.h"
+#include "FrameStreamIO.h"
+#include "StagePipeline.h"
+#include "ThreadBudget.h"
+
+// Streaming version of ITKVideoMultiFrameFiltersPipelined. The frames come
+// from and go to a bridge::FrameSource and bridge::FrameSink instead of the
+// ITK video reader and writer, which need to know the number of frames up
+// front. "-" as input or output reads or writes y4m frames on the standard
+// input or output, so the stage can run in a Unix pipe. The reports go to
+// the standard error. BRIDGE_START_FRAME and BRIDGE_NUMBER_OF_FRAMES
+// select a clip of the input. The latencies of the capture, of the stages
+// and of the output are exported while the stage runs (see
+// bridge::FrameLatencyMetrics); SIGUSR1 prints them.
+
+const unsigned int Dimension =                 2;
+typedef unsigned char                          IOPixelType;
+// float, or unsigned short for Q8.8 fixed point intermediate frames at half
+// the memory traffic (see itkIntermediatePixelTraits.h)
+typedef float                                  RealPixelType;
+typedef itk::Image< IOPixelType, Dimension >   IOFrameType;
+typedef itk::Image< RealPixelType, Dimension > RealFrameType;
+typedef itk::FrameBufferPool< IOFrameType >    IOFramePoolType;
+typedef itk::FrameBufferPool< RealFrameType >  RealFramePoolType;
+typedef bridge::LatencyHistogram::ClockType    ClockType;
+
+// A frame travelling through the stages.
+struct FrameToken
+{
+  IOFrameType::Pointer   Frame;
+  RealFrameType::Pointer RealFrame;
+  ClockType::time_point  Captured;
+};
+
+// OpenCV view of the buffer of an 8-bit frame
+cv::Mat frameView( IOFrameType * frame )
+{
+  const IOFrameType::SizeType size = frame->GetBufferedRegion().GetSize();
+  return cv::Mat( static_cast< int >( size[1] ), static_cast< int >( size[0] ),
+                  CV_8UC1, frame->GetBufferPointer() );
+}
+
+int main ( int argc, char **argv )
+{
+  if( argc < 3 )
+    {
+    std::cout << "Usage: " << argv[0]
+              << " input_video output_video [queue_capacity]" << std::endl;
+    std::cout << "Use - for the standard input or output (y4m frames)."
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ReducedPrecisionCurvatureFlowImageFilter< IOFrameType,
+                                                 RealFrameType >
+                                                 ImageFilterType;
+  typedef itk::IntermediateCastImageFilter< RealFrameType, IOFrameType >
+                                                 CastImageFilterType;
+  typedef itk::ThresholdImageFilter< IOFrameType >
+                                                 ThresholdImageFilterType;
+  typedef bridge::StagePipeline< FrameToken >    PipelineType;
+
+  ImageFilterType::Pointer imageFilter = ImageFilterType::New();
+  CastImageFilterType::Pointer imageCaster = CastImageFilterType::New();
+  ThresholdImageFilterType::Pointer imageThresh = ThresholdImageFilterType::New();
+  IOFramePoolType::Pointer ioFramePool = IOFramePoolType::New();
+  RealFramePoolType::Pointer realFramePool = RealFramePoolType::New();
+
+  bridge::FrameSource frameSource;
+  if( !bridge::OpenFrameSource( argv[1], frameSource,
+                                bridge::FrameClip::FromEnvironment() ) )
+    {
+    std::cerr << "Unable to open video file: " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+  bridge::FrameSink frameSink;
+  if( !bridge::OpenFrameSink( argv[2], frameSource.FramesPerSecond,
+                              frameSource.FrameSize, frameSink ) )
+    {
+    std::cerr << "Unable to open output file: " << argv[2] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  IOFrameType::RegionType frameRegion;
+  frameRegion.SetSize( 0, frameSource.FrameSize.width );
+  frameRegion.SetSize( 1, frameSource.FrameSize.height );
+  ioFramePool->SetFrameRegion( frameRegion );
+  realFramePool->SetFrameRegion( frameRegion );
+
+  const itk::SizeValueType frameOffset = 1;
+
+  imageThresh->ThresholdBelow( 128 );
+  imageThresh->InPlaceOff();
+
+  imageFilter->SetTimeStep( 0.5 );
+  // At most 20 iterations, fewer with BRIDGE_CURVATURE_TOLERANCE set
+  bridge::CurvatureFlowSettings::FromEnvironment( 20 ).ApplyTo(
+    imageFilter.GetPointer() );
+  bridge::IterationReport< ImageFilterType > iterations( imageFilter );
+
+  typedef bridge::FrameLatencyMetrics MetricsType;
+  MetricsType metrics( argv[0] );
+  metrics.Start();
+
+  PipelineType pipeline( argc > 3 ? atoi( argv[3] ) : 2 );
+
+  // Stage 0: read, straight into the buffer of a pooled frame
+  pipeline.SetSource( [&]( FrameToken & token )
+    {
+    token.Frame = ioFramePool->Acquire();
+    cv::Mat view = frameView( token.Frame );
+      {
+      bridge::ScopedLatency latency( metrics.GetHistogram( MetricsType::Capture ) );
+      if( !frameSource.Read( view ) )
+        {
+        return false;
+        }
+      }
+    token.Captured = ClockType::now();
+    if( view.data != token.Frame->GetBufferPointer() )
+      {
+      itkGenericExceptionMacro( << "The frames do not have the size of the stream" );
+      }
+    return true;
+    } );
+
+  // Stage 1: CurvatureFlow
+  pipeline.AddStage( [&]( FrameToken & token )
+    {
+    token.RealFrame = bridge::RunPooledFilter(
+      imageFilter.GetPointer(), token.Frame, realFramePool.GetPointer() );
+    token.Frame = NULL;
+    return true;
+    } );
+
+  // Stage 2: cast back to 8 bits
+  pipeline.AddStage( [&]( FrameToken & token )
+    {
+    token.Frame = bridge::RunPooledFilter(
+      imageCaster.GetPointer(), token.RealFrame, ioFramePool.GetPointer() );
+    token.RealFrame = NULL;
+    return true;
+    } );
+
+  // Stage 3: difference with the frame FrameOffset frames earlier, with the
+  // same arithmetic as itk::FrameDifferenceVideoFilter. The first frames
+  // only fill the history and produce no output.
+  bridge::FrameDifferenceStage< IOFrameType > frameDifference( frameOffset,
+                                                               ioFramePool );
+  pipeline.AddStage( [&]( FrameToken & token )
+    {
+    return frameDifference.Process( token.Frame );
+    } );
+
+  // Stage 4: threshold
+  pipeline.AddStage( [&]( FrameToken & token )
+    {
+    token.Frame = bridge::RunPooledFilter(
+      imageThresh.GetPointer(), token.Frame, ioFramePool.GetPointer() );
+    return true;
+    } );
+
+  // The source, the stages and the writer loop run at the same time
+  bridge::ThreadBudget budget;
+  budget.Distribute( static_cast< unsigned int >( pipeline.GetNumberOfThreads() ) + 1 );
+  budget.Apply();
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( budget.GetITKThreads() );
+  // The filters were created with the previous global default: the number
+  // of stages is only known once the stages, which use them, are added.
+  // The threads left over by the division go to the heaviest stages first.
+  imageFilter->SetNumberOfThreads( budget.GetITKThreads( 0 ) );
+  imageThresh->SetNumberOfThreads( budget.GetITKThreads( 1 ) );
+  imageCaster->SetNumberOfThreads( budget.GetITKThreads( 2 ) );
+  budget.PinCurrentThread();
+  pipeline.SetThreadStart( [&budget]( size_t ) { budget.PinCurrentThread(); } );
+
+  try
+    {
+    pipeline.Start();
+    FrameToken token;
+    while( pipeline.Pop( token ) )
+      {
+      // From the end of the capture through all the stages, waits included
+      metrics.GetHistogram( MetricsType::Process ).RecordSince( token.Captured );
+      bridge::ScopedLatency latency( metrics.GetHistogram( MetricsType::Output ) );
+      if( !frameSink.Write( frameView( token.Frame ) ) )
+        {
+        std::cerr << "Unable to write to: " << argv[2] << std::endl;
+        pipeline.Stop();
+        return EXIT_FAILURE;
+        }
+      }
+    pipeline.Stop();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    pipeline.Stop();
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+  catch( std::exception & excp )
+    {
+    pipeline.Stop();
+    std::cerr << excp.what() << std::endl;
+    return EXIT_FAILURE;
+    }
+  frameSink.Close();
+  metrics.Stop();
+
+  std::cerr << "8-bit frame pool: ";
+  ioFramePool->Report( std::cerr );
+  std::cerr << "Real frame pool:  ";
+  realFramePool->Report( std::cerr );
+  budget.Report( std::cerr );
+  iterations.Report( std::cerr );
+  metrics.Report( std::cerr );
+
+  return EXIT_SUCCESS;
+}
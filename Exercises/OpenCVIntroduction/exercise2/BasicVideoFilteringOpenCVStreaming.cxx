@@ -0,0 +1,115 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "FrameStreamIO.h"
+#include "ThreadBudget.h"
+
+// Streaming version of the video exercise. "-" as input or output reads or
+// writes uncompressed y4m frames on the standard input or output, so that
+// the video executables can be chained in a Unix pipe:
+//
+//   BasicVideoFilteringOpenCVStreaming input.avi - | ... | consumer - out.y4m
+//
+// Frames travel as gray levels. Nothing but frames is written to the
+// standard output. The capture thread and the processing loop share the
+// thread budget of ThreadBudget.h.
+//
+// A clip from the middle of a long video is processed with
+//
+//   BRIDGE_START_FRAME=90000 BRIDGE_NUMBER_OF_FRAMES=250 \
+//     BasicVideoFilteringOpenCVStreaming input.avi clip.y4m
+//
+// which seeks instead of decoding the first hour once the seek index of
+// input.avi has been built with the BuildVideoSeekIndex tool.
+
+
+// Process a single gray frame of video
+void processFrame( const cv::Mat& grayImage, cv::Mat& edgeImage )
+{
+  cv::Canny( grayImage, edgeImage, 128, 255 );
+}
+
+
+int main ( int argc, char **argv )
+{
+  if( argc < 3 )
+  {
+    std::cout << "Usage: "<< argv[0] <<" input_video output_video"<<std::endl;
+    std::cout << "Use - for the standard input or output (y4m frames)."
+              << std::endl;
+    return -1;
+  }
+
+  bridge::FrameSource source;
+  if( !bridge::OpenFrameSource( argv[1], source,
+                                bridge::FrameClip::FromEnvironment() ) )
+  {
+    std::cerr << "Unable to open video file: "<< argv[1] << std::endl;
+    return -1;
+  }
+
+  bridge::FrameSink sink;
+  if( !bridge::OpenFrameSink( argv[2], source.FramesPerSecond,
+                              source.FrameSize, sink ) )
+  {
+    std::cerr << "Unable to open output file: "<< argv[2] << std::endl;
+    return -1;
+  }
+
+  bridge::ThreadBudget budget;
+  budget.Distribute( 2 );
+  budget.Apply();
+  budget.PinCurrentThread();
+
+  // Frames are read on their own thread while the previous one is processed
+  bridge::ThreadedFrameCapture capture( 4 );
+  capture.Start( source.Read, [&budget]() { budget.PinCurrentThread(); } );
+
+  try
+  {
+    cv::Mat frame;
+    cv::Mat outputFrame;
+    while( capture.Pop( frame ) )
+    {
+      processFrame( frame, outputFrame );
+      if( !sink.Write( outputFrame ) )
+      {
+        std::cerr << "Unable to write to: "<< argv[2] << std::endl;
+        capture.Stop();
+        return -1;
+      }
+    }
+  }
+  catch( std::exception & excp )
+  {
+    // A truncated input frame ends the capture with an error
+    std::cerr << excp.what() << std::endl;
+    capture.Stop();
+    return -1;
+  }
+  capture.Stop();
+  sink.Close();
+  budget.Report( std::cerr );
+
+  return 0;
+}
@@ -0,0 +1,86 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "JobSocket.h"
+
+// Send jobs to a BridgeJobServer and print its replies, with the round
+// trip time of each job. The jobs are the remaining arguments, one per
+// argument, or the lines of the standard input when there are none:
+//
+//   BridgeJobClient /tmp/bridge.sock "canny in.png out.png variance=4"
+//   ls *.png | sed 's/.*/curvature & thumbs\/&/' | BridgeJobClient /tmp/bridge.sock
+//
+// All the jobs go through one connection, so they run one after the other
+// on the same worker. Run several clients to use several workers.
+
+int main ( int argc, char **argv )
+{
+  if( argc < 2 )
+  {
+    std::cout << "Usage: " << argv[0] << " socket_path [job ...]" << std::endl;
+    std::cout << "Without jobs, reads one job per line on the standard input."
+              << std::endl;
+    return -1;
+  }
+
+  bridge::JobConnection connection( bridge::ConnectToJobSocket( argv[1] ) );
+  if( !connection.IsOpen() )
+  {
+    std::cerr << "Unable to connect to " << argv[1] << std::endl;
+    return -1;
+  }
+
+  std::vector< std::string > jobs( argv + 2, argv + argc );
+  size_t next = 0;
+  int result = 0;
+  std::string job;
+  while( argc > 2 ? next < jobs.size() : static_cast< bool >( std::getline( std::cin, job ) ) )
+  {
+    if( argc > 2 )
+    {
+      job = jobs[next++];
+    }
+    if( job.empty() )
+    {
+      continue;
+    }
+
+    const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    std::string reply;
+    if( !connection.WriteLine( job ) || !connection.ReadLine( reply ) )
+    {
+      std::cerr << "Connection to " << argv[1] << " lost" << std::endl;
+      return -1;
+    }
+    const std::chrono::duration< double > elapsed =
+      std::chrono::steady_clock::now() - start;
+
+    std::cout << job << ": " << reply << " roundtrip=" << elapsed.count()
+              << std::endl;
+    if( reply.compare( 0, 2, "ok" ) != 0 )
+    {
+      result = -1;
+    }
+  }
+  return result;
+}
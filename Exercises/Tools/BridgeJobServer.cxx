@@ -0,0 +1,501 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <itkMultiThreader.h>
+#include <itkThresholdImageFilter.h>
+
+#include "itkReducedPrecisionCurvatureFlowImageFilter.h"
+#include "itkIntermediateCastImageFilter.h"
+#include "BoundedFrameQueue.h"
+#include "CannyFrameProcessor.h"
+#include "CurvatureFlowFrameProcessor.h"
+#include "FrameStreamIO.h"
+#include "JobSocket.h"
+#include "ThreadBudget.h"
+
+// Resident server running the exercise pipelines on request. Starting an
+// exercise executable loads ITK and OpenCV, registers the IO factories and
+// builds the pipeline before touching a pixel, which is most of the run
+// time for a thumbnail or a short clip. The server pays for this once: each
+// worker keeps its own pipelines, with their filters and frame pools, from
+// one job to the next.
+//
+// Clients connect to the Unix socket and send one job per line:
+//
+//   <pipeline> <input> <output> [name=value ...]
+//
+// with the pipelines
+//
+//   canny       edge detection of the bridge video exercise
+//               (variance=6 lower=1 upper=8 recursive=0, see
+//               CannySmoothing.h)
+//   curvature   CurvatureFlow smoothing of the bridge exercise 1
+//               (iterations=20 timestep=0.5)
+//   multiframe  CurvatureFlow -> frame difference -> threshold chain of the
+//               ITKVideoPipeline exercise 2 (iterations=20 tolerance=0
+//               threshold=128), on videos only
+//
+// Images are read and written with cv::imread() and cv::imwrite(), videos
+// as in the streaming exercises; start=N and frames=N select a clip of a
+// video. Each job gets one reply line:
+//
+//   ok frames=<n> process=<s> total=<s> worker=<id>
+//   error <message>
+//
+// where process is the time spent in the filters and total the time from
+// the request to the reply. "ping" is answered with "ok", "shutdown" stops
+// the server once the accepted connections are served. A worker serves one
+// connection at a time, for as many jobs as the client sends on it.
+
+typedef std::chrono::steady_clock ClockType;
+
+const unsigned int Dimension =                 2;
+typedef unsigned char                          IOPixelType;
+typedef float                                  RealPixelType;
+typedef itk::Image< IOPixelType, Dimension >   IOFrameType;
+typedef itk::Image< RealPixelType, Dimension > RealFrameType;
+
+double secondsSince( ClockType::time_point start )
+{
+  const std::chrono::duration< double > elapsed = ClockType::now() - start;
+  return elapsed.count();
+}
+
+// A parsed request line
+struct Job
+{
+  std::string                          Pipeline;
+  std::string                          Input;
+  std::string                          Output;
+  std::map< std::string, std::string > Parameters;
+
+  bool Parse( const std::string & line, std::string & error )
+  {
+    std::istringstream words( line );
+    if( !( words >> Pipeline >> Input >> Output ) )
+    {
+      error = "expected: pipeline input output [name=value ...]";
+      return false;
+    }
+    std::string word;
+    while( words >> word )
+    {
+      const std::string::size_type equal = word.find( '=' );
+      if( equal == std::string::npos || equal == 0 )
+      {
+        error = "bad parameter: " + word;
+        return false;
+      }
+      Parameters[word.substr( 0, equal )] = word.substr( equal + 1 );
+    }
+    return true;
+  }
+
+  double GetParameter( const std::string & name, double defaultValue ) const
+  {
+    std::map< std::string, std::string >::const_iterator it =
+      Parameters.find( name );
+    return it == Parameters.end() ? defaultValue : std::atof( it->second.c_str() );
+  }
+};
+
+// The frame difference and threshold chain of ITKVideoMultiFrameFiltersAnswer2,
+// fed one frame at a time as in ITKVideoMultiFrameFiltersStreaming
+class MultiFrameChain
+{
+public:
+  typedef itk::ReducedPrecisionCurvatureFlowImageFilter< IOFrameType,
+                                                 RealFrameType >
+                                                 ImageFilterType;
+  typedef itk::IntermediateCastImageFilter< RealFrameType, IOFrameType >
+                                                 CastImageFilterType;
+  typedef itk::ThresholdImageFilter< IOFrameType >
+                                                 ThresholdImageFilterType;
+
+  MultiFrameChain()
+  {
+    m_Filter = ImageFilterType::New();
+    m_Caster = CastImageFilterType::New();
+    m_Thresh = ThresholdImageFilterType::New();
+    m_FramePool = bridge::GrayFramePoolType::New();
+
+    m_Filter->SetTimeStep( 0.5 );
+    m_Caster->SetInput( m_Filter->GetOutput() );
+    m_Thresh->InPlaceOff();
+  }
+
+  void Configure( const Job & job )
+  {
+    m_Filter->SetNumberOfIterations(
+      static_cast< unsigned int >( job.GetParameter( "iterations", 20 ) ) );
+    m_Filter->SetMaximumRMSError( job.GetParameter( "tolerance", 0 ) );
+    m_Thresh->ThresholdBelow(
+      static_cast< IOPixelType >( job.GetParameter( "threshold", 128 ) ) );
+    m_Previous = NULL;
+  }
+
+  // Process a frame. Returns false for the first frame, which only fills
+  // the history.
+  bool Process( const cv::Mat & inputImage, cv::Mat & outputImage )
+  {
+    IOFrameType::Pointer itkFrame =
+      bridge::ImportGrayFrame( inputImage, m_FramePool );
+    m_Filter->SetInput( itkFrame );
+    m_Caster->Update();
+    m_Filter->SetInput( NULL );
+
+    IOFrameType::Pointer current = m_Caster->GetOutput();
+    current->DisconnectPipeline();
+    IOFrameType::Pointer previous = m_Previous;
+    m_Previous = current;
+    if( !previous )
+    {
+      return false;
+    }
+
+    // Same arithmetic as itk::FrameDifferenceVideoFilter
+    IOFrameType::Pointer difference = m_FramePool->Acquire();
+    const IOPixelType * previousPixel = previous->GetBufferPointer();
+    const IOPixelType * currentPixel = current->GetBufferPointer();
+    IOPixelType * differencePixel = difference->GetBufferPointer();
+    const size_t numberOfPixels =
+      difference->GetBufferedRegion().GetNumberOfPixels();
+    for( size_t i = 0; i < numberOfPixels; ++i )
+    {
+      double value = static_cast< double >( previousPixel[i] ) -
+                     static_cast< double >( currentPixel[i] );
+      value *= value;
+      differencePixel[i] = static_cast< IOPixelType >( value );
+    }
+    difference->Modified();
+
+    m_Thresh->SetInput( difference );
+    m_Thresh->Update();
+    m_Thresh->SetInput( NULL );
+
+    cv::Mat resultView( inputImage.rows, inputImage.cols, CV_8UC1,
+      const_cast< IOPixelType * >( m_Thresh->GetOutput()->GetBufferPointer() ) );
+    resultView.copyTo( outputImage );
+    return true;
+  }
+
+  void Finish()
+  {
+    m_Previous = NULL;
+  }
+
+private:
+  ImageFilterType::Pointer           m_Filter;
+  CastImageFilterType::Pointer       m_Caster;
+  ThresholdImageFilterType::Pointer  m_Thresh;
+  bridge::GrayFramePoolType::Pointer m_FramePool;
+  IOFrameType::Pointer               m_Previous;
+};
+
+// The pipelines of a worker, built once and reused for every job
+class Worker
+{
+public:
+  explicit Worker( unsigned int id ) : m_Id( id ) {}
+
+  // Run a job, filling the reply line
+  std::string Run( const std::string & line )
+  {
+    const ClockType::time_point start = ClockType::now();
+    Job job;
+    std::string error;
+    if( !job.Parse( line, error ) )
+    {
+      return "error " + error;
+    }
+
+    size_t frames = 0;
+    double processSeconds = 0.0;
+    try
+    {
+      if( !this->RunJob( job, frames, processSeconds, error ) )
+      {
+        return "error " + error;
+      }
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      m_MultiFrame.Finish();
+      return std::string( "error " ) + excp.GetDescription();
+    }
+    catch( cv::Exception & excp )
+    {
+      m_MultiFrame.Finish();
+      return "error " + excp.msg;
+    }
+    // Anything else, e.g. std::bad_alloc on a huge input, must not escape
+    // the worker thread and take the server down with it
+    catch( std::exception & excp )
+    {
+      m_MultiFrame.Finish();
+      return std::string( "error " ) + excp.what();
+    }
+    catch( ... )
+    {
+      m_MultiFrame.Finish();
+      return "error unknown exception";
+    }
+
+    std::ostringstream reply;
+    reply << std::fixed << std::setprecision( 6 )
+          << "ok frames=" << frames << " process=" << processSeconds
+          << " total=" << secondsSince( start ) << " worker=" << m_Id;
+    return reply.str();
+  }
+
+private:
+  bool RunJob( const Job & job, size_t & frames, double & processSeconds,
+               std::string & error )
+  {
+    if( job.Pipeline == "canny" )
+    {
+      m_Canny.SetVariance( job.GetParameter( "variance", 6 ) );
+      m_Canny.SetLowerThreshold( job.GetParameter( "lower", 1 ) );
+      m_Canny.SetUpperThreshold( job.GetParameter( "upper", 8 ) );
+      m_Canny.SetUseRecursiveGaussian( job.GetParameter( "recursive",
+        bridge::UseRecursiveCannySmoothing() ) != 0 );
+    }
+    else if( job.Pipeline == "curvature" )
+    {
+      m_Curvature.SetNumberOfIterations(
+        static_cast< unsigned int >( job.GetParameter( "iterations", 20 ) ) );
+      m_Curvature.SetTimeStep( job.GetParameter( "timestep", 0.5 ) );
+    }
+    else if( job.Pipeline == "multiframe" )
+    {
+      m_MultiFrame.Configure( job );
+    }
+    else
+    {
+      error = "unknown pipeline: " + job.Pipeline;
+      return false;
+    }
+    if( job.Input == "-" || job.Output == "-" )
+    {
+      error = "the server has no standard input or output";
+      return false;
+    }
+
+    // A single image
+    if( !bridge::IsY4MStreamName( job.Input ) )
+    {
+      cv::Mat image = cv::imread( job.Input );
+      if( !image.empty() )
+      {
+        if( job.Pipeline == "multiframe" )
+        {
+          error = "the multiframe pipeline needs a video";
+          return false;
+        }
+        cv::Mat result;
+        const ClockType::time_point start = ClockType::now();
+        this->Process( job, image, result );
+        processSeconds = secondsSince( start );
+        if( !cv::imwrite( job.Output, result ) )
+        {
+          error = "unable to write " + job.Output;
+          return false;
+        }
+        frames = 1;
+        return true;
+      }
+    }
+
+    // A video, or a clip of it
+    bridge::FrameClip clip;
+    clip.StartFrame = static_cast< size_t >( job.GetParameter( "start", 0 ) );
+    clip.NumberOfFrames = static_cast< size_t >( job.GetParameter( "frames", 0 ) );
+    bridge::FrameSource source;
+    if( !bridge::OpenFrameSource( job.Input, source, clip ) )
+    {
+      error = "unable to open " + job.Input;
+      return false;
+    }
+    bridge::FrameSink sink;
+    if( !bridge::OpenFrameSink( job.Output, source.FramesPerSecond,
+                                source.FrameSize, sink ) )
+    {
+      error = "unable to open " + job.Output;
+      return false;
+    }
+    cv::Mat frame;
+    cv::Mat result;
+    while( source.Read( frame ) )
+    {
+      const ClockType::time_point start = ClockType::now();
+      const bool produced = this->Process( job, frame, result );
+      processSeconds += secondsSince( start );
+      if( produced && !sink.Write( result ) )
+      {
+        m_MultiFrame.Finish();
+        error = "unable to write " + job.Output;
+        return false;
+      }
+      ++frames;
+    }
+    sink.Close();
+    m_MultiFrame.Finish();
+    return true;
+  }
+
+  bool Process( const Job & job, const cv::Mat & input, cv::Mat & output )
+  {
+    if( job.Pipeline == "canny" )
+    {
+      m_Canny.Process( input, output );
+      return true;
+    }
+    if( job.Pipeline == "curvature" )
+    {
+      m_Curvature.Process( input, output );
+      return true;
+    }
+    return m_MultiFrame.Process( input, output );
+  }
+
+  unsigned int                        m_Id;
+  bridge::CannyFrameProcessor         m_Canny;
+  bridge::CurvatureFlowFrameProcessor m_Curvature;
+  MultiFrameChain                     m_MultiFrame;
+};
+
+int main ( int argc, char **argv )
+{
+  if( argc < 2 )
+  {
+    std::cout << "Usage: " << argv[0] << " socket_path [workers]" << std::endl;
+    return -1;
+  }
+  const std::string socketPath = argv[1];
+
+  // The workers run at the same time and share the thread budget
+  bridge::ThreadBudget budget;
+  const unsigned int numberOfWorkers = argc > 2 ?
+    std::max( 1, std::atoi( argv[2] ) ) : budget.GetTotalThreads();
+  budget.Distribute( numberOfWorkers );
+  budget.Apply();
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( budget.GetITKThreads() );
+
+  const int listener = bridge::ListenOnJobSocket( socketPath );
+  if( listener < 0 )
+  {
+    std::cerr << "Unable to listen on " << socketPath << std::endl;
+    return -1;
+  }
+
+  bridge::BoundedFrameQueue< int > connections( 4 * numberOfWorkers );
+  std::atomic< bool > stopping( false );
+  std::atomic< size_t > jobs( 0 );
+  std::vector< std::thread > threads;
+  for( unsigned int w = 0; w < numberOfWorkers; ++w )
+  {
+    threads.push_back( std::thread( [&, w]()
+    {
+      budget.PinCurrentThread();
+      Worker worker( w );
+      int descriptor;
+      while( connections.Pop( descriptor ) )
+      {
+        bridge::JobConnection connection( descriptor );
+        std::string line;
+        while( connection.ReadLine( line ) )
+        {
+          std::string reply;
+          if( line.empty() )
+          {
+            continue;
+          }
+          else if( line == "ping" )
+          {
+            reply = "ok";
+          }
+          else if( line == "shutdown" )
+          {
+            reply = "ok";
+            stopping = true;
+            ::shutdown( listener, SHUT_RDWR );
+          }
+          else
+          {
+            reply = worker.Run( line );
+            ++jobs;
+          }
+          if( !connection.WriteLine( reply ) )
+          {
+            break;
+          }
+        }
+      }
+    } ) );
+  }
+
+  std::cout << "Listening on " << socketPath << " with " << numberOfWorkers
+            << " workers" << std::endl;
+  budget.Report( std::cout );
+
+  while( !stopping )
+  {
+    const int descriptor = ::accept( listener, NULL, NULL );
+    if( descriptor < 0 )
+    {
+      if( errno == EINTR || errno == ECONNABORTED )
+      {
+        continue;
+      }
+      break;
+    }
+    if( !connections.Push( descriptor ) )
+    {
+      ::close( descriptor );
+    }
+  }
+
+  connections.Close();
+  for( size_t w = 0; w < threads.size(); ++w )
+  {
+    threads[w].join();
+  }
+  ::close( listener );
+  ::unlink( socketPath.c_str() );
+
+  std::cout << jobs << " jobs served" << std::endl;
+  return stopping ? 0 : -1;
+}
@@ -0,0 +1,83 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "FrameStreamIO.h"
+#include "VideoSeekIndex.h"
+
+// Build the seek index of videos, stored next to each of them as
+// "<video>.seek" (see VideoSeekIndex.h). It is built once per file: y4m
+// files are indexed from their frame headers, other videos are decoded
+// once and their seeks checked every key_frame_interval frames. The readers
+// of the exercises then position themselves on any frame without decoding
+// the video from its start. A video that is modified needs a new index.
+
+int main ( int argc, char **argv )
+{
+  if( argc < 2 )
+  {
+    std::cout << "Usage: " << argv[0]
+              << " video [video ...] [--interval key_frame_interval]"
+              << std::endl;
+    return -1;
+  }
+
+  size_t keyFrameInterval = 250;
+  int result = 0;
+  for( int i = 1; i < argc; ++i )
+  {
+    const std::string video = argv[i];
+    if( video == "--interval" && i + 1 < argc )
+    {
+      keyFrameInterval = static_cast< size_t >( std::atoi( argv[++i] ) );
+      if( keyFrameInterval == 0 )
+      {
+        keyFrameInterval = 1;
+      }
+      continue;
+    }
+
+    const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    bridge::VideoSeekIndex index;
+    if( !bridge::BuildVideoSeekIndex( video, index, keyFrameInterval ) )
+    {
+      std::cerr << "Unable to index " << video << std::endl;
+      result = -1;
+      continue;
+    }
+    if( !index.Save( video ) )
+    {
+      std::cerr << "Unable to write "
+                << bridge::VideoSeekIndex::GetIndexFileName( video ) << std::endl;
+      result = -1;
+      continue;
+    }
+    const std::chrono::duration< double > elapsed =
+      std::chrono::steady_clock::now() - start;
+
+    std::cout << video << ": " << index.GetNumberOfFrames() << " frames, "
+              << index.GetNumberOfKeyFrames() << " key frames"
+              << ( index.HasOffsets() ? ", byte offsets" : "" )
+              << ", indexed in " << elapsed.count() << " s" << std::endl;
+  }
+  return result;
+}
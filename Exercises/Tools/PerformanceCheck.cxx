@@ -0,0 +1,363 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Run every exercise pipeline listed in a pipelines file on the synthetic
+// data, and compare the checksum of its output and its run time with the
+// stored baselines.
+//
+// A pipelines line reads
+//
+//   name input output_extension executable [arguments...]
+//
+// and runs "executable input work_dir/name.output_extension arguments".
+// The input may be {image}, {video} or {y4m}, the synthetic files of the
+// work directory. A baselines line reads
+//
+//   name checksum seconds
+//
+// A pipeline fails when it has no baseline, when its checksum differs from
+// the baseline or when its best run time exceeds the baseline by more than
+// the tolerance (a fraction of the baseline plus a fixed slack, so that the
+// start-up time of very short runs does not make the check flaky). With
+// --only the named pipeline alone runs, which is how CTest runs one test
+// per pipeline. With --update the results are merged into the baselines
+// file, keeping the baselines of the pipelines that did not run.
+
+typedef std::chrono::steady_clock ClockType;
+
+struct Pipeline
+{
+  std::string                Name;
+  std::string                Input;
+  std::string                OutputExtension;
+  std::string                Executable;
+  std::vector< std::string > Arguments;
+};
+
+struct Baseline
+{
+  std::string Checksum;
+  double      Seconds;
+};
+
+std::string quote( const std::string& argument )
+{
+  return "\"" + argument + "\"";
+}
+
+// FNV-1a over the bytes of a file
+bool checksumFile( const std::string& filename, std::string& checksum )
+{
+  std::ifstream file( filename.c_str(), std::ios::binary );
+  if( !file )
+  {
+    return false;
+  }
+  uint64_t hash = 14695981039346656037ULL;
+  char buffer[65536];
+  while( file.read( buffer, sizeof( buffer ) ) || file.gcount() > 0 )
+  {
+    for( std::streamsize i = 0; i < file.gcount(); ++i )
+    {
+      hash ^= static_cast< unsigned char >( buffer[i] );
+      hash *= 1099511628211ULL;
+    }
+  }
+  std::ostringstream text;
+  text << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash;
+  checksum = text.str();
+  return true;
+}
+
+bool readPipelines( const std::string& filename, std::vector< Pipeline >& pipelines )
+{
+  std::ifstream file( filename.c_str() );
+  if( !file )
+  {
+    std::cerr << "Unable to open pipelines file: " << filename << std::endl;
+    return false;
+  }
+  std::string line;
+  while( std::getline( file, line ) )
+  {
+    line = line.substr( 0, line.find( '#' ) );
+    std::istringstream fields( line );
+    Pipeline pipeline;
+    if( !( fields >> pipeline.Name ) )
+    {
+      continue;
+    }
+    if( !( fields >> pipeline.Input >> pipeline.OutputExtension
+                  >> pipeline.Executable ) )
+    {
+      std::cerr << "Incomplete pipeline: " << pipeline.Name << std::endl;
+      return false;
+    }
+    std::string argument;
+    while( fields >> argument )
+    {
+      pipeline.Arguments.push_back( argument );
+    }
+    pipelines.push_back( pipeline );
+  }
+  return true;
+}
+
+void readBaselines( const std::string& filename,
+                    std::map< std::string, Baseline >& baselines )
+{
+  std::ifstream file( filename.c_str() );
+  std::string line;
+  while( std::getline( file, line ) )
+  {
+    line = line.substr( 0, line.find( '#' ) );
+    std::istringstream fields( line );
+    std::string name;
+    Baseline baseline;
+    if( fields >> name >> baseline.Checksum >> baseline.Seconds )
+    {
+      baselines[name] = baseline;
+    }
+  }
+}
+
+std::string resolveInput( const std::string& input, const std::string& workDirectory )
+{
+  if( input == "{image}" )
+  {
+    return workDirectory + "/synthetic.png";
+  }
+  if( input == "{video}" )
+  {
+    return workDirectory + "/synthetic.avi";
+  }
+  if( input == "{y4m}" )
+  {
+    return workDirectory + "/synthetic.y4m";
+  }
+  return input;
+}
+
+int main ( int argc, char **argv )
+{
+  if( argc < 4 )
+  {
+    std::cout << "Usage: " << argv[0]
+              << " pipelines_file baselines_file work_dir"
+              << " [--update] [--tolerance fraction] [--slack seconds]"
+              << " [--repeat count] [--only name]"
+              << std::endl;
+    return -1;
+  }
+
+  const std::string pipelinesFile = argv[1];
+  const std::string baselinesFile = argv[2];
+  const std::string workDirectory = argv[3];
+  bool update = false;
+  double tolerance = 0.25;
+  double slack = 0.05;
+  unsigned int repeat = 3;
+  std::string only;
+  for( int i = 4; i < argc; ++i )
+  {
+    const std::string option = argv[i];
+    if( option == "--update" )
+    {
+      update = true;
+    }
+    else if( option == "--tolerance" && i + 1 < argc )
+    {
+      tolerance = std::atof( argv[++i] );
+    }
+    else if( option == "--slack" && i + 1 < argc )
+    {
+      slack = std::atof( argv[++i] );
+    }
+    else if( option == "--repeat" && i + 1 < argc )
+    {
+      repeat = std::max( 1, std::atoi( argv[++i] ) );
+    }
+    else if( option == "--only" && i + 1 < argc )
+    {
+      only = argv[++i];
+    }
+    else
+    {
+      std::cerr << "Unknown option: " << option << std::endl;
+      return -1;
+    }
+  }
+
+  std::vector< Pipeline > pipelines;
+  if( !readPipelines( pipelinesFile, pipelines ) )
+  {
+    return -1;
+  }
+  if( !only.empty() )
+  {
+    std::vector< Pipeline > selected;
+    for( size_t p = 0; p < pipelines.size(); ++p )
+    {
+      if( pipelines[p].Name == only )
+      {
+        selected.push_back( pipelines[p] );
+      }
+    }
+    if( selected.empty() )
+    {
+      std::cerr << "Unknown pipeline: " << only << std::endl;
+      return -1;
+    }
+    pipelines.swap( selected );
+  }
+  std::map< std::string, Baseline > baselines;
+  readBaselines( baselinesFile, baselines );
+
+  std::cout << std::left << std::setw( 28 ) << "pipeline"
+            << std::setw( 18 ) << "checksum"
+            << std::right << std::setw( 10 ) << "seconds"
+            << std::setw( 11 ) << "baseline" << "  result" << std::endl;
+
+  std::map< std::string, Baseline > results;
+  unsigned int failures = 0;
+  for( size_t p = 0; p < pipelines.size(); ++p )
+  {
+    const Pipeline& pipeline = pipelines[p];
+    const std::string output =
+      workDirectory + "/" + pipeline.Name + "." + pipeline.OutputExtension;
+    const std::string log = workDirectory + "/" + pipeline.Name + ".log";
+
+    std::string command = quote( pipeline.Executable ) + " " +
+      quote( resolveInput( pipeline.Input, workDirectory ) ) + " " +
+      quote( output );
+    for( size_t a = 0; a < pipeline.Arguments.size(); ++a )
+    {
+      command += " " + quote( pipeline.Arguments[a] );
+    }
+    command += " > " + quote( log ) + " 2>&1";
+
+    // Best of several runs, to keep the noise of the machine out
+    double bestSeconds = 0.0;
+    bool ran = true;
+    for( unsigned int r = 0; r < repeat && ran; ++r )
+    {
+      ClockType::time_point start = ClockType::now();
+      ran = ( std::system( command.c_str() ) == 0 );
+      std::chrono::duration< double > seconds = ClockType::now() - start;
+      if( r == 0 || seconds.count() < bestSeconds )
+      {
+        bestSeconds = seconds.count();
+      }
+    }
+
+    Baseline result;
+    result.Seconds = bestSeconds;
+    std::string status;
+    if( !ran )
+    {
+      status = "FAILED to run, see " + log;
+    }
+    else if( !checksumFile( output, result.Checksum ) )
+    {
+      status = "FAILED, no output";
+    }
+    else
+    {
+      results[pipeline.Name] = result;
+    }
+
+    std::map< std::string, Baseline >::const_iterator baseline =
+      baselines.find( pipeline.Name );
+    if( status.empty() )
+    {
+      if( baseline == baselines.end() )
+      {
+        status = "FAILED, no baseline";
+      }
+      else if( baseline->second.Checksum != result.Checksum )
+      {
+        status = "FAILED, output changed";
+      }
+      else if( bestSeconds >
+               baseline->second.Seconds * ( 1.0 + tolerance ) + slack )
+      {
+        status = "FAILED, slower";
+      }
+      else
+      {
+        status = "ok";
+      }
+    }
+    if( status.compare( 0, 6, "FAILED" ) == 0 && !update )
+    {
+      ++failures;
+    }
+
+    std::cout << std::left << std::setw( 28 ) << pipeline.Name
+              << std::setw( 18 ) << ( result.Checksum.empty() ? "-" : result.Checksum )
+              << std::right << std::fixed << std::setprecision( 3 )
+              << std::setw( 10 ) << bestSeconds
+              << std::setw( 11 );
+    if( baseline != baselines.end() )
+    {
+      std::cout << baseline->second.Seconds;
+    }
+    else
+    {
+      std::cout << "-";
+    }
+    std::cout << "  " << status << std::endl;
+  }
+
+  if( update )
+  {
+    for( std::map< std::string, Baseline >::const_iterator it = results.begin();
+         it != results.end(); ++it )
+    {
+      baselines[it->first] = it->second;
+    }
+    std::ofstream file( baselinesFile.c_str() );
+    file << "# Written by PerformanceCheck --update: name checksum seconds\n";
+    for( std::map< std::string, Baseline >::const_iterator it = baselines.begin();
+         it != baselines.end(); ++it )
+    {
+      file << it->first << " " << it->second.Checksum << " "
+           << std::fixed << std::setprecision( 3 ) << it->second.Seconds << "\n";
+    }
+    std::cout << "Baselines written to " << baselinesFile << std::endl;
+    return 0;
+  }
+
+  if( failures > 0 )
+  {
+    std::cout << failures << " pipeline(s) failed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
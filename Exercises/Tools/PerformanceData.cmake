@@ -0,0 +1,15 @@
+#
+# Generate the synthetic data of the performance tests:
+#
+#   cmake -DGENERATOR=<SyntheticVideoGenerator> -DDATA_DIR=<dir> -P PerformanceData.cmake
+#
+file(MAKE_DIRECTORY ${DATA_DIR})
+foreach(data "synthetic.png;640;480" "synthetic.avi;320;240;50" "synthetic.y4m;320;240;50")
+  list(GET data 0 name)
+  list(REMOVE_AT data 0)
+  execute_process(COMMAND ${GENERATOR} ${DATA_DIR}/${name} ${data}
+    RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Unable to generate ${DATA_DIR}/${name}")
+  endif()
+endforeach()
@@ -0,0 +1,230 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include "FrameStreamIO.h"
+
+// Generate deterministic test images and videos: a few shapes moving over a
+// gradient, with Gaussian noise. The same arguments always give the same
+// pixels, so that the outputs of the exercises can be compared between
+// runs. cv::RNG is used for all the random numbers since it produces the
+// same sequence on every platform.
+
+struct Shape
+{
+  bool        IsCircle;
+  cv::Scalar  Color;
+  cv::Point2d Position;
+  cv::Point2d Velocity;
+  int         Size;
+};
+
+std::vector< Shape > createShapes( cv::RNG& rng, cv::Size frameSize,
+                                   unsigned int numberOfShapes )
+{
+  std::vector< Shape > shapes( numberOfShapes );
+  const int minimumSide = std::min( frameSize.width, frameSize.height );
+  for( unsigned int i = 0; i < numberOfShapes; ++i )
+  {
+    Shape& shape = shapes[i];
+    shape.IsCircle = ( i % 2 == 0 );
+    shape.Color = cv::Scalar( rng.uniform( 0, 256 ), rng.uniform( 0, 256 ),
+                              rng.uniform( 0, 256 ) );
+    shape.Size = std::max( 2, rng.uniform( minimumSide / 16, minimumSide / 5 + 1 ) );
+    shape.Position = cv::Point2d( rng.uniform( 0.0, double( frameSize.width ) ),
+                                  rng.uniform( 0.0, double( frameSize.height ) ) );
+    shape.Velocity = cv::Point2d( rng.uniform( -4.0, 4.0 ),
+                                  rng.uniform( -4.0, 4.0 ) );
+  }
+  return shapes;
+}
+
+// Move a shape by one frame, bouncing on the borders
+void moveShape( Shape& shape, cv::Size frameSize )
+{
+  shape.Position += shape.Velocity;
+  if( shape.Position.x < 0 || shape.Position.x >= frameSize.width )
+  {
+    shape.Velocity.x = -shape.Velocity.x;
+    shape.Position.x = std::min( std::max( shape.Position.x, 0.0 ),
+                                 frameSize.width - 1.0 );
+  }
+  if( shape.Position.y < 0 || shape.Position.y >= frameSize.height )
+  {
+    shape.Velocity.y = -shape.Velocity.y;
+    shape.Position.y = std::min( std::max( shape.Position.y, 0.0 ),
+                                 frameSize.height - 1.0 );
+  }
+}
+
+void renderFrame( const cv::Mat& background, const std::vector< Shape >& shapes,
+                  unsigned int seed, unsigned int frameNumber, double noiseSigma,
+                  cv::Mat& frame )
+{
+  background.copyTo( frame );
+  for( size_t i = 0; i < shapes.size(); ++i )
+  {
+    const Shape& shape = shapes[i];
+    cv::Point center( cvRound( shape.Position.x ), cvRound( shape.Position.y ) );
+    if( shape.IsCircle )
+    {
+      cv::circle( frame, center, shape.Size, shape.Color, -1, 8 );
+    }
+    else
+    {
+      cv::Point corner( shape.Size, shape.Size );
+      cv::rectangle( frame, center - corner, center + corner, shape.Color, -1, 8 );
+    }
+  }
+
+  if( noiseSigma > 0 )
+  {
+    // One noise sequence per frame, so that any frame can be regenerated
+    cv::RNG noiseRng( static_cast< uint64 >( seed ) * 1000003 + frameNumber );
+    cv::Mat noise( frame.size(), CV_16SC3 );
+    noiseRng.fill( noise, cv::RNG::NORMAL, cv::Scalar::all( 0 ),
+                   cv::Scalar::all( noiseSigma ) );
+    cv::Mat noisy;
+    frame.convertTo( noisy, CV_16SC3 );
+    noisy += noise;
+    noisy.convertTo( frame, CV_8UC3 );
+  }
+}
+
+cv::Mat createBackground( cv::Size frameSize )
+{
+  cv::Mat background( frameSize, CV_8UC3 );
+  for( int y = 0; y < frameSize.height; ++y )
+  {
+    for( int x = 0; x < frameSize.width; ++x )
+    {
+      background.at< cv::Vec3b >( y, x ) = cv::Vec3b(
+        static_cast< uchar >( 64 + 128 * x / frameSize.width ),
+        static_cast< uchar >( 64 + 128 * y / frameSize.height ),
+        96 );
+    }
+  }
+  return background;
+}
+
+bool isImageFileName( const std::string& name )
+{
+  const char* extensions[] = { ".png", ".jpg", ".bmp", ".tif", ".pgm", ".ppm" };
+  for( unsigned int i = 0; i < 6; ++i )
+  {
+    const std::string extension = extensions[i];
+    if( name.size() > extension.size() &&
+        name.compare( name.size() - extension.size(), extension.size(),
+                      extension ) == 0 )
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+int main ( int argc, char **argv )
+{
+  if( argc < 4 )
+  {
+    std::cout << "Usage: " << argv[0]
+              << " output width height [frames] [seed] [noise_sigma] [fps]"
+              << std::endl;
+    std::cout << "An image file name writes a single frame; .y4m or - writes "
+              << "raw frames; any other name is encoded by OpenCV."
+              << std::endl;
+    return -1;
+  }
+
+  const std::string output = argv[1];
+  const cv::Size frameSize( std::atoi( argv[2] ), std::atoi( argv[3] ) );
+  const unsigned int numberOfFrames = argc > 4 ? std::atoi( argv[4] ) : 1;
+  const unsigned int seed = argc > 5 ? std::atoi( argv[5] ) : 1;
+  const double noiseSigma = argc > 6 ? std::atof( argv[6] ) : 8.0;
+  const double frameRate = argc > 7 ? std::atof( argv[7] ) : 25.0;
+  if( frameSize.width <= 0 || frameSize.height <= 0 || numberOfFrames == 0 )
+  {
+    std::cerr << "Invalid frame size or number of frames" << std::endl;
+    return -1;
+  }
+
+  cv::RNG rng( seed );
+  std::vector< Shape > shapes = createShapes( rng, frameSize, 6 );
+  const cv::Mat background = createBackground( frameSize );
+  cv::Mat frame;
+
+  if( isImageFileName( output ) )
+  {
+    renderFrame( background, shapes, seed, 0, noiseSigma, frame );
+    if( !cv::imwrite( output, frame ) )
+    {
+      std::cerr << "Unable to write image: " << output << std::endl;
+      return -1;
+    }
+    return 0;
+  }
+
+  bridge::Y4MFrameWriter y4mWriter;
+  cv::VideoWriter videoWriter;
+  const bool rawOutput = bridge::IsY4MStreamName( output );
+  if( rawOutput )
+  {
+    y4mWriter.Open( output, frameRate, frameSize, true );
+  }
+  else
+  {
+    videoWriter.open( output, CV_FOURCC('D','I','V','X'), frameRate, frameSize );
+  }
+  if( !( rawOutput ? y4mWriter.IsOpened() : videoWriter.isOpened() ) )
+  {
+    std::cerr << "Unable to open output file: " << output << std::endl;
+    return -1;
+  }
+
+  for( unsigned int i = 0; i < numberOfFrames; ++i )
+  {
+    renderFrame( background, shapes, seed, i, noiseSigma, frame );
+    if( rawOutput )
+    {
+      if( !y4mWriter.Write( frame ) )
+      {
+        std::cerr << "Unable to write to: " << output << std::endl;
+        return -1;
+      }
+    }
+    else
+    {
+      videoWriter << frame;
+    }
+    for( size_t s = 0; s < shapes.size(); ++s )
+    {
+      moveShape( shapes[s], frameSize );
+    }
+  }
+  y4mWriter.Close();
+
+  return 0;
+}